@@ -6,3 +6,4 @@ LD      = $(CROSS_PREFIX)gcc
 STRIP   = $(CROSS_PREFIX)strip
 AR      = $(CROSS_PREFIX)ar
 OBJCOPY = $(CROSS_PREFIX)objcopy
+HOSTCC  = gcc
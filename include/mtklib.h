@@ -22,6 +22,31 @@
 #define EVENT_TYPE_RELEASE      4
 #define EVENT_TYPE_USER_BASE    1000
 
+/*
+ * Event types of widgets that can be bound via mtk_bind_event
+ */
+#define MTK_BIND_PRESS          0
+#define MTK_BIND_RELEASE        1
+#define MTK_BIND_MOTION         2
+#define MTK_BIND_ENTER          3
+#define MTK_BIND_LEAVE          4
+#define MTK_BIND_KEYREPEAT      5
+#define MTK_BIND_CLICK          6
+#define MTK_BIND_CLACK          7
+#define MTK_BIND_COMMIT         8
+#define MTK_BIND_CHANGE         9
+#define MTK_BIND_SLIDE         10
+#define MTK_BIND_SLID          11
+#define MTK_BIND_RESIZE        12   /* Frame  */
+#define MTK_BIND_RESIZED       13   /* Window */
+#define MTK_BIND_MOVE          14
+#define MTK_BIND_MOVED         15
+#define MTK_BIND_CLOSE         16
+#define MTK_BIND_TOP           17
+#define MTK_BIND_SELCHANGE     18
+#define MTK_BIND_SELCOMMIT     19
+#define MTK_BIND_NUM_TYPES     20
+
 typedef struct command_event {
 	int type;                      /* must be EVENT_TYPE_COMMAND */
 	char *cmd;                     /* command string */
@@ -154,12 +179,29 @@ extern int mtk_reqf(int app_id, char *dst, int dst_size, const char *cmdf, ...);
  *
  * \param app_id      MTK application id
  * \param var         widget to bind an event to
- * \param event_type  identifier for the event type
+ * \param event_type  identifier for the event type, e.g., "press"
  * \param callback    callback function to be called for incoming events
  * \param arg         additional argument for the callback function
+ * \return            0 on success or -1 if there is no such widget or
+ *                    event type
+ */
+extern int mtk_bind(int app_id,const char *var, const char *event_type,
+                    void (*callback)(mtk_event *,void *),void *arg);
+
+
+/**
+ * Bind a callback function to an event type of a mtk widget
+ *
+ * Each widget holds one callback per event type. Passing NULL as
+ * callback removes the binding.
+ *
+ * \param event   event type (MTK_BIND_*)
+ * \param filter  key/button code that press, release and keyrepeat
+ *                events must carry or 0 to receive all of them
+ * \return        0 on success or -1 if there is no such widget or event type
  */
-extern void mtk_bind(int app_id,const char *var, const char *event_type,
-                      void (*callback)(mtk_event *,void *),void *arg);
+extern int mtk_bind_event(int app_id, const char *var, int event,
+                          void (*callback)(mtk_event *,void *), void *arg, int filter);
 
 
 /**
@@ -171,13 +213,189 @@ extern void mtk_bind(int app_id,const char *var, const char *event_type,
  * \param callback    callback function to be called for incoming events
  * \param arg         additional argument for the callback function
  * \param ...         format string arguments
+ * \return            0 on success or -1 if there is no such widget or
+ *                    event type
  */
-extern void mtk_bindf(int id, const char *varfmt, const char *event_type,
-                       void (*callback)(mtk_event *,void *), void *arg,...);
+extern int mtk_bindf(int id, const char *varfmt, const char *event_type,
+                     void (*callback)(mtk_event *,void *), void *arg,...);
 
 
 extern void mtk_input(mtk_event *e, int count);
 
+/**
+ * Request time until mtk_input must be called again
+ *
+ * The host event loop can sleep until this deadline or until new
+ * input arrives instead of polling.
+ *
+ * \return  microseconds until the next timer tick, 0 if redraws or
+ *          stream frames are pending, or -1 if there is nothing to do
+ *          without input
+ */
+extern int mtk_next_deadline(void);
+
+struct mtk_stream;
+
+/**
+ * Create stream of frames for a Pixmap widget
+ *
+ * A stream cycles through three frame buffers of the size and format
+ * of the pixmap. It is attached to the widget via mtk_pixmap_stream.
+ * The widget displays the latest published frame at its next redraw
+ * and drops frames that were superseded before being displayed.
+ * Detach the stream before destroying it.
+ *
+ * \return  stream or NULL on error
+ */
+extern struct mtk_stream *mtk_stream_create(void *buf0, void *buf1, void *buf2);
+extern void mtk_stream_destroy(struct mtk_stream *s);
+
+/**
+ * Request buffer to render the next frame into
+ *
+ * This function and mtk_stream_publish may be called from another
+ * thread than the one that runs MTK. They do not block. Repeated calls
+ * return the same buffer until it is published.
+ */
+extern void *mtk_stream_acquire(struct mtk_stream *s);
+
+/**
+ * Hand over the acquired buffer as latest frame
+ *
+ * If MTK sleeps until mtk_next_deadline, the host should wake it up.
+ */
+extern void mtk_stream_publish(struct mtk_stream *s);
+
+/**
+ * Request number of produced, displayed and dropped frames
+ */
+extern void mtk_stream_stats(struct mtk_stream *s, unsigned int *produced,
+                             unsigned int *displayed, unsigned int *dropped);
+
+/**
+ * Attach stream to a Pixmap widget
+ *
+ * \param var  name of the pixmap
+ * \param s    stream or NULL to detach the current stream
+ * \return     0 on success or -1 if there is no such pixmap
+ */
+extern int mtk_pixmap_stream(int app_id, const char *var, struct mtk_stream *s);
+
+/**
+ * Provide the cell text of a Table widget via callback
+ *
+ * The callback is called for each visible cell when the table is drawn
+ * and must write the zero-terminated text of the cell to dst. After the
+ * data changed, the table can be redrawn via its 'refresh' method.
+ *
+ * \param app_id    MTK application id
+ * \param var       table widget
+ * \param callback  function that provides the cell text or NULL
+ * \param arg       additional argument for the callback function
+ * \return          0 on success or -1 if there is no such table
+ */
+extern int mtk_table_source(int app_id, const char *var,
+                            void (*callback)(int row, int column, char *dst, int dst_size, void *arg),
+                            void *arg);
+
+/**
+ * Register font from tff data
+ *
+ * The font data is used in place and is not copied, e.g., it may
+ * be a memory-mapped tff file or a buffer in read-only data. It must
+ * stay valid while MTK is running. Widgets select the font via their
+ * 'font' attribute using the specified name.
+ *
+ * \param name  font name
+ * \param tff   tff font data
+ * \param size  size of font data in bytes
+ * \return      font id or -1 on error
+ */
+extern int mtk_register_font(const char *name, const void *tff, unsigned int size);
+
+
+/**
+ * Load font from tff file
+ *
+ * \param name  font name
+ * \param path  file name of the tff file
+ * \return      font id or -1 on error
+ */
+extern int mtk_load_font(const char *name, const char *path);
+
+
+/**
+ * Register font from utff data
+ *
+ * Utff fonts may contain any set of Unicode characters and are
+ * generated by the ttf2utff tool. Like for mtk_register_font, the
+ * font data is used in place. Utff files can also be loaded via
+ * mtk_load_font.
+ *
+ * \return  font id or -1 on error
+ */
+extern int mtk_register_utff_font(const char *name, const void *utff, unsigned int size);
+
+
+/**
+ * Request hit rate of the glyph atlases in percent
+ *
+ * \return  hit rate or -1 if no glyph was requested yet
+ */
+extern int mtk_get_glyph_hit_rate(void);
+
+
+/**
+ * Request number of layout passes of parent widgets
+ *
+ * \param passes   number of performed layout passes
+ * \param avoided  number of passes that were skipped because the
+ *                 min/max size of the child did not change
+ */
+extern void mtk_get_layout_stats(int *passes, int *avoided);
+
+
+/**
+ * Request hit rate of the hit-test cache of the screen in percent
+ *
+ * \return  hit rate or -1 if no widget was looked up yet
+ */
+extern int mtk_get_find_hit_rate(void);
+
+
+/**
+ * Request boot-to-first-frame time
+ *
+ * \return  microseconds from the start of mtk_init until the first
+ *          frame was completely drawn, or -1 if this did not happen yet
+ */
+extern int mtk_get_boot_time(void);
+
+
+/**
+ * Request occupancy of an object pool
+ *
+ * Widgets, hash table entries, bindings and short strings are
+ * allocated from pools of equally-sized objects.
+ *
+ * \param index   number of the pool, starting at 0
+ * \param used    number of allocated objects
+ * \param avail   number of free objects kept by the pool
+ * \param chunks  number of blocks requested from the system heap
+ * \return        0 on success or -1 if there is no such pool
+ */
+extern int mtk_get_pool_stats(int index, const char **name, int *obj_size,
+                              int *used, int *avail, int *chunks);
+
+
+/**
+ * Return unused memory of the object pools to the system heap
+ *
+ * \return  number of released bytes
+ */
+extern int mtk_release_memory(void);
+
+
 /**
  * Request key or button state
  *
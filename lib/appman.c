@@ -21,7 +21,6 @@
 #include "screen.h"
 #include "scope.h"
 
-#define MAX_APPS          64    /* maximum amount of MTK clients          */
 #define APP_NAMELEN       64    /* application identifier string length    */
 
 static struct hashtab_services *hashtab;
@@ -16,6 +16,8 @@
 #include "hashtab.h"
 #include "scope.h"
 
+#define MAX_APPS          64    /* maximum amount of MTK clients          */
+
 struct appman_services {
 	s32      (*reg_app)          (const char *app_name);
 	s32      (*unreg_app)        (u32 app_id);
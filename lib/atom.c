@@ -0,0 +1,174 @@
+/*
+ * \brief   MTK atom module
+ *
+ * This module interns identifier strings such as
+ * widget type, method, attribute and variable names.
+ * After interning, identifiers can be compared by
+ * their pointers instead of their characters.
+ */
+
+/*
+ * Copyright (C) 2010 Sebastien Bourdeauducq
+ *
+ * This file is part of the MTK package, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include "mtkstd.h"
+#include "atom.h"
+
+#define ATOM_TAB_INIT_SIZE 256   /* initial number of hash buckets */
+
+struct atom;
+struct atom {
+	struct atom *next;   /* next atom in hash bucket */
+	u32          hash;   /* hash value of the string */
+	int          len;    /* length of the string     */
+	char         str[1]; /* null-terminated string   */
+};
+
+static struct atom **tab;
+static u32 tab_size;
+static u32 num_atoms;
+
+int init_atom(struct mtk_services *d);
+
+
+/********************************
+ ** Functions for internal use **
+ ********************************/
+
+/**
+ * Determine length of a string that is bounded by max_len
+ */
+static int bounded_strlen(const char *str, int max_len)
+{
+	int len = 0;
+	while ((len < max_len) && str[len]) len++;
+	return len;
+}
+
+
+/**
+ * Calculate hash value over all characters of a string
+ */
+static u32 hash_value(const char *str, int len)
+{
+	u32 result = 2166136261u;
+	while (len-- > 0) {
+		result ^= (u8)*(str++);
+		result *= 16777619;
+	}
+	return result;
+}
+
+
+/**
+ * Find atom with the specified string and hash value
+ */
+static struct atom *find_atom(const char *str, int len, u32 hash)
+{
+	struct atom *a;
+
+	for (a = tab[hash & (tab_size - 1)]; a; a = a->next)
+		if ((a->hash == hash) && (a->len == len) && !memcmp(a->str, str, len))
+			return a;
+	return NULL;
+}
+
+
+/**
+ * Double the number of hash buckets
+ *
+ * Atoms are never removed. Hence, the hash table only needs to grow.
+ */
+static void grow_tab(void)
+{
+	u32 i, new_size = tab_size*2;
+	struct atom **new_tab, *a, *next;
+
+	new_tab = zalloc(sizeof(struct atom *)*new_size);
+	if (!new_tab) return;
+
+	for (i = 0; i < tab_size; i++) {
+		for (a = tab[i]; a; a = next) {
+			next = a->next;
+			a->next = new_tab[a->hash & (new_size - 1)];
+			new_tab[a->hash & (new_size - 1)] = a;
+		}
+	}
+	free(tab);
+	tab      = new_tab;
+	tab_size = new_size;
+}
+
+
+/***********************
+ ** Service functions **
+ ***********************/
+
+static char *atom_lookup(const char *str, int len)
+{
+	struct atom *a;
+
+	if (!str) return NULL;
+	len = bounded_strlen(str, len);
+	a = find_atom(str, len, hash_value(str, len));
+	return a ? a->str : NULL;
+}
+
+
+static char *atom_intern(const char *str, int len)
+{
+	struct atom *a;
+	u32 hash;
+
+	if (!str) return NULL;
+	len  = bounded_strlen(str, len);
+	hash = hash_value(str, len);
+
+	if ((a = find_atom(str, len, hash))) return a->str;
+
+	a = malloc(sizeof(struct atom) + len);
+	if (!a) {
+		ERROR(printf("Atom(intern): out of memory\n");)
+		return NULL;
+	}
+	a->hash = hash;
+	a->len  = len;
+	memcpy(a->str, str, len);
+	a->str[len] = 0;
+
+	if (++num_atoms > tab_size*2) grow_tab();
+
+	a->next = tab[hash & (tab_size - 1)];
+	tab[hash & (tab_size - 1)] = a;
+	return a->str;
+}
+
+
+/**************************************
+ ** Service structure of this module **
+ **************************************/
+
+static struct atom_services services = {
+	atom_intern,
+	atom_lookup,
+};
+
+
+/************************
+ ** Module entry point **
+ ************************/
+
+int init_atom(struct mtk_services *d)
+{
+	tab_size = ATOM_TAB_INIT_SIZE;
+	tab = zalloc(sizeof(struct atom *)*tab_size);
+	if (!tab) return 0;
+
+	d->register_module("Atom 1.0",&services);
+	return 1;
+}
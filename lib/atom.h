@@ -0,0 +1,38 @@
+/*
+ * \brief   Interface of the atom module of MTK
+ */
+
+/*
+ * Copyright (C) 2010 Sebastien Bourdeauducq
+ *
+ * This file is part of the MTK package, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+#ifndef _MTK_ATOM_H_
+#define _MTK_ATOM_H_
+
+/*
+ * An atom is the unique copy of an identifier string. Two atoms are
+ * equal if and only if their pointers are equal. Atoms are null-terminated
+ * and live as long as MTK does - they must never be modified or freed.
+ */
+
+struct atom_services {
+
+	/**
+	 * Return atom of the specified string, create it if needed
+	 *
+	 * \param str  identifier string (length is bounded by len)
+	 * \param len  max length of str
+	 */
+	char *(*intern) (const char *str, int len);
+
+	/**
+	 * Return atom of the specified string or NULL if it was never interned
+	 */
+	char *(*lookup) (const char *str, int len);
+};
+
+
+#endif /* _MTK_ATOM_H_ */
@@ -14,6 +14,7 @@ struct background;
 #define WIDGET struct background
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "mtkstd.h"
 #include "gfx.h"
@@ -41,10 +42,15 @@ int init_background(struct mtk_services *d);
 unsigned int config_bg_win_color = 0x001222ff;
 unsigned int config_bg_desk_color = 0x000010ff;
 
-static GFX_CONTAINER *wallpaper;
+static GFX_CONTAINER *wallpaper;          /* wallpaper as configured        */
+static GFX_CONTAINER *scaled_wallpaper;   /* wallpaper scaled to the screen */
 
 void mtk_config_set_wallpaper(unsigned short *wallpaper_bitmap, unsigned int wallpaper_w, unsigned int wallpaper_h)
 {
+	if(scaled_wallpaper != NULL) {
+		gfx->dec_ref(scaled_wallpaper);
+		scaled_wallpaper = NULL;
+	}
 	if(wallpaper != NULL) {
 		gfx->dec_ref(wallpaper);
 		wallpaper = NULL;
@@ -60,37 +66,210 @@ void mtk_config_set_wallpaper(unsigned short *wallpaper_bitmap, unsigned int wal
 	}
 }
 
+
+/********************************
+ ** Functions for internal use **
+ ********************************/
+
+#define WEIGHT_BITS 12   /* precision of normalized filter weights */
+
+/*
+ * Filter taps of one scaling pass. The taps of destination pixel i
+ * start at index first[i] of the source line and use the weights
+ * weight[offset[i]] to weight[offset[i + 1] - 1].
+ */
+struct taps {
+	int *first;
+	int *offset;
+	int *weight;
+};
+
+
+static void free_taps(struct taps *t)
+{
+	free(t->first);
+	free(t->offset);
+	free(t->weight);
+}
+
+
+/**
+ * Calculate taps of a tent filter that scales src_n pixels to dst_n pixels
+ *
+ * When downscaling, the filter covers all source pixels that contribute
+ * to a destination pixel. When upscaling, it interpolates linearly.
+ */
+static int calc_taps(struct taps *t, int src_n, int dst_n)
+{
+	int scale  = (int)(((long long)src_n << 16)/dst_n);
+	int radius = MAX(scale, 0x10000);
+	int max_taps = 2*(radius >> 16) + 2;
+	int i, j, n = 0;
+
+	t->first  = malloc(dst_n*sizeof(int));
+	t->offset = malloc((dst_n + 1)*sizeof(int));
+	t->weight = malloc(dst_n*max_taps*sizeof(int));
+	if (!t->first || !t->offset || !t->weight) {
+		free_taps(t);
+		return -1;
+	}
+
+	for (i = 0; i < dst_n; i++) {
+		int center = (int)((((long long)(2*i + 1))*scale) >> 1) - 0x8000;
+		int lo = (center - radius + 0xffff) >> 16;
+		int hi = (center + radius) >> 16;
+		int sum = 0, k;
+
+		lo = MAX(lo, 0);
+		hi = MIN(hi, src_n - 1);
+		if (lo > hi) lo = hi = MIN(MAX(center >> 16, 0), src_n - 1);
+
+		t->first[i]  = lo;
+		t->offset[i] = n;
+		for (j = lo; j <= hi; j++) {
+			int w = radius - abs((j << 16) - center);
+			t->weight[n + j - lo] = MAX(w, 0);
+			sum += MAX(w, 0) >> 4;
+		}
+
+		/* normalize weights, so that they sum up to 1 << WEIGHT_BITS */
+		for (k = n; k < n + hi - lo + 1; k++)
+			t->weight[k] = sum ? (int)((((long long)(t->weight[k] >> 4)) << WEIGHT_BITS)/sum)
+			                   : (1 << WEIGHT_BITS);
+		n += hi - lo + 1;
+	}
+	t->offset[dst_n] = n;
+	return 0;
+}
+
+
+/**
+ * Create copy of the wallpaper that is scaled to the specified size
+ *
+ * The image is scaled horizontally into a buffer with 10bit per color
+ * channel and vertically from there to the destination image.
+ */
+static GFX_CONTAINER *scale_wallpaper(int w, int h)
+{
+	int src_w = gfx->get_width(wallpaper), src_h = gfx->get_height(wallpaper);
+	struct taps tx, ty;
+	GFX_CONTAINER *img;
+	u16 *src, *dst;
+	u32 *tmp;
+	int x, y, k;
+
+	if (calc_taps(&tx, src_w, w)) return NULL;
+	if (calc_taps(&ty, src_h, h)) {
+		free_taps(&tx);
+		return NULL;
+	}
+	tmp = malloc(w*src_h*sizeof(u32));
+	img = tmp ? gfx->alloc_img(w, h, GFX_IMG_TYPE_RGB16) : NULL;
+	if (!img) {
+		ERROR(printf("Background(scale_wallpaper): out of memory\n"));
+		free(tmp);
+		free_taps(&tx);
+		free_taps(&ty);
+		return NULL;
+	}
+	src = gfx->map(wallpaper);
+	dst = gfx->map(img);
+
+	/* horizontal pass, store channels as 10bit values */
+	for (y = 0; y < src_h; y++)
+		for (x = 0; x < w; x++) {
+			u16 *s = src + y*src_w + tx.first[x];
+			int r = 0, g = 0, b = 0;
+			for (k = tx.offset[x]; k < tx.offset[x + 1]; k++, s++) {
+				r += tx.weight[k]*((*s >> 11) << 5);
+				g += tx.weight[k]*(((*s >> 5) & 0x3f) << 4);
+				b += tx.weight[k]*((*s & 0x1f) << 5);
+			}
+			tmp[y*w + x] = (((r >> WEIGHT_BITS) & 0x3ff) << 20)
+			             | (((g >> WEIGHT_BITS) & 0x3ff) << 10)
+			             |  ((b >> WEIGHT_BITS) & 0x3ff);
+		}
+
+	/* vertical pass, round to RGB565 */
+	for (y = 0; y < h; y++)
+		for (x = 0; x < w; x++) {
+			u32 *s = tmp + ty.first[y]*w + x;
+			int r = 0, g = 0, b = 0;
+			for (k = ty.offset[y]; k < ty.offset[y + 1]; k++, s += w) {
+				r += ty.weight[k]*(*s >> 20);
+				g += ty.weight[k]*((*s >> 10) & 0x3ff);
+				b += ty.weight[k]*(*s & 0x3ff);
+			}
+			r = MIN(((r >> WEIGHT_BITS) + 16) >> 5, 31);
+			g = MIN(((g >> WEIGHT_BITS) +  8) >> 4, 63);
+			b = MIN(((b >> WEIGHT_BITS) + 16) >> 5, 31);
+			dst[y*w + x] = (r << 11) | (g << 5) | b;
+		}
+
+	gfx->unmap(img);
+	gfx->unmap(wallpaper);
+	free(tmp);
+	free_taps(&tx);
+	free_taps(&ty);
+	return img;
+}
+
+
+/**
+ * Return wallpaper of the specified size, scale it if needed
+ */
+static GFX_CONTAINER *get_wallpaper(int w, int h)
+{
+	if (!wallpaper || w <= 0 || h <= 0) return NULL;
+
+	if (scaled_wallpaper && gfx->get_width(scaled_wallpaper) == w
+	                     && gfx->get_height(scaled_wallpaper) == h)
+		return scaled_wallpaper;
+
+	if (scaled_wallpaper) gfx->dec_ref(scaled_wallpaper);
+	scaled_wallpaper = NULL;
+
+	if (gfx->get_width(wallpaper) == w && gfx->get_height(wallpaper) == h) {
+		gfx->inc_ref(wallpaper);
+		scaled_wallpaper = wallpaper;
+	} else
+		scaled_wallpaper = scale_wallpaper(w, h);
+
+	/* draw the original wallpaper scaled on the fly if there is no memory */
+	return scaled_wallpaper ? scaled_wallpaper : wallpaper;
+}
+
+
 /****************************
  ** General widget methods **
  ****************************/
 
 
-static int bg_draw(BACKGROUND *b, struct gfx_ds *ds, int x, int y, WIDGET *origin)
+static int bg_draw(BACKGROUND *b, struct gfx_ds *ds, int x, int y)
 {
 	WIDGET *c;
+	GFX_CONTAINER *img;
 	int ret = 0;
 
-	if (origin == b) return 1;
-	
 	c = b->bd->content;
 
 	x += b->wd->x;
 	y += b->wd->y;
 	
-	if (!origin) switch (b->bd->style) {
+	switch (b->bd->style) {
 		case BG_STYLE_WIN:
 			gfx->draw_box(ds, x, y, b->wd->w, b->wd->h, config_bg_win_color);
 			ret |= 1;
 			break;
 		case BG_STYLE_DESK:
-			if(wallpaper == NULL)
+			if((img = get_wallpaper(b->wd->w, b->wd->h)) == NULL)
 				gfx->draw_box(ds, x, y, b->wd->w, b->wd->h, config_bg_desk_color);
 			else
-				gfx->draw_img(ds, x, y, b->wd->w, b->wd->h, wallpaper, 255);
+				gfx->draw_img(ds, x, y, b->wd->w, b->wd->h, img, 255);
 			ret |= 1;
 			break;
 	}
-	if (c) ret |= c->gen->draw(c, ds, x, y, origin);
+	if (c) ret |= c->gen->draw(c, ds, x, y);
 	return ret;
 }
 
@@ -257,12 +436,19 @@ static BACKGROUND *create(void)
 }
 
 
+static void prepare_wallpaper(int w, int h)
+{
+	get_wallpaper(w, h);
+}
+
+
 /**************************************
  ** Service structure of this module **
  **************************************/
 
 static struct background_services services = {
-	create
+	create,
+	prepare_wallpaper,
 };
 
 
@@ -35,6 +35,14 @@ struct background_methods {
 
 struct background_services {
 	BACKGROUND *(*create) (void);
+
+	/**
+	 * Scale wallpaper to the size of the desktop in advance
+	 *
+	 * Desktop backgrounds draw the scaled copy without scaling it
+	 * again. The copy is rebuilt only when the size changes.
+	 */
+	void (*prepare_wallpaper) (int w, int h);
 };
 
 
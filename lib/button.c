@@ -26,7 +26,7 @@ struct button;
 #include "script.h"
 #include "widman.h"
 #include "userstate.h"
-#include "messenger.h"
+#include "mtklib.h"
 #include "mtkeycodes.h"
 
 static struct widman_services    *widman;
@@ -34,7 +34,6 @@ static struct gfx_services       *gfx;
 static struct fontman_services   *font;
 static struct script_services    *script;
 static struct userstate_services *userstate;
-static struct messenger_services *msg;
 
 struct button_data {
 	char  *text;                      /* translated */
@@ -138,17 +137,11 @@ static inline void draw_kfocus_frame(GFX_CONTAINER *d, s32 x, s32 y, s32 w, s32
  ** General widget methods **
  ****************************/
 
-static int but_draw(BUTTON *b, struct gfx_ds *ds, int x, int y, WIDGET *origin)
+static int but_draw(BUTTON *b, struct gfx_ds *ds, int x, int y)
 {
 	int tx = b->bd->tx, ty = b->bd->ty;
 	int w  = b->wd->w,  h  = b->wd->h;
 
-	/* we hit the origin, acknowledge visibility request */
-	if (origin == b) return 1;
-
-	/* only draw if no origin is specified */
-	if (origin) return 0;
-
 	x += b->wd->x;
 	y += b->wd->y;
 
@@ -207,43 +200,38 @@ static int but_draw(BUTTON *b, struct gfx_ds *ds, int x, int y, WIDGET *origin)
 
 static void but_untouch_callback(BUTTON *b, int dx, int dy)
 {
-	char *clack_msg, *commit_msg = NULL;
-
 	if (!b->gen->get_state(b)) return;
 
-	clack_msg = b->gen->get_bind_msg(b, "clack");
-	if (clack_msg) msg->send_action_event(b->gen->get_app_id(b), "clack", clack_msg);
+	b->gen->send_action(b, MTK_BIND_CLACK, "clack");
 
-	commit_msg = b->gen->get_bind_msg(b, "commit");
-	if (commit_msg && config_clackcommit)
-		msg->send_action_event(b->gen->get_app_id(b), "commit", commit_msg);
+	if (config_clackcommit)
+		b->gen->send_action(b, MTK_BIND_COMMIT, "commit");
 }
 
 
 static void (*orig_handle_event) (BUTTON *b, EVENT *e, WIDGET *from);
 static void but_handle_event(BUTTON *b, EVENT *e, WIDGET *from)
 {
-	char *click_msg, *clack_msg, *commit_msg = NULL;
+	int bound;
 	switch (e->type) {
 		case EVENT_PRESS:
 			/* check for mouse button event */
 			if (e->code == MTK_BTN_LEFT) {
 				if (b->bd->click) b->bd->click(b);
 
-				click_msg  = b->gen->get_bind_msg(b, "click");
-				clack_msg  = b->gen->get_bind_msg(b, "clack");
-				commit_msg = b->gen->get_bind_msg(b, "commit");
+				bound = b->gen->is_bound(b, MTK_BIND_CLICK)
+				     || b->gen->is_bound(b, MTK_BIND_CLACK)
+				     || b->gen->is_bound(b, MTK_BIND_COMMIT);
 
-				if (click_msg || clack_msg || commit_msg)
+				if (bound)
 					userstate->touch(b, NULL, but_untouch_callback);
 
-				if (click_msg)
-					msg->send_action_event(b->gen->get_app_id(b), "click", click_msg);
+				b->gen->send_action(b, MTK_BIND_CLICK, "click");
 
-				if (commit_msg && !config_clackcommit)
-					msg->send_action_event(b->gen->get_app_id(b), "commit", commit_msg);
+				if (!config_clackcommit)
+					b->gen->send_action(b, MTK_BIND_COMMIT, "commit");
 
-				if (click_msg || clack_msg || commit_msg || b->bd->click) return;
+				if (bound || b->bd->click) return;
 			}
 			break;
 		case EVENT_RELEASE:
@@ -333,6 +321,18 @@ static void but_bind(BUTTON *b, char *bind_ident, char *message)
 }
 
 
+static void (*orig_bind_callback) (BUTTON *b, int type,
+                                   void (*callback)(union mtklib_event_union *, void *),
+                                   void *arg, int filter);
+static void but_bind_callback(BUTTON *b, int type,
+                              void (*callback)(union mtklib_event_union *, void *),
+                              void *arg, int filter)
+{
+	if (callback) b->wd->flags |= WID_FLAGS_TAKEFOCUS;
+	orig_bind_callback(b, type, callback, arg, filter);
+}
+
+
 /**
  * Return widget type identifier
  */
@@ -528,7 +528,6 @@ int init_button(struct mtk_services *d)
 	font      = d->get_module("FontManager 1.0");
 	script    = d->get_module("Script 1.0");
 	userstate = d->get_module("UserState 1.0");
-	msg       = d->get_module("Messenger 1.0");
 	
 	normal_img = gen_range_img(gfx, 30, 30, 30,  0, 27, 51);
 	focus_img = gen_range_img(gfx, 40, 40, 45,  0, 27, 51);
@@ -540,6 +539,7 @@ int init_button(struct mtk_services *d)
 	orig_updatepos    = gen_methods.updatepos;
 	orig_handle_event = gen_methods.handle_event;
 	orig_bind         = gen_methods.bind;
+	orig_bind_callback = gen_methods.bind_callback;
 
 	gen_methods.get_type     = but_get_type;
 	gen_methods.draw         = but_draw;
@@ -548,6 +548,7 @@ int init_button(struct mtk_services *d)
 	gen_methods.calc_minmax  = but_calc_minmax;
 	gen_methods.free_data    = but_free_data;
 	gen_methods.bind         = but_bind;
+	gen_methods.bind_callback = but_bind_callback;
 
 	build_script_lang();
 
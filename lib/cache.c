@@ -6,6 +6,12 @@
  * used for every kind of  data the primary  use
  * of this module is the management of image and
  * font caches.
+ *
+ * Elements are either addressed by the index and identifier
+ * returned by add_elem or by an arbitrary key of bytes that
+ * is hashed to the element. Unused elements are evicted in
+ * least recently used order. Pinned elements are exempted
+ * from eviction until they get unpinned.
  */
 
 /*
@@ -25,20 +31,151 @@ struct cache_elem {
 	s32    size;               /* size of data block */
 	s32    ident;              /* data block identifier */
 	void (*destroy)(void *);   /* data block destroy function */
+	s32    prev, next;         /* neighbours in LRU list or free list */
+	void  *key;                /* copy of the key or NULL */
+	s32    key_len;
+	u32    hash;               /* hash value of the key */
+	s32    hnext;              /* next element in hash chain */
+	s32    pins;               /* pin counter, pinned elements are not in LRU list */
+	s32    stale;              /* removed while pinned, destroy on unpin */
 };
 
 struct cache {
-	s32 max_entries;                /* size of ring buffer */
+	s32 max_entries;                /* number of cache elements */
 	s32 max_size;                   /* max amount of cached data */
 	s32 curr_size;                  /* current amount of cached data */
-	s32 idxtokill;                  /* 'oldest' ring buffer index */
-	s32 idxtoadd;                   /* ring buffer index for new element */
-	struct cache_elem *elem; /* pointer to ring buffer */
+	s32 mru;                        /* most recently used element */
+	s32 lru;                        /* least recently used element */
+	s32 first_free;                 /* first unused element */
+	s32 hits, misses;               /* lookup statistics */
+	s32 evictions;                  /* number of elements evicted */
+	s32 num_entries;                /* number of used elements */
+	u32 hash_mask;                  /* number of hash buckets - 1 */
+	s32 *bucket;                    /* first element of each hash chain */
+	struct cache_elem *elem;        /* pointer to element array */
 };
 
 int init_cache(struct mtk_services *d);
 
 
+/********************************
+ ** Functions for internal use **
+ ********************************/
+
+/**
+ * Remove element from LRU list
+ */
+static void lru_unlink(CACHE *cache, s32 index)
+{
+	struct cache_elem *e = cache->elem + index;
+
+	if (e->prev >= 0) cache->elem[e->prev].next = e->next;
+	else cache->mru = e->next;
+
+	if (e->next >= 0) cache->elem[e->next].prev = e->prev;
+	else cache->lru = e->prev;
+}
+
+
+/**
+ * Insert element at the most recently used end of the LRU list
+ */
+static void lru_push(CACHE *cache, s32 index)
+{
+	struct cache_elem *e = cache->elem + index;
+
+	e->prev = -1;
+	e->next = cache->mru;
+	if (cache->mru >= 0) cache->elem[cache->mru].prev = index;
+	else cache->lru = index;
+	cache->mru = index;
+}
+
+
+/**
+ * Calculate hash value of a key (FNV-1a)
+ */
+static u32 hash_key(const void *key, s32 key_len)
+{
+	const u8 *k = key;
+	u32 h = 2166136261u;
+
+	while (key_len-- > 0) h = (h ^ *k++)*16777619u;
+	return h;
+}
+
+
+/**
+ * Find element with the specified key
+ */
+static s32 find_key(CACHE *cache, const void *key, s32 key_len, u32 hash)
+{
+	s32 i = cache->bucket[hash & cache->hash_mask];
+	struct cache_elem *e;
+
+	for (; i >= 0; i = e->hnext) {
+		e = cache->elem + i;
+		if (e->hash == hash && e->key_len == key_len && !memcmp(e->key, key, key_len))
+			return i;
+	}
+	return -1;
+}
+
+
+/**
+ * Remove key of an element from the hash table
+ */
+static void unhash(CACHE *cache, s32 index)
+{
+	struct cache_elem *e = cache->elem + index;
+	s32 *link = &cache->bucket[e->hash & cache->hash_mask];
+
+	if (!e->key) return;
+	while (*link >= 0 && *link != index) link = &cache->elem[*link].hnext;
+	if (*link == index) *link = e->hnext;
+
+	free(e->key);
+	e->key = NULL;
+}
+
+
+/**
+ * Destroy data of an element and hand the element back to the free list
+ */
+static void free_elem(CACHE *cache, s32 index)
+{
+	struct cache_elem *e = cache->elem + index;
+
+	unhash(cache, index);
+	if (e->destroy) e->destroy(e->data);
+	else free(e->data);
+	cache->curr_size -= e->size;
+	cache->num_entries--;
+	e->data  = NULL;
+	e->pins  = 0;
+	e->stale = 0;
+
+	e->next = cache->first_free;
+	cache->first_free = index;
+}
+
+
+/**
+ * Evict least recently used element
+ */
+static int evict_lru(CACHE *cache)
+{
+	s32 index = cache->lru;
+
+	if (index < 0) return 0;
+	INFO(printf("Cache(evict_lru): evicting element %d\n", index);)
+	lru_unlink(cache, index);
+	free_elem(cache, index);
+	cache->evictions++;
+	return 1;
+}
+
+
 /***********************
  ** Service functions **
  ***********************/
@@ -49,10 +186,16 @@ int init_cache(struct mtk_services *d);
 static CACHE *create(s32 max_entries,s32 max_size)
 {
 	struct cache *c;
+	s32 i;
+	u32 num_buckets = 1;
 
-	/* get memory for cache struct and the ring buffer */
+	if (max_entries < 0) max_entries = 0;
+	while (num_buckets < (u32)max_entries) num_buckets <<= 1;
+
+	/* get memory for cache struct, the element array and the hash buckets */
 	c = (struct cache *)zalloc(sizeof(struct cache)
-	                         + sizeof(struct cache_elem)*max_entries);
+	                         + sizeof(struct cache_elem)*max_entries
+	                         + sizeof(s32)*num_buckets);
 	if (!c) {
 		INFO(printf("Cache(create): out of memory\n");)
 		return NULL;
@@ -61,7 +204,17 @@ static CACHE *create(s32 max_entries,s32 max_size)
 	/* set values in cache struct */
 	c->max_entries = max_entries;
 	c->max_size    = max_size;
-	c->elem = (struct cache_elem *)((int)c + sizeof(struct cache));
+	c->elem   = (struct cache_elem *)(c + 1);
+	c->bucket = (s32 *)(c->elem + max_entries);
+	c->hash_mask = num_buckets - 1;
+	c->mru  = c->lru = -1;
+
+	for (i = 0; i < num_buckets; i++) c->bucket[i] = -1;
+
+	/* all elements are unused */
+	for (i = 0; i < max_entries; i++)
+		c->elem[i].next = (i + 1 < max_entries) ? i + 1 : -1;
+	c->first_free = max_entries ? 0 : -1;
 
 	return c;
 }
@@ -69,6 +222,9 @@ static CACHE *create(s32 max_entries,s32 max_size)
 
 /**
  * Remove element from cache
+ *
+ * A pinned element cannot be found anymore but its data is
+ * destroyed not before the element gets unpinned.
  */
 static void remove_elem(CACHE *cache,s32 index)
 {
@@ -77,23 +233,28 @@ static void remove_elem(CACHE *cache,s32 index)
 		INFO(printf("Cache(remove_elem): cache == NULL\n");)
 		return;
 	}
-	if (index >= cache->max_entries) {
+	if (index < 0 || index >= cache->max_entries) {
 		INFO(printf("Cache(remove_elem): index out of range\n");)
 		return;
 	}
 	e=cache->elem + index;
+	if (!e->data || e->stale) return;
 	INFO(printf("Cache(remove_element): removing element %u\n",index);)
-	if (e->data) {
-		if (e->destroy) e->destroy(e->data);
-		else free(e->data);
-		cache->curr_size -= e->size;
-		e->data=NULL;
+
+	if (e->pins) {
+		unhash(cache,index);
+		e->stale = 1;
+		return;
 	}
+	lru_unlink(cache,index);
+	free_elem(cache,index);
 }
 
 
 /**
  * Destroy cache
+ *
+ * Pinned elements are destroyed too.
  */
 static void destroy(CACHE *cache)
 {
@@ -101,22 +262,25 @@ static void destroy(CACHE *cache)
 	if (!cache) return;
 
 	/* free cache entries */
-	for (i=0;i<cache->max_entries;i++) remove_elem(cache,i);
+	for (i=0;i<cache->max_entries;i++)
+		if (cache->elem[i].data) free_elem(cache,i);
 
 	/* free cache struct itself */
 	free(cache);
 }
 
 
+/**
+ * Evict least recently used elements until the cache data fits into needed_size
+ *
+ * Pinned elements are not evicted, the cache may stay above the needed size.
+ */
 static void reduce_cachesize(CACHE *cache,int needed_size)
 {
 	if (!cache) return;
 
 	INFO(printf("Cache(reduce_cachesize): old size is %u\n",cache->curr_size);)
-	while (cache->curr_size > needed_size) {
-		remove_elem(cache,cache->idxtokill);
-		cache->idxtokill = (cache->idxtokill + 1)%(cache->max_entries);
-	}
+	while (cache->curr_size > needed_size && evict_lru(cache));
 	INFO(printf("Cache(reduce_cachesize): new size is %u\n",cache->curr_size);)
 }
 
@@ -124,6 +288,8 @@ static void reduce_cachesize(CACHE *cache,int needed_size)
 /**
  * Insert element into cache
  *
+ * If the cache is full, the least recently used elements are evicted.
+ *
  * \param  elem      data block to add to cache
  * \param  elemsize  size of data block (needed to determine when element must
  *                   be removed)
@@ -133,40 +299,40 @@ static void reduce_cachesize(CACHE *cache,int needed_size)
  *                   destroyed
  * \return           index to cache element. The cached element can be accessed
  *                   later using the function get_element with this index and
- *                   the identifier as args.
+ *                   the identifier as args. If all elements are pinned, -1 is
+ *                   returned and the data block stays with the caller.
  */
 static s32 add_elem(CACHE *cache,void *elem,s32 elemsize,s32 ident,void (*destroy)(void *))
 {
 	struct cache_elem *e;
 	s32 new_idx;
 
-	if (!cache) return -1;
+	if (!cache || !cache->max_entries) return -1;
 
 	/* check if cache grows bigger that its maximum size */
 	if (cache->curr_size + elemsize > cache->max_size) {
 		reduce_cachesize(cache,cache->max_size - elemsize);
 	}
 
-	new_idx = cache->idxtoadd;
+	/* all elements in use, replace the least recently used one */
+	if (cache->first_free < 0 && !evict_lru(cache)) {
+		INFO(printf("Cache(add_elem): all elements are pinned\n");)
+		return -1;
+	}
+
+	new_idx = cache->first_free;
 	e=cache->elem + new_idx;
+	cache->first_free = e->next;
 	INFO(printf("Cache(add_elem): add element at index %u\n",new_idx);)
 
-	/* gets another cache element overwritten? */
-	if (e->data) {
-		INFO(printf("Cache(add_elem): old element gets overwritten\n");)
-
-		/* remove old element */
-		remove_elem(cache,new_idx);
-		cache->idxtokill = (cache->idxtokill + 1)%(cache->max_entries);
-	}
-
 	e->data=elem;
 	e->size=elemsize;
 	e->ident=ident;
 	e->destroy=destroy;
+	lru_push(cache,new_idx);
 
 	cache->curr_size += elemsize;
-	cache->idxtoadd = (cache->idxtoadd + 1)%(cache->max_entries);
+	cache->num_entries++;
 
 	return new_idx;
 }
@@ -174,25 +340,160 @@ static s32 add_elem(CACHE *cache,void *elem,s32 elemsize,s32 ident,void (*destro
 
 /**
  * Get cached data
+ *
+ * A successful lookup marks the element as most recently used.
  */
 static void *get_elem(struct cache *cache,s32 index,s32 ident)
 {
+	struct cache_elem *e;
+
 	if (!cache) {
 		INFO(printf("Cache(get_elem): cache == NULL\n");)
 		return NULL;
 	}
-	if (index >= cache->max_entries) {
+	if (index < 0 || index >= cache->max_entries) {
 		INFO(printf("Cache(get_elem): index %u out of range\n",index);)
+		cache->misses++;
 		return NULL;
 	}
-	if ((cache->elem + index)->ident == ident) {
-		return (cache->elem + index)->data;
+	e = cache->elem + index;
+	if (e->data && !e->stale && (e->ident == ident)) {
+		if (!e->pins && cache->mru != index) {
+			lru_unlink(cache,index);
+			lru_push(cache,index);
+		}
+		cache->hits++;
+		return e->data;
 	}
 	INFO(printf("Cache(get_elem): element %u is not cached anymore\n",index);)
+	cache->misses++;
 	return NULL;
 }
 
 
+/**
+ * Insert element that is identified by a key
+ *
+ * An element with the same key is replaced. The key is copied.
+ *
+ * \return  index of the new element or -1 on failure, in which
+ *          case the data block stays with the caller
+ */
+static s32 add_key(CACHE *cache,const void *key,s32 key_len,void *elem,s32 elemsize,
+                   void (*destroy)(void *))
+{
+	struct cache_elem *e;
+	void *key_copy;
+	s32 index;
+	u32 hash;
+
+	if (!cache || !key || key_len < 0) return -1;
+
+	hash = hash_key(key,key_len);
+	if ((index = find_key(cache,key,key_len,hash)) >= 0)
+		remove_elem(cache,index);
+
+	if (!(key_copy = malloc(key_len ? key_len : 1))) {
+		INFO(printf("Cache(add_key): out of memory\n");)
+		return -1;
+	}
+	memcpy(key_copy,key,key_len);
+
+	if ((index = add_elem(cache,elem,elemsize,(s32)hash,destroy)) < 0) {
+		free(key_copy);
+		return -1;
+	}
+
+	e = cache->elem + index;
+	e->key     = key_copy;
+	e->key_len = key_len;
+	e->hash    = hash;
+	e->hnext   = cache->bucket[hash & cache->hash_mask];
+	cache->bucket[hash & cache->hash_mask] = index;
+	return index;
+}
+
+
+/**
+ * Look up element by its key
+ *
+ * \param index  if not NULL, the index of the element is returned
+ *               to be used with pin, unpin and remove_elem
+ */
+static void *get_key(CACHE *cache,const void *key,s32 key_len,s32 *index)
+{
+	s32 i;
+
+	if (index) *index = -1;
+	if (!cache || !key) return NULL;
+
+	i = find_key(cache,key,key_len,hash_key(key,key_len));
+	if (i < 0) {
+		cache->misses++;
+		return NULL;
+	}
+	if (index) *index = i;
+	return get_elem(cache,i,cache->elem[i].ident);
+}
+
+
+/**
+ * Protect element from eviction
+ *
+ * Pins are counted. Each pin must be balanced by an unpin.
+ */
+static void pin(CACHE *cache,s32 index)
+{
+	struct cache_elem *e;
+
+	if (!cache || index < 0 || index >= cache->max_entries) return;
+	e = cache->elem + index;
+	if (!e->data) return;
+
+	if (!e->pins++ && !e->stale) lru_unlink(cache,index);
+}
+
+
+/**
+ * Release pin of an element
+ *
+ * The element becomes most recently used, or is destroyed if it
+ * was removed while being pinned.
+ */
+static void unpin(CACHE *cache,s32 index)
+{
+	struct cache_elem *e;
+
+	if (!cache || index < 0 || index >= cache->max_entries) return;
+	e = cache->elem + index;
+	if (!e->data || !e->pins || --e->pins) return;
+
+	if (e->stale) free_elem(cache,index);
+	else lru_push(cache,index);
+}
+
+
+/**
+ * Request lookup statistics of the cache
+ */
+static void get_stats(struct cache *cache,s32 *hits,s32 *misses)
+{
+	if (hits)   *hits   = cache ? cache->hits   : 0;
+	if (misses) *misses = cache ? cache->misses : 0;
+}
+
+
+/**
+ * Request number of evictions and current usage of the cache
+ */
+static void get_usage(struct cache *cache,s32 *evictions,s32 *entries,s32 *size)
+{
+	if (evictions) *evictions = cache ? cache->evictions   : 0;
+	if (entries)   *entries   = cache ? cache->num_entries : 0;
+	if (size)      *size      = cache ? cache->curr_size   : 0;
+}
+
+
 /**************************************
  ** Service structure of this module **
  **************************************/
@@ -202,7 +503,13 @@ static struct cache_services services = {
 	destroy,
 	add_elem,
 	get_elem,
-	remove_elem
+	remove_elem,
+	get_stats,
+	add_key,
+	get_key,
+	pin,
+	unpin,
+	get_usage,
 };
 
 
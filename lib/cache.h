@@ -22,6 +22,23 @@ struct cache_services {
 	s32    (*add_elem)    (CACHE *c,void *elem,s32 elemsize,s32 ident,void (*destroy)(void *));
 	void  *(*get_elem)    (CACHE *c,s32 index,s32 ident);
 	void   (*remove_elem) (CACHE *c,s32 index);
+	void   (*get_stats)   (CACHE *c,s32 *hits,s32 *misses);
+
+	/*
+	 * Keyed access. Elements are identified by a copy of key_len
+	 * bytes at key. The returned index can be used with remove_elem,
+	 * pin and unpin.
+	 */
+	s32    (*add_key)     (CACHE *c,const void *key,s32 key_len,void *elem,s32 elemsize,void (*destroy)(void *));
+	void  *(*get_key)     (CACHE *c,const void *key,s32 key_len,s32 *index);
+
+	/*
+	 * Pinned elements are not evicted, e.g., while being drawn.
+	 */
+	void   (*pin)         (CACHE *c,s32 index);
+	void   (*unpin)       (CACHE *c,s32 index);
+
+	void   (*get_usage)   (CACHE *c,s32 *evictions,s32 *entries,s32 *size);
 };
 
 
@@ -17,6 +17,7 @@ struct container;
 #define WIDGET struct container
 
 #include <stdio.h>
+#include <stdlib.h>
 #include "mtkstd.h"
 #include "widget_data.h"
 #include "widget_help.h"
@@ -29,10 +30,28 @@ static struct gfx_services    *gfx;
 
 static struct widget_methods   gen_methods;
 
+#define INDEX_MIN_ELEMS 16   /* use position index for more elements */
+
+struct index_entry {
+	WIDGET *wid;
+	int     z;               /* position in element list, 0 is the front */
+};
 
 struct container_data {
 	WIDGET      *first_elem;
 	WIDGET      *last_elem;
+	int          num_elems;
+
+	/*
+	 * The position index holds the elements sorted by their y position.
+	 * It is rebuilt on demand after an element was added, removed,
+	 * moved or resized.
+	 */
+	struct index_entry *index;
+	struct index_entry *visible;   /* visible elements while drawing */
+	int          index_size;       /* capacity of both arrays        */
+	int          max_h;            /* maximum height of an element   */
+	int          index_dirty;      /* index must be rebuilt          */
 };
 
 int init_container(struct mtk_services *d);
@@ -42,25 +61,138 @@ int init_container(struct mtk_services *d);
  ** General widget methods **
  ****************************/
 
-static int cont_draw(CONTAINER *c, struct gfx_ds *ds, int x, int y, WIDGET *origin)
+/**
+ * Check if an element intersects the clipping area
+ *
+ * \param x,y  absolute position of the container
+ */
+static inline int elem_visible(WIDGET *cw, int x, int y, int cx1, int cy1, int cx2, int cy2)
+{
+	x += cw->wd->x;
+	y += cw->wd->y;
+	return (x <= cx2) && (y <= cy2) && (x + cw->wd->w > cx1) && (y + cw->wd->h > cy1);
+}
+
+
+static int cmp_index_y(const void *a, const void *b)
+{
+	return ((struct index_entry *)a)->wid->wd->y - ((struct index_entry *)b)->wid->wd->y;
+}
+
+
+static int cmp_index_z(const void *a, const void *b)
+{
+	return ((struct index_entry *)b)->z - ((struct index_entry *)a)->z;
+}
+
+
+/**
+ * Make sure that the position index is up to date
+ *
+ * \return  0 on success or -1 if the index could not be allocated
+ */
+static int validate_index(CONTAINER *c)
 {
+	struct container_data *cd = c->cd;
 	WIDGET *cw;
-	int ret = 0;
+	int i;
 
-	if (origin == c) return 1;
+	if (cd->index && !cd->index_dirty) return 0;
 
-	if (c) {
-		x += c->wd->x;
-		y += c->wd->y;
+	if (cd->num_elems > cd->index_size) {
+		int new_size = MAX(cd->num_elems, cd->index_size*2);
+		struct index_entry *index   = malloc(new_size*sizeof(struct index_entry));
+		struct index_entry *visible = malloc(new_size*sizeof(struct index_entry));
 
-		gfx->push_clipping(ds, x, y, c->wd->w, c->wd->h);
-		cw = c->cd->last_elem;
-		while (cw) {
-			ret |= cw->gen->draw(cw, ds, x, y, origin);
-			cw = cw->gen->get_prev(cw);
+		if (!index || !visible) {
+			if (index)   free(index);
+			if (visible) free(visible);
+			return -1;
 		}
+		if (cd->index)   free(cd->index);
+		if (cd->visible) free(cd->visible);
+		cd->index      = index;
+		cd->visible    = visible;
+		cd->index_size = new_size;
+	}
+
+	cd->max_h = 0;
+	for (i = 0, cw = cd->first_elem; cw && i < cd->index_size; i++, cw = cw->gen->get_next(cw)) {
+		cd->index[i].wid = cw;
+		cd->index[i].z   = i;
+		cd->max_h = MAX(cd->max_h, cw->wd->h);
+	}
+	qsort(cd->index, i, sizeof(struct index_entry), cmp_index_y);
+
+	cd->index_dirty = 0;
+	return 0;
+}
+
+
+/**
+ * Find first index entry with a y position not less than y
+ */
+static int find_index_y(CONTAINER *c, int y)
+{
+	int lo = 0, hi = c->cd->num_elems, mid;
+
+	while (lo < hi) {
+		mid = (lo + hi) >> 1;
+		if (c->cd->index[mid].wid->wd->y < y) lo = mid + 1;
+		else hi = mid;
+	}
+	return lo;
+}
+
+
+static int cont_draw(CONTAINER *c, struct gfx_ds *ds, int x, int y)
+{
+	WIDGET *cw;
+	int ret = 0, cx1, cy1, cx2, cy2, i, beg, end, num = 0;
+
+	if (!c) return 0;
+
+	x += c->wd->x;
+	y += c->wd->y;
+
+	gfx->push_clipping(ds, x, y, c->wd->w, c->wd->h);
+	cx1 = gfx->get_clip_x(ds);
+	cy1 = gfx->get_clip_y(ds);
+	cx2 = cx1 + gfx->get_clip_w(ds) - 1;
+	cy2 = cy1 + gfx->get_clip_h(ds) - 1;
+
+	if ((cx1 > cx2) || (cy1 > cy2)) {
+		gfx->pop_clipping(ds);
+		return 0;
+	}
+
+	/* few elements are just culled one by one */
+	if (c->cd->num_elems < INDEX_MIN_ELEMS || validate_index(c)) {
+		for (cw = c->cd->last_elem; cw; cw = cw->gen->get_prev(cw))
+			if (elem_visible(cw, x, y, cx1, cy1, cx2, cy2))
+				ret |= cw->gen->draw(cw, ds, x, y);
 		gfx->pop_clipping(ds);
+		return ret;
+	}
+
+	/*
+	 * Only elements that start within max_h pixels above the
+	 * clipping area can intersect it. Draw the visible ones in
+	 * the order of the element list, starting at the back.
+	 */
+	beg = find_index_y(c, cy1 - y - c->cd->max_h + 1);
+	end = find_index_y(c, cy2 - y + 1);
+	for (i = beg; i < end; i++)
+		if (elem_visible(c->cd->index[i].wid, x, y, cx1, cy1, cx2, cy2))
+			c->cd->visible[num++] = c->cd->index[i];
+
+	qsort(c->cd->visible, num, sizeof(struct index_entry), cmp_index_z);
+	for (i = 0; i < num; i++) {
+		cw = c->cd->visible[i].wid;
+		ret |= cw->gen->draw(cw, ds, x, y);
 	}
+
+	gfx->pop_clipping(ds);
 	return ret;
 }
 
@@ -91,6 +223,25 @@ static WIDGET *cont_find(CONTAINER *c,int x,int y)
 }
 
 
+/**
+ * Invalidate position index when an element changes its geometry
+ */
+static void cont_child_changed(CONTAINER *c, WIDGET *child)
+{
+	c->cd->index_dirty = 1;
+}
+
+
+/**
+ * Free container data
+ */
+static void cont_free_data(CONTAINER *c)
+{
+	if (c->cd->index)   free(c->cd->index);
+	if (c->cd->visible) free(c->cd->visible);
+}
+
+
 /********************************
  ** Container specific methods **
  ********************************/
@@ -112,6 +263,8 @@ static void cont_add(CONTAINER *c,WIDGET *new_element)
 
 	new_element->gen->set_parent(new_element,c);
 	c->cd->first_elem=new_element;
+	c->cd->num_elems++;
+	c->cd->index_dirty = 1;
 
 	new_element->gen->inc_ref(new_element);
 	new_element->gen->force_redraw(new_element);
@@ -122,29 +275,25 @@ static void cont_add(CONTAINER *c,WIDGET *new_element)
 
 static void cont_remove(CONTAINER *c,WIDGET *element)
 {
-	WIDGET *cw;
+	WIDGET *prev, *next;
 
 	if (!c) return;
 	if (!element) return;
 	if (element->gen->get_parent(element) != c) return;
 
-	/* first widget in our list? */
-	if (element == c->cd->first_elem) {
-		c->cd->first_elem = element->gen->get_next(element);
-	} else {
+	prev = element->gen->get_prev(element);
+	next = element->gen->get_next(element);
 
-		/* search in list */
-		cw=c->cd->first_elem;
-		while (cw) {
-			if(cw->gen->get_next(cw) == element) {
-				cw->gen->set_next(cw, element->gen->get_next(element));
-				break;
-			}
-			cw=cw->gen->get_next(cw);
-		}
-	}
+	/* unlink element, the list is doubly linked */
+	if (prev) prev->gen->set_next(prev, next);
+	else c->cd->first_elem = next;
+	if (next) next->gen->set_prev(next, prev);
+	else c->cd->last_elem = prev;
+	c->cd->num_elems--;
+	c->cd->index_dirty = 1;
 
 	element->gen->set_next(element, NULL);
+	element->gen->set_prev(element, NULL);
 	element->gen->set_parent(element, NULL);
 	element->gen->dec_ref(element);
 
@@ -200,6 +349,8 @@ int init_container(struct mtk_services *d)
 	widman->default_widget_methods(&gen_methods);
 	gen_methods.draw = cont_draw;
 	gen_methods.find = cont_find;
+	gen_methods.free_data = cont_free_data;
+	gen_methods.child_changed = cont_child_changed;
 
 	d->register_module("Container 1.0",&services);
 	return 1;
@@ -233,7 +233,7 @@ static int get_width(struct fntfile_hdr *fnt, int ch)
 
 	first_ade = get_u16(&fnt->first_ade);
 	last_ade  = get_u16(&fnt->last_ade);
-	offsets = (u16 *)((get_u32((u32 *)(&fnt->off_table))) + (int)fnt);
+	offsets = (u16 *)((u8 *)fnt + get_u32((u32 *)(&fnt->off_table)));
 	
 	if((ch >= first_ade) && (ch < last_ade))
 		return (get_u16(offsets + ch + 1) - get_u16(offsets + ch));
@@ -274,7 +274,7 @@ static int get_offset(struct fntfile_hdr *fnt, int ch)
 
 	first_ade = get_u16(&fnt->first_ade);
 	last_ade  = get_u16(&fnt->last_ade);
-	offsets   = (u16 *)((get_u32((u32 *)(&fnt->off_table))) + (int)fnt);
+	offsets   = (u16 *)((u8 *)fnt + get_u32((u32 *)(&fnt->off_table)));
 	
 	if((ch >= first_ade) && (ch <= last_ade))
 		return get_u16(offsets + ch);
@@ -383,7 +383,7 @@ static void font_gen_image(struct fntfile_hdr *fnt, u8 *dst)
 	}
 	linelength = get_u16(&fnt->form_width);
 	height     = get_u16(&fnt->form_height);
-	src = (u8 *)((get_u32((u32 *)(&fnt->dat_table))) + (int)fnt);
+	src = (u8 *)fnt + get_u32((u32 *)(&fnt->dat_table));
 	
 	for(i=0;i<256;i++) {
 		ch = iso8859_to_atari(i);
@@ -397,6 +397,26 @@ static void font_gen_image(struct fntfile_hdr *fnt, u8 *dst)
 }
 
 
+/**
+ * Get number of bytes occupied by header, tables and font image
+ */
+static u32 font_get_data_size(struct fntfile_hdr *fnt)
+{
+	u32 (*get_u32) (u32 *) = intel_format(fnt) ? i2u32 : m2u32;
+	return get_u32((u32 *)(&fnt->dat_table))
+	     + font_get_image_width(fnt)/8*font_get_image_height(fnt);
+}
+
+
+/**
+ * The bitplane image of fnt files must always be converted
+ */
+static void *font_get_native(struct fntfile_hdr *fnt)
+{
+	return NULL;
+}
+
+
 /**************************************
  ** Service structure of this module **
  **************************************/
@@ -411,6 +431,10 @@ static struct fontconv_services services = {
 	(u32  (*) (void *))       font_get_image_width,
 	(u32  (*) (void *))       font_get_image_height,
 	(void (*) (void *,u8 *))  font_gen_image,
+	(u32  (*) (void *))       font_get_data_size,
+	(s32 *(*) (void *))       font_get_native,
+	(s32 *(*) (void *))       font_get_native,
+	(u8  *(*) (void *))       font_get_native,
 };
 
 
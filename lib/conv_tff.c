@@ -29,6 +29,16 @@ struct tff_file_hdr {
 
 int init_conv_tff(struct mtk_services *d);
 
+/**
+ * The tables of tff files are stored in intel byte order.
+ * On little-endian targets, they can be used in place.
+ */
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define TFF_NATIVE_TABLES 1
+#else
+#define TFF_NATIVE_TABLES 0
+#endif
+
 
 /********************************
  ** Functions for internal use **
@@ -138,6 +148,47 @@ static u32 font_get_image_height(struct tff_file_hdr *tff)
 }
 
 
+/**
+ * Get number of bytes occupied by header and font image
+ */
+static u32 font_get_data_size(struct tff_file_hdr *tff)
+{
+	return sizeof(*tff) + font_get_image_width(tff)*font_get_image_height(tff);
+}
+
+
+/**
+ * Return width table within the tff data if usable as is
+ */
+static s32 *font_get_width_table(struct tff_file_hdr *tff)
+{
+	if (!TFF_NATIVE_TABLES || ((adr)tff & 3)) return NULL;
+	return (s32 *)tff->wtab;
+}
+
+
+/**
+ * Return offset table within the tff data if usable as is
+ */
+static s32 *font_get_offset_table(struct tff_file_hdr *tff)
+{
+	if (!TFF_NATIVE_TABLES || ((adr)tff & 3)) return NULL;
+	return (s32 *)tff->otab;
+}
+
+
+/**
+ * Return font image within the tff data
+ *
+ * The image consists of one byte per pixel and is therefore
+ * independent from the byte order.
+ */
+static u8 *font_get_image(struct tff_file_hdr *tff)
+{
+	return (u8 *)tff + sizeof(*tff);
+}
+
+
 /**
  * Generates chunky-organized font image
  *
@@ -172,6 +223,10 @@ static struct fontconv_services services = {
 	(u32  (*) (void *))       font_get_image_width,
 	(u32  (*) (void *))       font_get_image_height,
 	(void (*) (void *,u8 *))  font_gen_image,
+	(u32  (*) (void *))       font_get_data_size,
+	(s32 *(*) (void *))       font_get_width_table,
+	(s32 *(*) (void *))       font_get_offset_table,
+	(u8  *(*) (void *))       font_get_image,
 };
 
 
@@ -24,22 +24,26 @@ struct edit;
 #include "widget_data.h"
 #include "widget_help.h"
 #include "fontman.h"
+#include "textlayout.h"
+#include "utf8.h"
 #include "script.h"
 #include "widman.h"
 #include "userstate.h"
-#include "messenger.h"
+#include "mtklib.h"
 #include "mtkeycodes.h"
 #include "tick.h"
 #include "clipboard.h"
+#include "redraw.h"
 
 static struct widman_services    *widman;
 static struct gfx_services       *gfx;
 static struct fontman_services   *font;
+static struct textlayout_services *layout;
 static struct script_services    *script;
 static struct userstate_services *userstate;
-static struct messenger_services *msg;
 static struct tick_services      *tick;
 static struct clipboard_services *clipb;
+static struct redraw_services    *redraw;
 
 struct edit_data {
 	s16    font_id;                  /* used font                      */
@@ -51,8 +55,13 @@ struct edit_data {
 	s32    sel_w, sel_h;             /* pixel size of selection        */
 	s32    curpos;                   /* position of cursor             */
 	s32    cx, cy, ch;               /* cursor x/y position and height */
-	char  *txtbuf;                   /* textual content of the edit    */
+	char  *txtbuf;                   /* gap buffer holding the text    */
 	s32    txtbuflen;                /* current size of text buffer    */
+	s32    txtlen;                   /* number of characters in text   */
+	s32    gap;                      /* position of gap within text    */
+	TEXTLAYOUT *layout;              /* cached line and char positions */
+	char  *linebuf;                  /* copy of a line across the gap  */
+	s32    linebuflen;               /* size of line buffer            */
 	s32    linenrw;                  /* width of the line numbers      */
 	s32    linenrh;                  /* height of one line number      */
 	s32    maxlen;                   /* max string length              */
@@ -73,94 +82,221 @@ int init_edit(struct mtk_services *d);
 
 static void notify_change(EDIT *e)
 {
-	int app_id;
-	char *m;
+	e->gen->send_action(e, MTK_BIND_CHANGE, "change");
+}
+
+/*
+ * The text is stored in a gap buffer. The characters in front of the gap
+ * are located at the start of the text buffer, the characters behind the
+ * gap at its end. The last byte of the buffer is always zero. Insertions
+ * and deletions move the gap to the affected position, which is cheap
+ * because subsequent edits usually happen near the previous one.
+ */
+
+/**
+ * Return number of unused bytes in the gap
+ */
+static inline s32 gap_len(EDIT *e)
+{
+	return e->ed->txtbuflen - 1 - e->ed->txtlen;
+}
+
+
+/**
+ * Return character at the specified text position
+ */
+static inline char char_at(EDIT *e, s32 idx)
+{
+	return e->ed->txtbuf[idx < e->ed->gap ? idx : idx + gap_len(e)];
+}
+
+
+/**
+ * Return text position of the character that follows the specified one
+ */
+static s32 next_char(EDIT *e, s32 idx)
+{
+	u8 c[5];
+	int i;
+
+	if (idx >= e->ed->txtlen) return e->ed->txtlen;
+
+	/* the character may span the gap */
+	for (i = 0; i < 4; i++)
+		c[i] = (idx + i < e->ed->txtlen) ? char_at(e, idx + i) : 0;
+	c[4] = 0;
+	return idx + utf8_len(c);
+}
+
+
+/**
+ * Return text position of the character that precedes the specified one
+ */
+static s32 prev_char(EDIT *e, s32 idx)
+{
+	s32 i;
+
+	if (idx <= 0) return 0;
+
+	/* skip continuation bytes, check that they belong to one character */
+	for (i = idx - 1; (i > 0) && (idx - i < 4) && utf8_continues(char_at(e, i)); i--);
+	return (next_char(e, i) == idx) ? i : idx - 1;
+}
+
+
+/**
+ * Move gap of the text buffer to the specified text position
+ */
+static void move_gap(EDIT *e, s32 pos)
+{
+	char *buf = e->ed->txtbuf;
+	s32 gap = e->ed->gap, len = gap_len(e);
+
+	if (pos < gap)
+		memmove(buf + pos + len, buf + pos, gap - pos);
+	else if (pos > gap)
+		memmove(buf + gap, buf + gap + len, pos - gap);
+
+	e->ed->gap = pos;
+	layout->set_gap(e->ed->layout, pos, len);
+}
+
+
+/**
+ * Make sure that the gap can take the specified number of characters
+ *
+ * If the text buffer exceeds, it is enlarged to the next power of two.
+ *
+ * \return  0 on success
+ */
+static int reserve_gap(EDIT *e, s32 len)
+{
+	s32 new_len = e->ed->txtbuflen;
+	s32 tail = e->ed->txtlen - e->ed->gap;
+	char *new;
+
+	if (gap_len(e) >= len) return 0;
+	while (new_len - 1 - e->ed->txtlen < len) new_len *= 2;
+
+	new = realloc(e->ed->txtbuf, new_len);
+	if (!new) return -1;
+
+	/* move characters behind the gap and the termination to the buffer end */
+	memmove(new + new_len - 1 - tail, new + e->ed->txtbuflen - 1 - tail, tail + 1);
+
+	e->ed->txtbuf    = new;
+	e->ed->txtbuflen = new_len;
+	layout->set_gap(e->ed->layout, e->ed->gap, gap_len(e));
+	return 0;
+}
+
+
+/**
+ * Return pointer to a contiguous range of the text
+ */
+static char *text_range(EDIT *e, s32 idx, s32 len)
+{
+	if (idx < e->ed->gap && idx + len > e->ed->gap) move_gap(e, idx);
+	return e->ed->txtbuf + (idx < e->ed->gap ? idx : idx + gap_len(e));
+}
+
 
-	m = e->gen->get_bind_msg(e, "change");
-	app_id = e->gen->get_app_id(e);
-	if (m) msg->send_action_event(app_id, "change", m);
+/**
+ * Return null-terminated copy of a line
+ *
+ * \param start  text position of the first character of the line
+ * \param len    length of the line without line break
+ */
+static char *line_text(EDIT *e, s32 start, s32 len)
+{
+	s32 front = MAX(0, MIN(e->ed->gap - start, len));
+
+	if (len + 1 > e->ed->linebuflen) {
+		char *new = malloc(len + 1);
+		if (!new) return "";
+		free(e->ed->linebuf);
+		e->ed->linebuf    = new;
+		e->ed->linebuflen = len + 1;
+	}
+
+	/* copy the characters in front of and behind the gap */
+	memcpy(e->ed->linebuf, e->ed->txtbuf + start, front);
+	memcpy(e->ed->linebuf + front, e->ed->txtbuf + start + front + gap_len(e), len - front);
+	e->ed->linebuf[len] = 0;
+	return e->ed->linebuf;
 }
 
+
 /**
- * Delete character at specified string position
+ * Insert text at specified text position
  *
  * \return   1 on success
  */
-static int delete_char(EDIT *e, int idx)
+static int insert_text(EDIT *e, s32 idx, const char *text, s32 len)
 {
-	char *dst = e->ed->txtbuf + idx;
-	char *src = e->ed->txtbuf + idx + 1;
-	if (idx >= strlen(e->ed->txtbuf)) return 0;
-	while (*src) *(dst++) = *(src++);
-	*dst = 0;
+	if (idx < 0 || idx > e->ed->txtlen || len <= 0) return 0;
+	if (reserve_gap(e, len)) return 0;
+
+	move_gap(e, idx);
+	memcpy(e->ed->txtbuf + idx, text, len);
+	e->ed->gap    += len;
+	e->ed->txtlen += len;
+
+	layout->set_gap(e->ed->layout, e->ed->gap, gap_len(e));
+	layout->insert(e->ed->layout, e->ed->txtbuf, idx, len);
 	notify_change(e);
 	return 1;
 }
 
 
 /**
- * Insert character at specified string position
- *
- * If the string buffer exceeds, a new one is allocated.
+ * Delete characters at specified text position
  *
  * \return   1 on success
  */
-static int insert_char(EDIT *e, int idx, char c)
-{
-	int i, len = strlen(e->ed->txtbuf);
-	char *src, *dst;
-
-	/* if txtbuffer exceeds, reallocate a bigger one */
-	if (len >= (e->ed->txtbuflen-1)) {
-		char *new;
-		e->ed->txtbuflen = e->ed->txtbuflen * 2;
-		new = (char *)zalloc(e->ed->txtbuflen);
-		if (!new) return 0;
-		for(i=0;i<=len;i++) new[i] = e->ed->txtbuf[i];
-		free(e->ed->txtbuf);
-		e->ed->txtbuf = new;
-	}
-	dst = e->ed->txtbuf + len;
-	src = dst - 1;
-
-	/* move tail of string to the right */
-	for (i=0; i<len-idx; i++) *(dst--) = *(src--);
+static int delete_text(EDIT *e, s32 idx, s32 len)
+{
+	if (idx < 0 || idx >= e->ed->txtlen || len <= 0) return 0;
+	len = MIN(len, e->ed->txtlen - idx);
 
-	/* insert character */
-	*dst = c;
+	/* the gap swallows the deleted characters */
+	move_gap(e, idx);
+	e->ed->txtlen -= len;
 
+	layout->set_gap(e->ed->layout, e->ed->gap, gap_len(e));
+	layout->remove(e->ed->layout, e->ed->txtbuf, idx, len);
 	notify_change(e);
 	return 1;
 }
 
+
 /**
- * Calculate x and y positions of the character at the specified index
+ * Close the gap and return text as null-terminated string
  */
-static inline void get_char_pos(EDIT *e, int idx, s32 *xpos, s32 *ypos)
+static char *flat_text(EDIT *e)
 {
-	int tmp;
-	char *linestart;
-	int i, lines;
-	struct font *fnt = font->get_by_id(e->ed->font_id);
-
-	linestart = e->ed->txtbuf;
-	i = 0;
-	lines = 0;
-	while(e->ed->txtbuf[i]) {
-		if(i == idx) break;
-		if(e->ed->txtbuf[i] == '\n') {
-			lines++;
-			linestart = &e->ed->txtbuf[i+1];
-		}
-		i++;
-	}
+	move_gap(e, e->ed->txtlen);
+	e->ed->txtbuf[e->ed->txtlen] = 0;
+	return e->ed->txtbuf;
+}
 
-	*ypos = lines*fnt->img_h;
 
-	tmp = e->ed->txtbuf[idx];
-	e->ed->txtbuf[idx] = 0;
-	*xpos = font->calc_str_width(e->ed->font_id, linestart);
-	e->ed->txtbuf[idx] = tmp;
+/**
+ * Lay out the whole text, e.g., after the text got replaced
+ */
+static void reset_layout(EDIT *e)
+{
+	layout->set_text(e->ed->layout, e->ed->font_id, flat_text(e));
+	layout->set_gap(e->ed->layout, e->ed->gap, gap_len(e));
+}
+
+
+/**
+ * Calculate x and y positions of the character at the specified index
+ */
+static inline void get_char_pos(EDIT *e, int idx, s32 *xpos, s32 *ypos)
+{
+	layout->get_pos(e->ed->layout, idx, xpos, ypos);
 }
 
 
@@ -169,7 +305,42 @@ static inline void get_char_pos(EDIT *e, int idx, s32 *xpos, s32 *ypos)
  */
 static inline int get_char_index(EDIT *e, s32 xpos, s32 ypos)
 {
-	return font->calc_char_idx(e->ed->font_id, e->ed->txtbuf, xpos, ypos);
+	return layout->get_index(e->ed->layout, xpos, ypos);
+}
+
+
+/**
+ * Determine text lines that intersect the current clipping area
+ *
+ * \param ty  screen position of the first line
+ */
+static void visible_lines(EDIT *e, struct gfx_ds *ds, int ty, s32 *first, s32 *last)
+{
+	int cy = gfx->get_clip_y(ds), ch = gfx->get_clip_h(ds);
+
+	*first = 0;
+	*last  = -1;
+	if (e->ed->ch <= 0 || ch <= 0) return;
+
+	*first = MAX(0, (cy - ty)/e->ed->ch);
+	*last  = MIN(layout->num_lines(e->ed->layout) - 1, (cy + ch - 1 - ty)/e->ed->ch);
+}
+
+
+/**
+ * Queue redraw of the text lines first to last
+ *
+ * If last is negative, all lines down to the bottom of the edit
+ * are redrawn, e.g., if a line break was inserted or removed.
+ */
+static void redraw_lines(EDIT *e, s32 first, s32 last)
+{
+	s32 y1 = 2 + 2 + e->ed->ty + first*e->ed->ch;
+	s32 y2 = (last < 0) ? e->wd->h - 1 : 2 + 2 + e->ed->ty + (last + 1)*e->ed->ch - 1;
+
+	y1 = MAX(y1, 0);
+	y2 = MIN(y2, e->wd->h - 1);
+	if (y1 <= y2) redraw->draw_widgetarea(e, 0, y1, e->wd->w - 1, y2);
 }
 
 
@@ -181,8 +352,8 @@ static void update_text_pos(EDIT *e)
 	int vw, vh;
 	if (!e || !e->ed || !e->ed->txtbuf) return;
 
-	e->ed->tw = font->calc_str_width (e->ed->font_id, e->ed->txtbuf);
-	e->ed->th = font->calc_str_height(e->ed->font_id, e->ed->txtbuf);
+	e->ed->tw = layout->get_width (e->ed->layout);
+	e->ed->th = layout->get_height(e->ed->layout);
 	e->ed->ch = font->calc_str_height(e->ed->font_id, "W");
 
 	/* calculate position of cursor */
@@ -220,6 +391,57 @@ static void update_text_pos(EDIT *e)
 		e->ed->ty = vh - e->ed->cy - e->ed->ch;
 }
 
+/**
+ * State of the edit that decides how much must be redrawn after a change
+ */
+struct view_state {
+	s32 tx, ty;             /* scroll position             */
+	s32 line, num_lines;    /* cursor line, number of lines */
+	s32 min_w, min_h;       /* min size of the edit        */
+	int sel;                /* selection is shown          */
+};
+
+static void save_view(EDIT *e, struct view_state *v)
+{
+	v->tx        = e->ed->tx;
+	v->ty        = e->ed->ty;
+	v->line      = layout->get_line(e->ed->layout, e->ed->curpos);
+	v->num_lines = layout->num_lines(e->ed->layout);
+	v->min_w     = e->wd->min_w;
+	v->min_h     = e->wd->min_h;
+	v->sel       = (e->ed->sel_beg != e->ed->sel_end);
+}
+
+
+/**
+ * Update edit after the cursor moved or the text changed
+ *
+ * Only the lines of the previous and the current cursor position are
+ * redrawn, or all lines below if the number of lines changed. The whole
+ * edit is redrawn if its size changed, if the text scrolled, or if a
+ * selection is involved.
+ */
+static void refresh_view(EDIT *e, struct view_state *v)
+{
+	s32 line;
+
+	/* let the parent re-layout if the min size of the edit changed */
+	e->gen->update(e);
+	if (e->wd->min_w != v->min_w || e->wd->min_h != v->min_h) return;
+
+	update_text_pos(e);
+	if (e->ed->tx != v->tx || e->ed->ty != v->ty || v->sel
+	 || e->ed->sel_beg != e->ed->sel_end) {
+		e->gen->force_redraw(e);
+		return;
+	}
+
+	line = layout->get_line(e->ed->layout, e->ed->curpos);
+	redraw_lines(e, MIN(line, v->line),
+	             layout->num_lines(e->ed->layout) != v->num_lines ? -1 : MAX(line, v->line));
+}
+
+
 static inline void draw_sunken_frame(GFX_CONTAINER *d, s32 x, s32 y, s32 w, s32 h)
 {
 	/* outer frame */
@@ -243,20 +465,18 @@ static inline void draw_kfocus_frame(GFX_CONTAINER *d, s32 x, s32 y, s32 w, s32
  ** General widget methods **
  ****************************/
 
-static int edit_draw(EDIT *e, struct gfx_ds *ds, int x, int y, WIDGET *origin)
+static int edit_draw(EDIT *e, struct gfx_ds *ds, int x, int y)
 {
 	int tx = e->ed->tx, ty = e->ed->ty;
 	u32  lc;
 	u32  tc;
 	u32  cc;
 	s32  cx, cy;
+	s32  first, last, start, len, num;
 	char buf[5];
-	int linenr, i;
+	int i;
 	int w  = e->wd->w,  h  = e->wd->h;
 
-	if (origin == e) return 1;
-	if (origin) return 0;
-
 	x += e->wd->x;
 	y += e->wd->y;
 
@@ -270,16 +490,16 @@ static int edit_draw(EDIT *e, struct gfx_ds *ds, int x, int y, WIDGET *origin)
 	lc = GFX_RGB(64, 64, 64);
 	
 	if(e->ed->txtbuf != NULL) {
-		linenr = 1;
-		i = 0;
-		while(e->ed->txtbuf[i] != 0) {
-			while((e->ed->txtbuf[i] != 0) && (e->ed->txtbuf[i] != '\n'))
-				i++;
-			snprintf(buf, sizeof(buf), "%d", linenr);
-			gfx->draw_string(ds, tx+x, ty+y+2+(linenr-1)*e->ed->linenrh, lc, 0, e->ed->font_id, buf);
-			if(e->ed->txtbuf[i] != 0)
-				i++;
-			linenr++;
+
+		/* an empty last line has no line number */
+		num = layout->num_lines(e->ed->layout);
+		layout->get_line_range(e->ed->layout, num - 1, &start, &len);
+		if (!len) num--;
+
+		visible_lines(e, ds, ty+y+2, &first, &last);
+		for (i = first; i <= last && i < num; i++) {
+			snprintf(buf, sizeof(buf), "%d", i + 1);
+			gfx->draw_string(ds, tx+x, ty+y+2+i*e->ed->linenrh, lc, 0, e->ed->font_id, buf);
 		}
 		x += e->ed->linenrw;
 	}
@@ -309,8 +529,15 @@ static int edit_draw(EDIT *e, struct gfx_ds *ds, int x, int y, WIDGET *origin)
 			gfx->draw_box(ds, e->ed->sel_x + tx, e->ed->sel_y + ty, e->ed->sel_w, e->ed->ch, GFX_RGB(0,59,112));
 	}
 
-	if (e->ed->txtbuf)
-		gfx->draw_string(ds, tx, ty, tc, 0, e->ed->font_id, e->ed->txtbuf);
+	/* draw only the lines within the clipping area */
+	if (e->ed->txtbuf) {
+		visible_lines(e, ds, ty, &first, &last);
+		for (i = first; i <= last; i++) {
+			layout->get_line_range(e->ed->layout, i, &start, &len);
+			gfx->draw_string(ds, tx, ty + i*e->ed->ch, tc, 0, e->ed->font_id,
+			                 line_text(e, start, len));
+		}
+	}
 
 	/* draw cursor */
 	if (e->wd->flags & WID_FLAGS_KFOCUS) {
@@ -405,21 +632,18 @@ static void sel_copy(EDIT *e)
 	s32 start_idx = MIN(e->ed->sel_beg, e->ed->sel_end);
 	s32 end_idx = MAX(e->ed->sel_beg, e->ed->sel_end);
 	if(start_idx == end_idx) return;
-	clipb->set(e->ed->txtbuf + start_idx, end_idx - start_idx);
+	clipb->set(text_range(e, start_idx, end_idx - start_idx), end_idx - start_idx);
 	e->ed->curpos = e->ed->sel_beg;
 }
 
 static int sel_cut(EDIT *e, int copy)
 {
-	s32 i;
 	s32 start_idx = MIN(e->ed->sel_beg, e->ed->sel_end);
 	s32 end_idx = MAX(e->ed->sel_beg, e->ed->sel_end);
 	if(start_idx == end_idx) return 0;
 	if(copy)
-		clipb->set(e->ed->txtbuf + start_idx, end_idx - start_idx);
-	for(i = start_idx; i<end_idx; ++i){
-		delete_char(e, start_idx);
-	}
+		clipb->set(text_range(e, start_idx, end_idx - start_idx), end_idx - start_idx);
+	delete_text(e, start_idx, end_idx - start_idx);
 	e->ed->curpos = start_idx;
 	return 1;
 }
@@ -428,14 +652,11 @@ static void clipboard_paste(EDIT *e)
 {
 	char* clip_data;
 	s32 clip_length;
-	int i;
 
 	clipb->get(&clip_data, &clip_length);
 	if(clip_length == 0) return;
-	for(i = 0; i<clip_length; ++i){
-		insert_char(e, e->ed->curpos + i, clip_data[i]);
-	}
-	e->ed->curpos += clip_length;
+	if(insert_text(e, e->ed->curpos, clip_data, clip_length))
+		e->ed->curpos += clip_length;
 }
 
 static void (*orig_handle_event) (EDIT *e, EVENT *ev, WIDGET *from);
@@ -445,6 +666,10 @@ static void edit_handle_event(EDIT *e, EVENT *ev, WIDGET *from)
 	int ypos = userstate->get_my() - e->gen->get_abs_y(e);
 	int ascii;
 	int ev_done = 0;
+	char c;
+	struct view_state view;
+
+	save_view(e, &view);
 
 	switch (ev->type) {
 		case EVENT_PRESS:
@@ -472,24 +697,24 @@ static void edit_handle_event(EDIT *e, EVENT *ev, WIDGET *from)
 					break;
 
 				case MTK_KEY_LEFT:
-					if(e->ed->curpos > 0) e->ed->curpos--;
+					e->ed->curpos = prev_char(e, e->ed->curpos);
 					sel_reset(e);
 					ev_done = 2;
 					break;
 				case MTK_KEY_RIGHT:
-					if(e->ed->curpos < strlen(e->ed->txtbuf)) e->ed->curpos++;
+					e->ed->curpos = next_char(e, e->ed->curpos);
 					sel_reset(e);
 					ev_done = 2;
 					break;
 
 				case MTK_KEY_HOME:
-					while((e->ed->curpos > 0) && (e->ed->txtbuf[e->ed->curpos-1] != '\n'))
+					while((e->ed->curpos > 0) && (char_at(e, e->ed->curpos-1) != '\n'))
 						e->ed->curpos--;
 					sel_reset(e);
 					ev_done = 2;
 					break;
 				case MTK_KEY_END: {
-					while((e->ed->txtbuf[e->ed->curpos] != 0) && (e->ed->txtbuf[e->ed->curpos] != '\n'))
+					while((e->ed->curpos < e->ed->txtlen) && (char_at(e, e->ed->curpos) != '\n'))
 						e->ed->curpos++;
 					sel_reset(e);
 					ev_done = 2;
@@ -497,10 +722,8 @@ static void edit_handle_event(EDIT *e, EVENT *ev, WIDGET *from)
 				}
 
 				case MTK_KEY_DELETE:
-					if(!sel_cut(e, 0)) {
-						if(e->ed->curpos < strlen(e->ed->txtbuf))
-							delete_char(e, e->ed->curpos);
-					}
+					if(!sel_cut(e, 0))
+						delete_text(e, e->ed->curpos, next_char(e, e->ed->curpos) - e->ed->curpos);
 					sel_reset(e);
 					ev_done = 2;
 					break;
@@ -508,8 +731,9 @@ static void edit_handle_event(EDIT *e, EVENT *ev, WIDGET *from)
 				case MTK_KEY_BACKSPACE:
 					if(!sel_cut(e, 0)) {
 						if(e->ed->curpos > 0) {
-							e->ed->curpos--;
-							delete_char(e, e->ed->curpos);
+							s32 end = e->ed->curpos;
+							e->ed->curpos = prev_char(e, end);
+							delete_text(e, e->ed->curpos, end - e->ed->curpos);
 						}
 					}
 					sel_reset(e);
@@ -519,7 +743,7 @@ static void edit_handle_event(EDIT *e, EVENT *ev, WIDGET *from)
 				case MTK_KEY_A:
 					if(userstate->get_keystate(MTK_KEY_LEFTCTRL)) {
 						e->ed->sel_beg = 0;
-						e->ed->sel_end = strlen(e->ed->txtbuf);
+						e->ed->sel_end = e->ed->txtlen;
 						ev_done = 2;
 					}
 					break;
@@ -553,11 +777,15 @@ static void edit_handle_event(EDIT *e, EVENT *ev, WIDGET *from)
 					return;
 			}
 
-			if(ev_done) {
+			if(ev_done == 1) {
 				update_text_pos(e);
 				e->gen->force_redraw(e);
 				return;
 			}
+			if(ev_done) {
+				refresh_view(e, &view);
+				return;
+			}
 
 			ascii = userstate->get_ascii(ev->code);
 			if (!ascii) {
@@ -565,11 +793,11 @@ static void edit_handle_event(EDIT *e, EVENT *ev, WIDGET *from)
 				return;
 			}
 			/* insert ASCII character */
-			insert_char(e, e->ed->curpos, ascii);
+			c = ascii;
+			insert_text(e, e->ed->curpos, &c, 1);
 			sel_reset(e);
 			e->ed->curpos++;
-			e->wd->update |= WID_UPDATE_REFRESH;
-			e->gen->update(e);
+			refresh_view(e, &view);
 	}
 }
 
@@ -587,8 +815,8 @@ static void edit_calc_minmax(EDIT *e)
 	e->wd->min_w = 40;
 	e->wd->min_h = 100;
 	if (e->ed->txtbuf) {
-		mw = font->calc_str_width(e->ed->font_id, e->ed->txtbuf) + 8;
-		mh = font->calc_str_height(e->ed->font_id, e->ed->txtbuf) + 8;
+		mw = layout->get_width (e->ed->layout) + 8;
+		mh = layout->get_height(e->ed->layout) + 8;
 		if (e->wd->min_w < mw) e->wd->min_w = mw;
 		if (e->wd->min_h < mh) e->wd->min_h = mh;
 	}
@@ -615,6 +843,8 @@ static void edit_updatepos(EDIT *e)
 static void edit_free_data(EDIT *e)
 {
 	if(e->ed->txtbuf) free(e->ed->txtbuf);
+	if(e->ed->linebuf) free(e->ed->linebuf);
+	layout->destroy(e->ed->layout);
 }
 
 
@@ -640,8 +870,16 @@ static void edit_set_text(EDIT *e, char *new_txt)
 	if(!newt) return;
 
 	free(e->ed->txtbuf);
-	e->ed->txtbuf = newt;
-	e->ed->txtbuflen = strlen(new_txt) + 1;
+	e->ed->txtbuf    = newt;
+	e->ed->txtlen    = strlen(new_txt);
+	e->ed->txtbuflen = e->ed->txtlen + 1;
+	e->ed->gap       = e->ed->txtlen;
+	reset_layout(e);
+
+	/* keep cursor and selection within the new text */
+	e->ed->curpos  = MIN(e->ed->curpos, e->ed->txtlen);
+	e->ed->sel_beg = MIN(e->ed->sel_beg, e->ed->txtlen);
+	e->ed->sel_end = MIN(e->ed->sel_end, e->ed->txtlen);
 
 	/* make the new text visible */
 	e->wd->update |= WID_UPDATE_REFRESH;
@@ -651,13 +889,44 @@ static void edit_set_text(EDIT *e, char *new_txt)
 static char *edit_get_text(EDIT *e)
 {
 	if (!e || !e->ed) return 0;
-	return e->ed->txtbuf;
+	return flat_text(e);
+}
+
+
+/**
+ * Insert text at the specified position
+ *
+ * In contrast to setting the text attribute, only the lines
+ * affected by the insertion are laid out and redrawn.
+ */
+static void edit_insert(EDIT *e, int pos, char *text)
+{
+	struct view_state view;
+	s32 len;
+
+	if (!e || !e->ed || !text) return;
+
+	save_view(e, &view);
+	pos = MAX(0, MIN(pos, e->ed->txtlen));
+	len = strlen(text);
+	if (!insert_text(e, pos, text, len)) return;
+
+	/* the insertion may happen above the cursor line */
+	view.line = MIN(view.line, layout->get_line(e->ed->layout, pos));
+
+	/* keep cursor and selection at their characters */
+	if (e->ed->curpos  >= pos) e->ed->curpos  += len;
+	if (e->ed->sel_beg >= pos) e->ed->sel_beg += len;
+	if (e->ed->sel_end >= pos) e->ed->sel_end += len;
+
+	refresh_view(e, &view);
 }
 
 static struct widget_methods gen_methods;
 static struct edit_methods edit_methods = {
 	edit_set_text,
 	edit_get_text,
+	edit_insert,
 };
 
 
@@ -676,9 +945,11 @@ static EDIT *create(void)
 	new->ed->sel_end   = -1;
 	new->ed->txtbuflen = 256;
 	new->ed->txtbuf    = zalloc(new->ed->txtbuflen);
+	new->ed->layout    = layout->create();
 	new->ed->linenrw   = font->calc_str_width(new->ed->font_id, "9999");
 	new->ed->linenrh   = font->calc_str_height(new->ed->font_id, "9999");
 	new->wd->flags    |= WID_FLAGS_EDITABLE | WID_FLAGS_TAKEFOCUS;
+	reset_layout(new);
 
 	update_text_pos(new);
 	edit_calc_minmax(new);
@@ -705,6 +976,7 @@ static void build_script_lang(void)
 
 	widtype = script->reg_widget_type("Edit", (void *(*)(void))create);
 	script->reg_widget_attrib(widtype, "string text", edit_get_text, edit_set_text, gen_methods.update);
+	script->reg_widget_method(widtype, "void insert(int pos,string text)", edit_insert);
 	widman->build_script_lang(widtype, &gen_methods);
 }
 
@@ -714,11 +986,12 @@ int init_edit(struct mtk_services *d)
 	widman    = d->get_module("WidgetManager 1.0");
 	gfx       = d->get_module("Gfx 1.0");
 	font      = d->get_module("FontManager 1.0");
+	layout    = d->get_module("TextLayout 1.0");
 	script    = d->get_module("Script 1.0");
 	userstate = d->get_module("UserState 1.0");
-	msg       = d->get_module("Messenger 1.0");
 	tick      = d->get_module("Tick 1.0");
 	clipb     = d->get_module("Clipboard 1.0");
+	redraw    = d->get_module("RedrawManager 1.0");
 
 	/* define general widget functions */
 	widman->default_widget_methods(&gen_methods);
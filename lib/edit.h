@@ -29,6 +29,7 @@ struct edit {
 struct edit_methods {
 	void    (*set_text)    (EDIT *, char *new_txt);
 	char   *(*get_text)    (EDIT *);
+	void    (*insert)      (EDIT *, int pos, char *text);
 };
 
 struct edit_services {
@@ -23,19 +23,21 @@ struct entry;
 #include "widget_data.h"
 #include "widget_help.h"
 #include "fontman.h"
+#include "textlayout.h"
+#include "utf8.h"
 #include "script.h"
 #include "widman.h"
 #include "userstate.h"
-#include "messenger.h"
+#include "mtklib.h"
 #include "mtkeycodes.h"
 #include "clipboard.h"
 
 static struct widman_services    *widman;
 static struct gfx_services       *gfx;
 static struct fontman_services   *font;
+static struct textlayout_services *layout;
 static struct script_services    *script;
 static struct userstate_services *userstate;
-static struct messenger_services *msg;
 static struct clipboard_services *clipb;
 
 struct entry_data {
@@ -49,6 +51,7 @@ struct entry_data {
 	s32    curpos;                   /* position of cursor             */
 	s32    cx, ch;                   /* cursor x position and height   */
 	char  *txtbuf;                   /* textual content of the entry   */
+	TEXTLAYOUT *layout;              /* cached char positions          */
 	s32    txtbuflen;                /* current size of text buffer    */
 	s32    maxlen;                   /* max string length              */
 	s32    vislen;                   /* min visible length             */
@@ -77,26 +80,53 @@ int init_entry(struct mtk_services *d);
 
 static void notify_change(ENTRY *e)
 {
-	int app_id;
-	char *m;
+	e->gen->send_action(e, MTK_BIND_CHANGE, "change");
+}
+
+/**
+ * Return string position of the character that follows the specified one
+ */
+static int next_char(ENTRY *e, int idx)
+{
+	u8 *s = (u8 *)e->ed->txtbuf;
+
+	return s[idx] ? idx + utf8_len(s + idx) : idx;
+}
+
+
+/**
+ * Return string position of the character that precedes the specified one
+ */
+static int prev_char(ENTRY *e, int idx)
+{
+	u8 *s = (u8 *)e->ed->txtbuf;
+	int i;
 
-	m = e->gen->get_bind_msg(e, "change");
-	app_id = e->gen->get_app_id(e);
-	if (m) msg->send_action_event(app_id, "change", m);
+	if (idx <= 0) return 0;
+
+	/* skip continuation bytes, check that they belong to one character */
+	for (i = idx - 1; (i > 0) && (idx - i < 4) && utf8_continues(s[i]); i--);
+	return (next_char(e, i) == idx) ? i : idx - 1;
 }
 
+
 /**
- * Delete character at specified string position
+ * Delete 'len' bytes at specified string position
  *
  * \return   1 on success
  */
-static int delete_char(ENTRY *e, int idx)
+static int delete_text(ENTRY *e, int idx, int len)
 {
+	int txtlen = strlen(e->ed->txtbuf);
 	char *dst = e->ed->txtbuf + idx;
-	char *src = e->ed->txtbuf + idx + 1;
-	if (idx >= strlen(e->ed->txtbuf)) return 0;
+	char *src;
+
+	if (idx >= txtlen || len <= 0) return 0;
+	len = MIN(len, txtlen - idx);
+	src = dst + len;
 	while (*src) *(dst++) = *(src++);
 	*dst = 0;
+	layout->remove(e->ed->layout, e->ed->txtbuf, idx, len);
 	notify_change(e);
 	return 1;
 }
@@ -133,6 +163,7 @@ static int insert_char(ENTRY *e, int idx, char c)
 	/* insert character */
 	*dst = c;
 
+	layout->insert(e->ed->layout, e->ed->txtbuf, idx, 1);
 	notify_change(e);
 	return 1;
 }
@@ -142,14 +173,12 @@ static int insert_char(ENTRY *e, int idx, char c)
  */
 static inline int get_char_pos(ENTRY *e, int idx)
 {
-	int xpos, tmp = e->ed->txtbuf[idx];
+	s32 xpos, ypos;
 
 	if (e->ed->flags & ENTRY_FLAGS_BLIND)
 		return idx*font->calc_str_width(e->ed->font_id, "*");
 
-	e->ed->txtbuf[idx] = 0;
-	xpos = font->calc_str_width(e->ed->font_id, e->ed->txtbuf);
-	e->ed->txtbuf[idx] = tmp;
+	layout->get_pos(e->ed->layout, idx, &xpos, &ypos);
 	return xpos;
 }
 
@@ -165,7 +194,7 @@ static inline int get_char_index(ENTRY *e, s32 pos)
 		if (res > strlen(e->ed->txtbuf)) res = strlen(e->ed->txtbuf);
 		return res;
 	}
-	return font->calc_char_idx(e->ed->font_id, e->ed->txtbuf, pos, 0);
+	return layout->get_index(e->ed->layout, pos, 0);
 }
 
 
@@ -181,8 +210,8 @@ static void update_text_pos(ENTRY *e)
 	if (!e || !e->ed || !e->ed->txtbuf) return;
 
 	e->ed->ty = 0;
-	e->ed->tw = font->calc_str_width (e->ed->font_id, e->ed->txtbuf);
-	e->ed->th = font->calc_str_height(e->ed->font_id, e->ed->txtbuf);
+	e->ed->tw = layout->get_width (e->ed->layout);
+	e->ed->th = layout->get_height(e->ed->layout);
 	e->ed->ch = e->ed->th;
 
 	/* calculate x position of cursor */
@@ -237,7 +266,7 @@ static inline void draw_kfocus_frame(GFX_CONTAINER *d, s32 x, s32 y, s32 w, s32
  ** General widget methods **
  ****************************/
 
-static int entry_draw(ENTRY *e, struct gfx_ds *ds, int x, int y, WIDGET *origin)
+static int entry_draw(ENTRY *e, struct gfx_ds *ds, int x, int y)
 {
 	int tx = e->ed->tx, ty = e->ed->ty;
 	u32  tc = WHITE_SOLID;
@@ -245,9 +274,6 @@ static int entry_draw(ENTRY *e, struct gfx_ds *ds, int x, int y, WIDGET *origin)
 	s32  cx;
 	int w  = e->wd->w,  h  = e->wd->h;
 
-	if (origin == e) return 1;
-	if (origin) return 0;
-
 	x += e->wd->x;
 	y += e->wd->y;
 
@@ -373,15 +399,12 @@ static void sel_copy(ENTRY *e)
 
 static int sel_cut(ENTRY *e, int copy)
 {
-	s32 i;
 	s32 start_idx = MIN(e->ed->sel_beg, e->ed->sel_end);
 	s32 end_idx = MAX(e->ed->sel_beg, e->ed->sel_end);
 	if(start_idx == end_idx) return 0;
 	if(copy)
 		clipb->set(e->ed->txtbuf + start_idx, end_idx - start_idx);
-	for(i = start_idx; i<end_idx; ++i){
-		delete_char(e, start_idx);
-	}
+	delete_text(e, start_idx, end_idx - start_idx);
 	e->ed->curpos = start_idx;
 	return 1;
 }
@@ -427,13 +450,13 @@ static void entry_handle_event(ENTRY *e, EVENT *ev, WIDGET *from)
 					e->gen->force_redraw(e);
 					return;
 				case MTK_KEY_LEFT:
-					if (e->ed->curpos > 0) e->ed->curpos--;
+					e->ed->curpos = prev_char(e, e->ed->curpos);
 					sel_reset(e);
 					ev_done = 2;
 					break;
 
 				case MTK_KEY_RIGHT:
-					if (e->ed->curpos < strlen(e->ed->txtbuf)) e->ed->curpos++;
+					e->ed->curpos = next_char(e, e->ed->curpos);
 					sel_reset(e);
 					ev_done = 2;
 					break;
@@ -453,8 +476,8 @@ static void entry_handle_event(ENTRY *e, EVENT *ev, WIDGET *from)
 				case MTK_KEY_DELETE:
 					if(!(e->ed->flags & ENTRY_FLAGS_READONLY)) {
 						if(!sel_cut(e, 0)) {
-							if(e->ed->curpos < strlen(e->ed->txtbuf))
-								delete_char(e, e->ed->curpos);
+							delete_text(e, e->ed->curpos,
+							            next_char(e, e->ed->curpos) - e->ed->curpos);
 						}
 						sel_reset(e);
 						ev_done = 2;
@@ -465,8 +488,9 @@ static void entry_handle_event(ENTRY *e, EVENT *ev, WIDGET *from)
 					if(!(e->ed->flags & ENTRY_FLAGS_READONLY)) {
 						if(!sel_cut(e, 0)) {
 							if(e->ed->curpos > 0) {
-								e->ed->curpos--;
-								delete_char(e, e->ed->curpos);
+								int end = e->ed->curpos;
+								e->ed->curpos = prev_char(e, end);
+								delete_text(e, e->ed->curpos, end - e->ed->curpos);
 							}
 						}
 						sel_reset(e);
@@ -502,12 +526,9 @@ static void entry_handle_event(ENTRY *e, EVENT *ev, WIDGET *from)
 					}
 					break;
 
-				case MTK_KEY_ENTER: {
-						/* send commit event to client application */
-						char *m = e->gen->get_bind_msg(e, "commit");
-						int app_id = e->gen->get_app_id(e);
-						if (m) msg->send_action_event(app_id, "commit", m);
-					}
+				case MTK_KEY_ENTER:
+					/* send commit event to client application */
+					e->gen->send_action(e, MTK_BIND_COMMIT, "commit");
 					ev_done = 1;
 					break;
 
@@ -573,6 +594,7 @@ static void entry_updatepos(ENTRY *e)
 static void entry_free_data(ENTRY *e)
 {
 	if (e->ed->txtbuf) free(e->ed->txtbuf);
+	layout->destroy(e->ed->layout);
 }
 
 
@@ -600,6 +622,7 @@ static void entry_set_text(ENTRY *e, char *new_txt)
 	free(e->ed->txtbuf);
 	e->ed->txtbuf = newt;
 	e->ed->txtbuflen = strlen(new_txt) + 1;
+	layout->set_text(e->ed->layout, e->ed->font_id, e->ed->txtbuf);
 
 	/* make the new text visible */
 	e->wd->update |= WID_UPDATE_REFRESH;
@@ -664,10 +687,12 @@ static ENTRY *create(void)
 	new->ed->sel_end   = -1;
 	new->ed->txtbuflen = 16;
 	new->ed->txtbuf    = zalloc(new->ed->txtbuflen);
+	new->ed->layout    = layout->create();
 	new->wd->flags    |= WID_FLAGS_EDITABLE | WID_FLAGS_HIGHLIGHT;
 
 	/* let the entry receive the keyboard focus even without any bindings */
 	new->wd->flags    |= WID_FLAGS_TAKEFOCUS;
+	layout->set_text(new->ed->layout, new->ed->font_id, new->ed->txtbuf);
 
 	update_text_pos(new);
 	entry_calc_minmax(new);
@@ -705,9 +730,9 @@ int init_entry(struct mtk_services *d)
 	widman    = d->get_module("WidgetManager 1.0");
 	gfx       = d->get_module("Gfx 1.0");
 	font      = d->get_module("FontManager 1.0");
+	layout    = d->get_module("TextLayout 1.0");
 	script    = d->get_module("Script 1.0");
 	userstate = d->get_module("UserState 1.0");
-	msg       = d->get_module("Messenger 1.0");
 	clipb     = d->get_module("Clipboard 1.0");
 
 	//normal_img = gen_range_img(gfx, 85, 85, 85, 148, 148, 148);
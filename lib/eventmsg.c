@@ -39,15 +39,10 @@ static unsigned int hex2u32(const char *s)
  ** Service functions **
  ***********************/
 
-static void send_input_event(s32 app_id, EVENT *e, char *bindarg)
+static void call_input_event(EVENT *e, void (*callback)(mtk_event *, void *), void *arg)
 {
-	void (*callback) (mtk_event *, void *);
-	void *arg;
 	mtk_event de;
 
-	callback = (void (*)(mtk_event *,void*))hex2u32(bindarg);
-	arg = (void *)hex2u32(bindarg+10);
-
 	switch (e->type) {
 
 	case EVENT_MOUSE_ENTER:
@@ -90,21 +85,38 @@ static void send_input_event(s32 app_id, EVENT *e, char *bindarg)
 }
 
 
-static void send_action_event(s32 app_id,char *action,char *bindarg)
+static void call_action_event(char *action, void (*callback)(mtk_event *, void *), void *arg)
 {
-	void (*callback) (mtk_event *, void *);
-	void *arg;
 	mtk_event de;
 
-	callback = (void (*)(mtk_event *,void*))hex2u32(bindarg);
-	arg = (void *)hex2u32(bindarg+10);
-
 	de.type = 1;
 	de.command.cmd = action;
 	callback(&de, arg);
 }
 
 
+/**
+ * Deliver events to callbacks that are specified as message
+ *
+ * The message contains the addresses of the callback function
+ * and its argument in hexadecimal notation. Such messages are
+ * bound by script clients only, the C API binds callbacks
+ * directly by event type.
+ */
+static void send_input_event(s32 app_id, EVENT *e, char *bindarg)
+{
+	call_input_event(e, (void (*)(mtk_event *,void*))hex2u32(bindarg),
+	                 (void *)hex2u32(bindarg+10));
+}
+
+
+static void send_action_event(s32 app_id,char *action,char *bindarg)
+{
+	call_action_event(action, (void (*)(mtk_event *,void*))hex2u32(bindarg),
+	                  (void *)hex2u32(bindarg+10));
+}
+
+
 /**************************************
  ** Service structure of this module **
  **************************************/
@@ -112,6 +124,8 @@ static void send_action_event(s32 app_id,char *action,char *bindarg)
 static struct messenger_services services = {
 	send_input_event,
 	send_action_event,
+	call_input_event,
+	call_action_event,
 };
 
 
@@ -23,6 +23,22 @@ struct fontconv_services {
 	u32  (*get_image_width)     (void *fontadr);
 	u32  (*get_image_height)    (void *fontadr);
 	void (*gen_image)           (void *fontadr,u8 *dst_img);
+
+	/**
+	 * Return number of bytes occupied by the font data
+	 */
+	u32  (*get_data_size)       (void *fontadr);
+
+	/**
+	 * Access tables and image directly within the font data
+	 *
+	 * These functions return NULL if the font data cannot be used
+	 * as is, for example because of the byte order of the target.
+	 * In this case, the gen_* functions must be used instead.
+	 */
+	s32 *(*get_width_table)     (void *fontadr);
+	s32 *(*get_offset_table)    (void *fontadr);
+	u8  *(*get_image)           (void *fontadr);
 };
 
 
@@ -13,21 +13,84 @@
  * under the terms of the GNU General Public License version 2.
  */
 
+#include <stdlib.h>
+#include <stdio.h>
 #include "mtkstd.h"
 #include "fontman.h"
 #include "fontconv.h"
+#include "cache.h"
+#include "utf8.h"
+
+#define FONT_TAB_INIT_SIZE 8     /* initial capacity of font table      */
+#define GLYPH_ATLAS_CELLS  128   /* number of glyphs held by each atlas */
+
+#define UTFF_MAGIC 0x46465455    /* "UTFF" in intel byte order */
 
-static struct fontconv_services *conv_fnt;
 static struct fontconv_services *conv_tff;
+static struct cache_services    *cache;
 
 /**
- * Symbols of font data
+ * File header structure of *.utff files
+ *
+ * All values are stored in intel byte order. The header is followed by
+ * the glyph table, which is sorted by Unicode values, and the run-length
+ * encoded glyph images. Each run is a pair of bytes: the number of
+ * pixels and their alpha value. The runs of a glyph cover its image
+ * line by line.
  */
-extern unsigned char default_fnt[];
-extern unsigned char mono_fnt[];
-extern unsigned char title_fnt[];
+struct utff_file_hdr {
+	u32 magic;        /* UTFF_MAGIC                        */
+	u32 num_glyphs;   /* number of entries in glyph table  */
+	u32 img_h;        /* height of all glyphs              */
+	u32 max_w;        /* width of the widest glyph         */
+};
+
+struct utff_glyph {
+	u32 ucs;          /* Unicode value of the character    */
+	u32 width;        /* width of glyph in pixels          */
+	u32 offset;       /* file offset of the glyph image    */
+};
 
-extern unsigned char vera16_tff[];
+/**
+ * Glyphs of a utff font
+ *
+ * Decompressed glyphs are kept in the cells of a fixed-size atlas.
+ * The cache module decides which glyph gets evicted if all cells
+ * are occupied.
+ */
+struct glyph_set {
+	struct utff_file_hdr *hdr;
+	struct utff_glyph    *tab;        /* glyph table within font data    */
+	u32                   size;       /* size of font data               */
+	s32                   num_glyphs;
+	s32                   img_h, max_w;
+	s32                   fallback;   /* glyph for missing characters    */
+	u8                   *atlas;      /* GLYPH_ATLAS_CELLS glyph images  */
+	CACHE                *cells;      /* atlas cells keyed by glyph index */
+};
+
+/**
+ * Built-in fonts, converted at build time (see mktables.c)
+ */
+extern const struct font builtin_fonts[];
+extern const int num_builtin_fonts;
+
+static char *builtin_idents[] = { "default", "monospaced", "title" };
+
+/**
+ * Entry of the font table
+ *
+ * Fonts are referenced by pointer such that the font structures
+ * stay at their place when the font table grows.
+ */
+struct font_slot {
+	struct font *font;    /* font structure                      */
+	char        *ident;   /* name used to select the font        */
+	void        *buf;     /* file buffer owned by the font table */
+};
+
+static struct font_slot *fonts;
+static int num_fonts, max_fonts;
 
 int init_fontman(struct mtk_services *d);
 
@@ -41,7 +104,128 @@ int init_fontman(struct mtk_services *d);
  */
 static inline int valid_font_id(int font_id)
 {
-	return (font_id >= 0 && font_id <= 2);
+	return (font_id >= 0 && font_id < num_fonts);
+}
+
+
+/**
+ * Append font to font table
+ *
+ * \return  font id or -1 on error
+ */
+static s32 add_font(struct font *font, char *ident)
+{
+	struct font_slot *new_tab;
+	int i, new_max;
+
+	if (num_fonts >= max_fonts) {
+		new_max = max_fonts ? max_fonts*2 : FONT_TAB_INIT_SIZE;
+		new_tab = zalloc(sizeof(struct font_slot)*new_max);
+		if (!new_tab) return -1;
+		for (i = 0; i < num_fonts; i++) new_tab[i] = fonts[i];
+		if (fonts) free(fonts);
+		fonts     = new_tab;
+		max_fonts = new_max;
+	}
+	fonts[num_fonts].font  = font;
+	fonts[num_fonts].ident = ident;
+	fonts[num_fonts].buf   = NULL;
+	return num_fonts++;
+}
+
+
+/**
+ * Utility: convert intel 32bit value to host format
+ */
+static u32 i2u32(u32 *src)
+{
+	u8 *a = (u8 *)src;
+	return ((u32)a[0]) | (((u32)a[1])<<8) | (((u32)a[2])<<16) | (((u32)a[3])<<24);
+}
+
+
+/**
+ * Find glyph table index of a Unicode character
+ *
+ * \return  glyph index or the index of the fallback glyph
+ */
+static s32 find_glyph(struct glyph_set *gs, u32 ucs)
+{
+	s32 lo = 0, hi = gs->num_glyphs - 1, mid;
+	u32 curr;
+
+	while (lo <= hi) {
+		mid  = (lo + hi) >> 1;
+		curr = i2u32(&gs->tab[mid].ucs);
+		if (curr == ucs) return mid;
+		if (curr < ucs) lo = mid + 1;
+		else            hi = mid - 1;
+	}
+	return gs->fallback;
+}
+
+
+/**
+ * Callback of the cell cache when a glyph gets evicted from the atlas
+ *
+ * The atlas cell is reused by the next glyph, nothing to free.
+ */
+static void release_cell(void *glyph_set)
+{}
+
+
+/**
+ * Decompress run-length encoded glyph image into an atlas cell
+ */
+static void unpack_glyph(struct glyph_set *gs, s32 gi, u8 *dst)
+{
+	u32 offset = i2u32(&gs->tab[gi].offset);
+	u8 *src = (u8 *)gs->hdr + offset;
+	u8 *end = (u8 *)gs->hdr + gs->size;
+	s32 left = i2u32(&gs->tab[gi].width)*gs->img_h;
+	s32 run;
+
+	while (left > 0 && src + 1 < end) {
+		run = MIN(src[0], left);
+		memset(dst, src[1], run);
+		dst  += run;
+		left -= run;
+		src  += 2;
+	}
+	if (left > 0) memset(dst, 0, left);
+}
+
+
+/**
+ * Return glyph image from atlas, decompress it if needed
+ */
+static u8 *atlas_glyph(struct glyph_set *gs, s32 gi)
+{
+	s32 cell_size = gs->max_w*gs->img_h;
+	s32 cell;
+
+	/* the index of the cache element is the atlas cell */
+	if (cache->get_key(gs->cells, &gi, sizeof(gi), &cell))
+		return gs->atlas + cell*cell_size;
+
+	cell = cache->add_key(gs->cells, &gi, sizeof(gi), gs, 1, release_cell);
+	if (cell < 0) return NULL;
+
+	unpack_glyph(gs, gi, gs->atlas + cell*cell_size);
+	return gs->atlas + cell*cell_size;
+}
+
+
+/**
+ * Determine width of a character
+ */
+static inline s32 char_width(struct font *f, u32 ucs)
+{
+	if (f->glyphs)
+		return i2u32(&f->glyphs->tab[find_glyph(f->glyphs, ucs)].width);
+
+	if (ucs > 255) ucs = FONT_REPLACEMENT_CHAR;
+	return f->width_table[ucs];
 }
 
 
@@ -49,23 +233,21 @@ static inline int valid_font_id(int font_id)
  ** Service functions **
  ***********************/
 
-static struct font fonts[3];
-
 static struct font *fontman_get_by_id(s32 font_id)
 {
 	if (!valid_font_id(font_id)) return NULL;
-	return (struct font *)(&fonts[font_id]);
+	return fonts[font_id].font;
 }
 
 
 static s32 fontman_calc_str_width_line(s32 font_id, char *str)
 {
+	struct font *f = fonts[font_id].font;
+	const u8 *s = (u8 *)str;
 	s32 result = 0;
 
-	while (*str && (*str != '\n')) {
-		result+=fonts[font_id].width_table[(s32)(*str)];
-		str++;
-	}
+	while (*s && (*s != '\n'))
+		result += char_width(f, utf8_decode(&s));
 	return result;
 }
 
@@ -91,18 +273,24 @@ static s32 fontman_calc_str_width(s32 font_id, char *str)
 
 /**
  * Calculate character index of specified pixel position
+ *
+ * The index is the byte offset of the character within the
+ * UTF-8 string.
  */
 static s32 fontman_calc_char_idx_line(s32 font_id, char *str, s32 pixpos)
 {
-	s32 idx = 0, pos = 0, charw;
-
-	while (*str && (*str != '\n')) {
-		charw = fonts[font_id].width_table[(s32)(*str)];
-		if (pos >= pixpos - (charw>>1)) return idx;
+	struct font *f = fonts[font_id].font;
+	const u8 *s = (u8 *)str, *next;
+	s32 pos = 0, charw;
+
+	while (*s && (*s != '\n')) {
+		next  = s;
+		charw = char_width(f, utf8_decode(&next));
+		if (pos >= pixpos - (charw>>1)) break;
 		pos += charw;
-		str++; idx++;
+		s = next;
 	}
-	return idx;
+	return s - (u8 *)str;
 }
 
 static s32 fontman_calc_char_idx(s32 font_id, char *str, s32 xpos, s32 ypos)
@@ -114,7 +302,7 @@ static s32 fontman_calc_char_idx(s32 font_id, char *str, s32 xpos, s32 ypos)
 	if (!str) return 0;
 	if (!valid_font_id(font_id)) return 0;
 
-	line = ypos/fonts[font_id].img_h;
+	line = ypos/fonts[font_id].font->img_h;
 	lastline = str;
 	clineoffset = lineoffset = 0;
 	if (line > 0) {
@@ -145,7 +333,251 @@ static s32 fontman_calc_str_height(s32 font_id, char *str)
 		if(*str == '\n') lines++;
 		str++;
 	}
-	return lines*fonts[font_id].img_h;
+	return lines*fonts[font_id].font->img_h;
+}
+
+
+static s32 fontman_lookup(char *ident);
+
+
+/**
+ * Register font that is provided as utff data
+ */
+static s32 fontman_register_utff(char *ident, void *utff, u32 size)
+{
+	struct utff_file_hdr *hdr = utff;
+	struct glyph_set *gs;
+	struct font *new;
+	char *name;
+	s32 i, id;
+
+	if (!ident || !utff || (fontman_lookup(ident) >= 0)) return -1;
+
+	if ((size < sizeof(*hdr)) || (i2u32(&hdr->magic) != UTFF_MAGIC)
+	 || (size < sizeof(*hdr) + i2u32(&hdr->num_glyphs)*sizeof(struct utff_glyph))
+	 || !i2u32(&hdr->num_glyphs) || !i2u32(&hdr->img_h) || !i2u32(&hdr->max_w)) {
+		ERROR(printf("FontManager(register_utff): invalid font data for %s\n", ident));
+		return -1;
+	}
+
+	new  = zalloc(sizeof(struct font));
+	gs   = zalloc(sizeof(struct glyph_set));
+	name = zalloc(strlen(ident) + 1);
+	if (!new || !gs || !name) goto fail;
+
+	gs->hdr        = hdr;
+	gs->tab        = (struct utff_glyph *)(hdr + 1);
+	gs->size       = size;
+	gs->num_glyphs = i2u32(&hdr->num_glyphs);
+	gs->img_h      = i2u32(&hdr->img_h);
+	gs->max_w      = i2u32(&hdr->max_w);
+	gs->atlas      = zalloc(GLYPH_ATLAS_CELLS*gs->max_w*gs->img_h);
+	gs->cells      = cache->create(GLYPH_ATLAS_CELLS, GLYPH_ATLAS_CELLS);
+	if (!gs->atlas || !gs->cells) goto fail;
+
+	/* reject glyphs that do not fit into an atlas cell */
+	for (i = 0; i < gs->num_glyphs; i++) {
+		if (i2u32(&gs->tab[i].width) > gs->max_w) {
+			ERROR(printf("FontManager(register_utff): invalid glyph in %s\n", ident));
+			goto fail;
+		}
+	}
+
+	/* use replacement character for missing glyphs, or the first glyph */
+	gs->fallback = 0;
+	gs->fallback = find_glyph(gs, FONT_REPLACEMENT_CHAR);
+
+	strcpy(name, ident);
+	new->img_w  = gs->max_w;
+	new->img_h  = gs->img_h;
+	new->name   = (u8 *)name;
+	new->glyphs = gs;
+
+	id = add_font(new, name);
+	if (id < 0) goto fail;
+	new->font_id = id;
+	return id;
+
+fail:
+	if (gs) {
+		if (gs->cells) cache->destroy(gs->cells);
+		if (gs->atlas) free(gs->atlas);
+		free(gs);
+	}
+	if (new)  free(new);
+	if (name) free(name);
+	return -1;
+}
+
+
+static s32 fontman_get_glyph(s32 font_id, u32 ucs, struct glyph *dst)
+{
+	struct font *f;
+	struct glyph_set *gs;
+	s32 gi;
+
+	if (!valid_font_id(font_id) || !dst) return -1;
+	f = fonts[font_id].font;
+
+	if (!(gs = f->glyphs)) {
+		if (ucs > 255) ucs = FONT_REPLACEMENT_CHAR;
+		dst->image  = f->image + f->offset_table[ucs];
+		dst->w      = f->width_table[ucs];
+		dst->stride = f->img_w;
+		return 0;
+	}
+
+	gi = find_glyph(gs, ucs);
+	dst->image  = atlas_glyph(gs, gi);
+	dst->w      = i2u32(&gs->tab[gi].width);
+	dst->stride = dst->w;
+	return dst->image ? 0 : -1;
+}
+
+
+static s32 fontman_calc_char_width(s32 font_id, u32 ucs)
+{
+	if (!valid_font_id(font_id)) return 0;
+	return char_width(fonts[font_id].font, ucs);
+}
+
+
+static void fontman_get_atlas_stats(s32 *hits, s32 *misses)
+{
+	s32 i, h, m, sum_h = 0, sum_m = 0;
+
+	for (i = 0; i < num_fonts; i++) {
+		if (!fonts[i].font->glyphs) continue;
+		cache->get_stats(fonts[i].font->glyphs->cells, &h, &m);
+		sum_h += h;
+		sum_m += m;
+	}
+	if (hits)   *hits   = sum_h;
+	if (misses) *misses = sum_m;
+}
+
+
+static s32 fontman_lookup(char *ident)
+{
+	int i;
+
+	if (!ident) return -1;
+	for (i = 0; i < num_fonts; i++)
+		if (mtk_streq(ident, fonts[i].ident, 255)) return i;
+	return -1;
+}
+
+
+static char *fontman_get_ident(s32 font_id)
+{
+	if (!valid_font_id(font_id)) return NULL;
+	return fonts[font_id].ident;
+}
+
+
+/**
+ * Register font that is provided as tff data
+ *
+ * The width table, offset table and image are referenced within the
+ * tff data whenever possible. Only if the byte order of the target
+ * does not match, the tables are converted. The glyph image is never
+ * copied.
+ */
+static s32 fontman_register_tff(char *ident, void *tff, u32 size)
+{
+	struct font *new;
+	s32 *wtab, *otab, *conv_tabs = NULL;
+	char *name;
+	s32 id;
+
+	if (!ident || !tff || (fontman_lookup(ident) >= 0)) return -1;
+
+	if (!conv_tff->probe(tff) || (size < conv_tff->get_data_size(tff))) {
+		ERROR(printf("FontManager(register_tff): invalid font data for %s\n", ident));
+		return -1;
+	}
+
+	new  = zalloc(sizeof(struct font));
+	name = zalloc(strlen(ident) + 1);
+	if (!new || !name) {
+		if (new)  free(new);
+		if (name) free(name);
+		return -1;
+	}
+	strcpy(name, ident);
+
+	new->img_w  = conv_tff->get_image_width(tff);
+	new->img_h  = conv_tff->get_image_height(tff);
+	new->top    = conv_tff->get_top(tff);
+	new->bottom = conv_tff->get_bottom(tff);
+	new->name   = conv_tff->get_name(tff);
+	new->image  = conv_tff->get_image(tff);
+
+	wtab = conv_tff->get_width_table(tff);
+	otab = conv_tff->get_offset_table(tff);
+	if (!wtab || !otab) {
+		conv_tabs = zalloc(256*4*2);
+		if (!conv_tabs) {
+			free(new);
+			free(name);
+			return -1;
+		}
+		wtab = conv_tabs;
+		otab = conv_tabs + 256;
+		conv_tff->gen_width_table(tff, wtab);
+		conv_tff->gen_offset_table(tff, otab);
+	}
+	new->width_table  = wtab;
+	new->offset_table = otab;
+
+	id = add_font(new, name);
+	if (id < 0) {
+		if (conv_tabs) free(conv_tabs);
+		free(new);
+		free(name);
+		return -1;
+	}
+	new->font_id = id;
+	return id;
+}
+
+
+/**
+ * Load tff or utff file and register it as font
+ *
+ * The file is read once into a buffer that is kept by the font table.
+ */
+static s32 fontman_load_tff(char *ident, char *path)
+{
+	FILE *file;
+	long size;
+	void *buf;
+	s32 id;
+
+	if (!(file = fopen(path, "rb"))) {
+		ERROR(printf("FontManager(load_tff): could not open %s\n", path));
+		return -1;
+	}
+	fseek(file, 0, SEEK_END);
+	size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	buf = (size > 0) ? malloc(size) : NULL;
+	if (!buf || (fread(buf, 1, size, file) != (size_t)size)) {
+		ERROR(printf("FontManager(load_tff): could not read %s\n", path));
+		if (buf) free(buf);
+		fclose(file);
+		return -1;
+	}
+	fclose(file);
+
+	if ((size >= 4) && (i2u32(buf) == UTFF_MAGIC))
+		id = fontman_register_utff(ident, buf, size);
+	else
+		id = fontman_register_tff(ident, buf, size);
+	if (id < 0) free(buf);
+	else fonts[id].buf = buf;
+	return id;
 }
 
 
@@ -158,6 +590,14 @@ static struct fontman_services services = {
 	fontman_calc_str_width,
 	fontman_calc_str_height,
 	fontman_calc_char_idx,
+	fontman_lookup,
+	fontman_get_ident,
+	fontman_register_tff,
+	fontman_load_tff,
+	fontman_register_utff,
+	fontman_get_glyph,
+	fontman_get_atlas_stats,
+	fontman_calc_char_width,
 };
 
 
@@ -165,39 +605,16 @@ static struct fontman_services services = {
  ** Module entry point **
  ************************/
 
-static void add_font(struct fontconv_services *conv,void *fontdata,u32 font_id,struct font *dst)
-{
-	dst->font_id = font_id;
-	dst->img_w   = conv->get_image_width(fontdata);
-	dst->img_h   = conv->get_image_height(fontdata);
-	dst->top     = conv->get_top(fontdata);
-	dst->bottom  = conv->get_bottom(fontdata);
-	dst->name    = conv->get_name(fontdata);
-
-	dst->width_table  = zalloc(256*4);
-	dst->offset_table = zalloc(256*4);
-	dst->image = zalloc(dst->img_w*dst->img_h);
-	if (!dst->width_table || !dst->offset_table || !dst->image) {
-		INFO(printf("FontManager(add_font): out of memory, smoke a cigarette\n"));
-		return;
-	}
-	conv->gen_width_table(fontdata, dst->width_table);
-	conv->gen_offset_table(fontdata, dst->offset_table);
-	conv->gen_image(fontdata, dst->image);
-}
-
-
 int init_fontman(struct mtk_services *d)
 {
-	conv_fnt=d->get_module("ConvertFNT 1.0");
-	conv_tff=d->get_module("ConvertTFF 1.0");
+	int i;
 
-	/* init the three built-in fonts */
-	if (conv_tff->probe(&vera16_tff)) add_font(conv_tff,&vera16_tff[0],0,&fonts[0]);
-//	if (conv_fnt->probe(&default_fnt)) add_font(conv_fnt,&default_fnt[0],0,&fonts[0]);
+	conv_tff = d->get_module("ConvertTFF 1.0");
+	cache    = d->get_module("Cache 1.0");
 
-	if (conv_fnt->probe(&mono_fnt))    add_font(conv_fnt,&mono_fnt[0],   1,&fonts[1]);
-	if (conv_fnt->probe(&title_fnt))   add_font(conv_fnt,&title_fnt[0],  2,&fonts[2]);
+	/* the built-in fonts refer to their tables in read-only data */
+	for (i = 0; i < num_builtin_fonts && i < 3; i++)
+		add_font((struct font *)&builtin_fonts[i], builtin_idents[i]);
 
 	d->register_module("FontManager 1.0",&services);
 	return 1;
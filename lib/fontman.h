@@ -13,14 +13,39 @@
 #ifndef _MTK_FONTMAN_H_
 #define _MTK_FONTMAN_H_
 
+/**
+ * Character that is displayed for characters missing in a font
+ */
+#define FONT_REPLACEMENT_CHAR '?'
+
+struct glyph_set;
+
+/**
+ * Font representation
+ *
+ * Fonts with up to 256 characters are described by the width table,
+ * the offset table and the font image. Fonts covering a larger part of
+ * Unicode have a glyph set instead, which provides the glyphs on demand.
+ */
 struct font {
 	s32  font_id;
-	s32 *width_table;
-	s32 *offset_table;
+	const s32 *width_table;
+	const s32 *offset_table;
 	s32  img_w,img_h;
 	s16  top,bottom;
-	u8  *image;
+	const u8 *image;
 	u8  *name;
+	struct glyph_set *glyphs;   /* glyph set or NULL */
+};
+
+
+/**
+ * Glyph image as handed out by get_glyph
+ */
+struct glyph {
+	const u8 *image;   /* alpha values of the glyph */
+	s32       w;       /* width of glyph            */
+	s32       stride;  /* bytes per glyph line      */
 };
 
 
@@ -29,6 +54,58 @@ struct fontman_services {
 	s32          (*calc_str_width)  (s32 font_id, char *str);
 	s32          (*calc_str_height) (s32 font_id, char *str);
 	s32          (*calc_char_idx)   (s32 font_id, char *str, s32 xpos, s32 ypos);
+
+	/**
+	 * Return id of the font with the specified name or -1
+	 */
+	s32          (*lookup)          (char *ident);
+	char        *(*get_ident)       (s32 font_id);
+
+	/**
+	 * Register tff font data, e.g., a memory-mapped file
+	 *
+	 * The font data is referenced, not copied. It must stay valid
+	 * for the lifetime of MTK.
+	 *
+	 * \return  id of the new font or -1 on error
+	 */
+	s32          (*register_tff)    (char *ident, void *tff, u32 size);
+
+	/**
+	 * Load tff file and register it as font
+	 *
+	 * \return  id of the new font or -1 on error
+	 */
+	s32          (*load_tff)        (char *ident, char *path);
+
+	/**
+	 * Register utff font data containing an arbitrary set of Unicode glyphs
+	 *
+	 * The font data is referenced, not copied. Glyphs are decompressed
+	 * into a fixed-size glyph atlas when they are drawn.
+	 *
+	 * \return  id of the new font or -1 on error
+	 */
+	s32          (*register_utff)   (char *ident, void *utff, u32 size);
+
+	/**
+	 * Get image of the glyph of a Unicode character
+	 *
+	 * The glyph image is valid until the next call of get_glyph.
+	 *
+	 * \return  0 on success
+	 */
+	s32          (*get_glyph)       (s32 font_id, u32 ucs, struct glyph *dst);
+
+	/**
+	 * Request lookup statistics of the glyph atlases of all fonts
+	 */
+	void         (*get_atlas_stats) (s32 *hits, s32 *misses);
+
+	/**
+	 * Return pixel width of a Unicode character
+	 */
+	s32          (*calc_char_width) (s32 font_id, u32 ucs);
 };
 
 
@@ -24,13 +24,12 @@ struct frame;
 #include "background.h"
 #include "gfx.h"
 #include "widman.h"
-#include "messenger.h"
+#include "mtklib.h"
 
 static struct gfx_services        *gfx;
 static struct script_services     *script;
 static struct widman_services     *widman;
 static struct scrollbar_services  *scroll;
-static struct messenger_services  *msg;
 static struct background_services *bg;
 
 #define FRAME_MODE_SCRX 0x04    /* horizontal scrollbars               */
@@ -70,7 +69,23 @@ static inline int get_view_h(FRAME *f)
  ** General widget methods **
  ****************************/
 
-static int frame_draw(FRAME *f, struct gfx_ds *ds, int x, int y, WIDGET *origin)
+/**
+ * Check if a child widget intersects the current clipping area
+ *
+ * \param x,y  absolute position of the frame
+ */
+static inline int child_visible(struct gfx_ds *ds, WIDGET *cw, int x, int y)
+{
+	int cx = gfx->get_clip_x(ds), cy = gfx->get_clip_y(ds);
+
+	x += cw->wd->x;
+	y += cw->wd->y;
+	return (x < cx + gfx->get_clip_w(ds)) && (y < cy + gfx->get_clip_h(ds))
+	    && (x + cw->wd->w > cx) && (y + cw->wd->h > cy);
+}
+
+
+static int frame_draw(FRAME *f, struct gfx_ds *ds, int x, int y)
 {
 	WIDGET *cw;
 	s32 vw = get_view_w(f);
@@ -80,27 +95,26 @@ static int frame_draw(FRAME *f, struct gfx_ds *ds, int x, int y, WIDGET *origin)
 	x += f->wd->x;
 	y += f->wd->y;
 
-	if (f == origin) return 1;
-
 	gfx->push_clipping(ds, x, y, vw, vh);
 	cw = f->fd->content;
 
 	/* draw background if there is no or a non-concealing background */
 	if (!cw || !(cw && cw->wd->flags & WID_FLAGS_CONCEALING)) {
-		ret |= f->gen->draw_bg(f, ds, x, y, vw, vh, origin, 0);
+		ret |= f->gen->draw_bg(f, ds, x, y, vw, vh, 0);
 	}
 
 	/* if content exists, draw it */
-	if (cw) ret |= cw->gen->draw(cw, ds, x, y, origin);
+	if (cw && child_visible(ds, cw, x, y)) ret |= cw->gen->draw(cw, ds, x, y);
 	gfx->pop_clipping(ds);
 
-	if (f->fd->corner) ret |= f->fd->corner->gen->draw((WIDGET *)f->fd->corner, ds, x, y, origin);
+	cw = (WIDGET *)f->fd->corner;
+	if (cw && child_visible(ds, cw, x, y)) ret |= cw->gen->draw(cw, ds, x, y);
 
 	/* draw scrollbars */
-	if (f->fd->sb_x)
-		ret |= f->fd->sb_x->gen->draw((WIDGET *)f->fd->sb_x, ds, x, y, origin);
-	if (f->fd->sb_y)
-		ret |= f->fd->sb_y->gen->draw((WIDGET *)f->fd->sb_y, ds, x, y, origin);
+	cw = (WIDGET *)f->fd->sb_x;
+	if (cw && child_visible(ds, cw, x, y)) ret |= cw->gen->draw(cw, ds, x, y);
+	cw = (WIDGET *)f->fd->sb_y;
+	if (cw && child_visible(ds, cw, x, y)) ret |= cw->gen->draw(cw, ds, x, y);
 
 	return ret;
 }
@@ -233,11 +247,7 @@ static void frame_updatepos(FRAME *f)
 	orig_updatepos(f);
 
 	/* send resize event */
-	{
-		char *m = f->gen->get_bind_msg(f, "resize");
-		s32 id = f->gen->get_app_id(f);
-		if (m) msg->send_action_event(id, "resized", m);
-	}
+	f->gen->send_action(f, MTK_BIND_RESIZE, "resized");
 }
 
 static void frame_expose(FRAME *f, s32 x, s32 y);
@@ -575,7 +585,6 @@ int init_frame(struct mtk_services *d)
 	bg      = d->get_module("Background 1.0");
 	gfx     = d->get_module("Gfx 1.0");
 	script  = d->get_module("Script 1.0");
-	msg     = d->get_module("Messenger 1.0");
 
 	/* define general widget functions */
 	widman->default_widget_methods(&gen_methods);
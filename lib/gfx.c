@@ -20,14 +20,18 @@
 #include "mtkstd.h"
 #include "gfx_handler.h"
 #include "gfx.h"
+#include "fontman.h"
 
+static struct fontman_services     *fontman;
 static struct gfx_handler_services *gfxscr_rgb16;
 static struct gfx_handler_services *gfximg_rgb16;
 static struct gfx_handler_services *gfximg_rgba32;
+static struct gfx_raw_handler_services *gfximg_raw;
 
 static struct gfx_ds_handler gfxscr_rgb16_handler;
 static struct gfx_ds_handler gfximg_rgb16_handler;
 static struct gfx_ds_handler gfximg_rgba32_handler;
+static struct gfx_ds_handler gfximg_raw_handler;
 
 int init_gfx(struct mtk_services *d);
 
@@ -57,6 +61,7 @@ static void set_handler_defaults(struct gfx_ds_handler *handler)
 	handler->draw_slice       = (void *)dummy;
 	handler->draw_img         = (void *)dummy;
 	handler->draw_string      = (void *)dummy;
+	handler->draw_mask        = (void *)dummy;
 	handler->push_clipping    = (void *)dummy;
 	handler->pop_clipping     = (void *)dummy;
 	handler->reset_clipping   = (void *)dummy;
@@ -92,8 +97,11 @@ static struct gfx_ds *alloc_scr(void *fb, int width, int height, int depth)
 
 /**
  * Allocate gfx dataspace for images
+ *
+ * If pixels is NULL, a new pixel buffer is allocated. Otherwise,
+ * the image refers to the specified pixel buffer.
  */
-static struct gfx_ds *alloc_img(int w, int h, enum img_type img_type)
+static struct gfx_ds *alloc_ext_img(void *pixels, int w, int h, enum img_type img_type)
 {
 	struct gfx_ds *new;
 
@@ -105,15 +113,23 @@ static struct gfx_ds *alloc_img(int w, int h, enum img_type img_type)
 
 	case GFX_IMG_TYPE_RGBA32:
 		new->handler = &gfximg_rgba32_handler;
-		new->data = gfximg_rgba32->create(NULL, w, h, &new->handler);
+		new->data = gfximg_rgba32->create(pixels, w, h, &new->handler);
 		break;
 
 	case GFX_IMG_TYPE_RGB16:
 		new->handler = &gfximg_rgb16_handler;
-		new->data = gfximg_rgb16->create(NULL, w, h, &new->handler);
+		new->data = gfximg_rgb16->create(pixels, w, h, &new->handler);
+		break;
+
+	case GFX_IMG_TYPE_XRGB32:
+	case GFX_IMG_TYPE_ARGB32:
+	case GFX_IMG_TYPE_YUV422:
+		new->handler = &gfximg_raw_handler;
+		new->data = gfximg_raw->create(pixels, w, h, img_type);
 		break;
 
 	default:
+		free(new);
 		return NULL;
 	}
 
@@ -124,9 +140,22 @@ static struct gfx_ds *alloc_img(int w, int h, enum img_type img_type)
 }
 
 
+static struct gfx_ds *alloc_img(int w, int h, enum img_type img_type)
+{
+	return alloc_ext_img(NULL, w, h, img_type);
+}
+
+
+/**
+ * Load tff font file
+ *
+ * The font is registered under its file name.
+ *
+ * \return  font id or -1 on error
+ */
 static int load_fnt(char *fntname)
 {
-	return 0;
+	return fontman->load_tff(fntname, fntname);
 }
 
 
@@ -182,6 +211,11 @@ static int get_upcnt(struct gfx_ds *ds)
 	return ds->update_cnt;
 }
 
+static void set_filter(struct gfx_ds *ds, enum gfx_filter filter)
+{
+	ds->filter = filter;
+}
+
 static int get_ident(struct gfx_ds *ds, char *dst_ident)
 {
 	return ds->handler->get_ident(ds->data, dst_ident);
@@ -218,6 +252,11 @@ static void draw_string(struct gfx_ds *ds, int x, int y, color_t fg_rgba, color_
 	ds->handler->draw_string(ds->data, x, y , fg_rgba, bg_rgba, font_id, str);
 }
 
+static void draw_mask(struct gfx_ds *ds, int x, int y, const u16 *mask, color_t rgb)
+{
+	ds->handler->draw_mask(ds->data, x, y, mask, rgb);
+}
+
 static void push_clipping(struct gfx_ds *ds, int x, int y, int w, int h)
 {
 	ds->handler->push_clipping(ds->data, x, y, w, h);
@@ -269,14 +308,17 @@ static void set_mouse_pos(struct gfx_ds *ds, int x, int y)
  **************************************/
 
 static struct gfx_services services = {
-	alloc_scr,     alloc_img,  load_fnt,
+	alloc_scr,     alloc_img,  alloc_ext_img,
+	load_fnt,
 	get_width,     get_height, get_type,
 	inc_ref,       dec_ref,
 	map,           unmap,      update,
 	get_ident,
 	get_upcnt,
+	set_filter,
 	draw_hline,    draw_vline, draw_fill,
 	draw_slice,    draw_img,   draw_string,
+	draw_mask,
 	push_clipping,
 	pop_clipping,
 	reset_clipping,
@@ -291,9 +333,11 @@ static struct gfx_services services = {
 
 int init_gfx(struct mtk_services *d)
 {
+	fontman       = d->get_module("FontManager 1.0");
 	gfxscr_rgb16  = d->get_module("GfxScreen16 1.0");
 	gfximg_rgb16  = d->get_module("GfxImage16 1.0");
 	gfximg_rgba32 = d->get_module("GfxImage32 1.0");
+	gfximg_raw    = d->get_module("GfxImageRaw 1.0");
 
 	set_handler_defaults(&gfxscr_rgb16_handler);
 	gfxscr_rgb16->register_gfx_handler(&gfxscr_rgb16_handler);
@@ -304,6 +348,9 @@ int init_gfx(struct mtk_services *d)
 	set_handler_defaults(&gfximg_rgb16_handler);
 	gfximg_rgb16->register_gfx_handler(&gfximg_rgb16_handler);
 
+	set_handler_defaults(&gfximg_raw_handler);
+	gfximg_raw->register_gfx_handler(&gfximg_raw_handler);
+
 	d->register_module("Gfx 1.0", &services);
 	return 1;
 }
@@ -18,6 +18,24 @@ enum img_type {
 	GFX_IMG_TYPE_RGBA32 = 2,
 	GFX_IMG_TYPE_INDEX8 = 3,
 	GFX_IMG_TYPE_NATIVE = 5,
+
+	/*
+	 * Pixel formats of client frames, which are converted while drawing.
+	 * XRGB32 and ARGB32 pixels are 32bit values 0xXXRRGGBB and 0xAARRGGBB.
+	 * YUV422 pixels are stored as byte sequence Y0 U Y1 V for each pair.
+	 */
+	GFX_IMG_TYPE_XRGB32 = 6,
+	GFX_IMG_TYPE_ARGB32 = 7,
+	GFX_IMG_TYPE_YUV422 = 8,
+};
+
+
+/**
+ * Filters used to draw scaled images
+ */
+enum gfx_filter {
+	GFX_FILTER_NEAREST  = 0,
+	GFX_FILTER_BILINEAR = 1,
 };
 
 
@@ -57,6 +75,14 @@ struct gfx_services {
 	GFX_CONTAINER *(*alloc_scr) (void *fb, int width, int height, int depth);
 	GFX_CONTAINER *(*alloc_img) (int w, int h, enum img_type img_type);
 
+	/**
+	 * Create image that refers to existing pixel data
+	 *
+	 * The pixels are not copied. They stay owned by the caller
+	 * and must remain valid until the image is released.
+	 */
+	GFX_CONTAINER *(*alloc_ext_img) (void *pixels, int w, int h, enum img_type img_type);
+
 	int (*load_fnt) (char *fntname);
 
 	int           (*get_width)  (GFX_CONTAINER *);
@@ -71,6 +97,11 @@ struct gfx_services {
 	int   (*get_ident)  (GFX_CONTAINER *, char *dst);
 	int   (*get_upcnt)  (GFX_CONTAINER *);
 
+	/**
+	 * Select filter that is used when the image is drawn scaled
+	 */
+	void  (*set_filter) (GFX_CONTAINER *, enum gfx_filter filter);
+
 	void (*draw_hline) (GFX_CONTAINER *, int x, int y, int w, color_t rgba);
 	void (*draw_vline) (GFX_CONTAINER *, int x, int y, int h, color_t rgba);
 	void (*draw_box)   (GFX_CONTAINER *, int x, int y, int w, int h, color_t rgba);
@@ -84,6 +115,19 @@ struct gfx_services {
 	                                    color_t bg_rgba,
 	                                    int fnt_id, char *str);
 
+	/**
+	 * Blend constant color through a run-length encoded alpha mask
+	 *
+	 * The mask is a sequence of u16 values that describes one row
+	 * after the other. A row starts with the number of screen lines
+	 * that use it, followed by the number of its runs and the runs
+	 * as pairs of length and alpha value (0..255). A line count of
+	 * zero terminates the mask. Runs with alpha 0 are skipped, so
+	 * masks may leave out the interior of a frame at no cost. The
+	 * alpha value of the color is ignored.
+	 */
+	void (*draw_mask)  (GFX_CONTAINER *, int x, int y, const u16 *mask, color_t rgb);
+
 	void (*push_clipping)  (GFX_CONTAINER *, int x, int y, int w, int h);
 	void (*pop_clipping)   (GFX_CONTAINER *);
 	void (*reset_clipping) (GFX_CONTAINER *);
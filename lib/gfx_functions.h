@@ -224,6 +224,234 @@ static void paint_scaled_img_rgba32(int x, int y, int w, int h,
 }
 
 
+/*******************************
+ ** Drawing of client frames **
+ *******************************/
+
+/*
+ * Pixels of client frames are converted to RGB565 while being drawn.
+ * Bilinear filtering works on RGB565 values that are spread over a
+ * 32bit word (0000 0ggg ggg0 0000 rrrr r000 000b bbbb) such that all
+ * three channels are interpolated by one multiplication each, using
+ * 5bit weights.
+ */
+
+#define RAW_MAX_W 256   /* max columns of a client frame drawn at once */
+
+static int raw_xoff[RAW_MAX_W];      /* source column of each screen column */
+static u8  raw_xw[RAW_MAX_W];        /* horizontal filter weight            */
+static u32 raw_row[2][RAW_MAX_W];    /* horizontally filtered source lines  */
+static u8  raw_alpha[2][RAW_MAX_W];  /* alpha values of filtered lines      */
+static int raw_row_tag[2];           /* source line held by raw_row         */
+
+static inline int clamp8(int v) { return v < 0 ? 0 : (v > 255 ? 255 : v); }
+
+static inline u32 spread565(u16 p)  { return (p | ((u32)p << 16)) & 0x07e0f81f; }
+static inline u16 pack565(u32 v)    { return (v & 0xf81f) | ((v >> 16) & 0x07e0); }
+
+/**
+ * Interpolate between two spread RGB565 values, w ranges from 0 to 32
+ */
+static inline u32 lerp565(u32 a, u32 b, int w)
+{
+	return ((a*(32 - w) + b*w) >> 5) & 0x07e0f81f;
+}
+
+
+/**
+ * Fetch pixel x of a client frame line as RGB565 value
+ *
+ * The alpha value is only written for ARGB32 pixels.
+ */
+static inline u16 fetch_raw(int type, const u8 *line, int x, int *alpha)
+{
+	const u8 *yuv;
+	int c, d, e;
+	u32 p;
+
+	switch (type) {
+	case GFX_IMG_TYPE_ARGB32:
+		p = ((const u32 *)line)[x];
+		*alpha = p >> 24;
+		return ((p >> 8) & 0xf800) | ((p >> 5) & 0x07e0) | ((p >> 3) & 0x001f);
+
+	case GFX_IMG_TYPE_XRGB32:
+		p = ((const u32 *)line)[x];
+		return ((p >> 8) & 0xf800) | ((p >> 5) & 0x07e0) | ((p >> 3) & 0x001f);
+
+	case GFX_IMG_TYPE_YUV422:
+
+		/* ITU-R BT.601, both pixels of a pair share U and V */
+		yuv = line + ((x & ~1) << 1);
+		c = 298*(yuv[(x & 1) << 1] - 16) + 128;
+		d = yuv[1] - 128;
+		e = yuv[3] - 128;
+		return ((clamp8((c + 409*e) >> 8) & 0xf8) << 8)
+		     | ((clamp8((c - 100*d - 208*e) >> 8) & 0xfc) << 3)
+		     |  (clamp8((c + 516*d) >> 8) >> 3);
+
+	default:
+		return ((const u16 *)line)[x];
+	}
+}
+
+
+/**
+ * Write pixel with alpha value to screen
+ */
+static inline void put_raw(u16 *dst, u32 color, int alpha)
+{
+	if (alpha == 255) *dst = pack565(color);
+	else if (alpha)   *dst = pack565(lerp565(spread565(*dst), color, (alpha + 4) >> 3));
+}
+
+
+/**
+ * Filter source line horizontally into the specified row buffer
+ */
+static void raw_hfilter(int slot, int type, const u8 *line, int sx, int w)
+{
+	u32 *row = raw_row[slot];
+	u8  *al  = raw_alpha[slot];
+	int  i, a0 = 255, a1 = 255;
+	u32  c0, c1;
+
+	for (i = 0; i < w; i++) {
+		c0 = spread565(fetch_raw(type, line, sx + raw_xoff[i], &a0));
+		if (raw_xw[i]) {
+			c1 = spread565(fetch_raw(type, line, sx + raw_xoff[i] + 1, &a1));
+			row[i] = lerp565(c0, c1, raw_xw[i]);
+			al[i]  = (a0*(32 - raw_xw[i]) + a1*raw_xw[i]) >> 5;
+		} else {
+			row[i] = c0;
+			al[i]  = a0;
+		}
+	}
+}
+
+
+/**
+ * Return row buffer that holds the filtered source line, fill it if needed
+ *
+ * \param keep  row buffer that must not be replaced
+ */
+static inline int raw_get_row(int line, int keep, int type, const u8 *src,
+                              int line_bytes, int sx, int w)
+{
+	int slot;
+
+	if (raw_row_tag[0] == line) return 0;
+	if (raw_row_tag[1] == line) return 1;
+
+	slot = (keep == 0);
+	raw_hfilter(slot, type, src + line*line_bytes, sx, w);
+	raw_row_tag[slot] = line;
+	return slot;
+}
+
+
+/**
+ * Draw up to RAW_MAX_W columns of a scaled client frame
+ *
+ * \param px, py  source position of the first drawn pixel in 16.16 fixed point
+ * \param mx, my  source step per screen pixel in 16.16 fixed point
+ */
+static void paint_raw_cols(pixel_t *dst, int w, int h, int px, int py, int mx, int my,
+                           int line_bytes, int sw, int sh, const u8 *src, int sx,
+                           int type, int filter)
+{
+	int       i, j, a, b, fx, fy, wy, alpha = 255;
+	int       opaque = (type != GFX_IMG_TYPE_ARGB32);
+	const u8 *line;
+
+	if (filter != GFX_FILTER_BILINEAR || (mx == 0x10000 && my == 0x10000)) {
+
+		for (i = 0; i < w; i++, px += mx)
+			raw_xoff[i] = sx + (px >> 16);
+
+		for (j = h; j--; py += my, dst += scr_width) {
+			line = src + (py >> 16)*line_bytes;
+			if (opaque)
+				for (i = 0; i < w; i++)
+					dst[i] = fetch_raw(type, line, raw_xoff[i], &alpha);
+			else
+				for (i = 0; i < w; i++) {
+					u16 c = fetch_raw(type, line, raw_xoff[i], &alpha);
+					put_raw(dst + i, spread565(c), alpha);
+				}
+		}
+		return;
+	}
+
+	/* sample at pixel centers, clamp at the right and bottom edges */
+	for (i = 0; i < w; i++, px += mx) {
+		fx = MAX(px + (mx >> 1) - 0x8000, 0);
+		raw_xoff[i] = fx >> 16;
+		raw_xw[i]   = (fx >> 11) & 31;
+		if (raw_xoff[i] >= sw - 1) {
+			raw_xoff[i] = sw - 1;
+			raw_xw[i]   = 0;
+		}
+	}
+
+	raw_row_tag[0] = raw_row_tag[1] = -1;
+	for (j = h; j--; py += my, dst += scr_width) {
+		fy = MAX(py + (my >> 1) - 0x8000, 0);
+		wy = (fy >> 11) & 31;
+		fy >>= 16;
+		if (fy >= sh - 1) {
+			fy = sh - 1;
+			wy = 0;
+		}
+
+		a = raw_get_row(fy, -1, type, src, line_bytes, sx, w);
+		b = wy ? raw_get_row(fy + 1, a, type, src, line_bytes, sx, w) : a;
+
+		for (i = 0; i < w; i++) {
+			u32 c = lerp565(raw_row[a][i], raw_row[b][i], wy);
+			if (opaque) dst[i] = pack565(c);
+			else put_raw(dst + i, c, (raw_alpha[a][i]*(32 - wy) + raw_alpha[b][i]*wy) >> 5);
+		}
+	}
+}
+
+
+/**
+ * Draw scaled and clipped client frame to screen
+ *
+ * Wide frames are drawn in stripes of at most RAW_MAX_W columns.
+ *
+ * \param line_bytes  distance between two lines of the frame in bytes
+ * \param src         first line of the drawn part of the frame
+ * \param sx          first column of the drawn part of the frame
+ * \param sw, sh      size of the drawn part of the frame
+ */
+static void paint_raw_img(int x, int y, int w, int h, int line_bytes,
+                          int sw, int sh, const u8 *src, int sx, int type, int filter)
+{
+	int      mx, my, cw;
+	int      px = 0, py = 0;
+	pixel_t *dst;
+
+	/* sanity check */
+	if (!src || w <= 0 || h <= 0 || sw <= 0 || sh <= 0) return;
+
+	mx = ((int)sw<<16) / w;
+	my = ((int)sh<<16) / h;
+
+	if (!clip_img(clip_x1, clip_y1, clip_x2, clip_y2,
+	              &x, &y, &w, &h, &px, &py, mx, my)) return;
+
+	/* calculate start address */
+	dst = scr_adr + y*scr_width + x;
+
+	for (; w > 0; w -= cw, dst += cw, px += cw*mx) {
+		cw = MIN(w, RAW_MAX_W);
+		paint_raw_cols(dst, cw, h, px, py, mx, my, line_bytes, sw, sh, src, sx, type, filter);
+	}
+}
+
+
 /***************************
  ** Gfx handler functions **
  ***************************/
@@ -352,7 +580,22 @@ static void scr_draw_slice(struct gfx_ds_data *s, int x, int y, int w, int h,
 	case GFX_IMG_TYPE_RGB16:
 		{
 			pixel_t *src = (pixel_t *)img->handler->map(img->data);
-			paint_scaled_img(x, y, w, h, img_w, sw, sh, src + img_w*sy + sx);
+			if (img->filter == GFX_FILTER_BILINEAR && (w != sw || h != sh))
+				paint_raw_img(x, y, w, h, img_w*2, sw, sh, (u8 *)(src + img_w*sy), sx,
+				              type, img->filter);
+			else
+				paint_scaled_img(x, y, w, h, img_w, sw, sh, src + img_w*sy + sx);
+			break;
+		}
+
+	case GFX_IMG_TYPE_XRGB32:
+	case GFX_IMG_TYPE_ARGB32:
+	case GFX_IMG_TYPE_YUV422:
+		{
+			int line_bytes = img_w*(type == GFX_IMG_TYPE_YUV422 ? 2 : 4);
+			u8 *src = (u8 *)img->handler->map(img->data);
+			paint_raw_img(x, y, w, h, line_bytes, sw, sh, src + line_bytes*sy, sx,
+			              type, img->filter);
 			break;
 		}
 
@@ -381,7 +624,7 @@ static void scr_draw_img(struct gfx_ds_data *s, int x, int y, int w, int h,
 /**
  * Draw line of glyph using anti-aliasing values from the font image
  */
-static inline void draw_glyph_line(u8 *src_alpha, u16 color, u16 *dst, int len)
+static inline void draw_glyph_line(const u8 *src_alpha, u16 color, u16 *dst, int len)
 {
 	int i;
 	for (i = 0; i < len; i++) {
@@ -396,27 +639,68 @@ static inline void draw_glyph_line(u8 *src_alpha, u16 color, u16 *dst, int len)
 }
 
 
+/**
+ * Blend span of pixels with a constant color and alpha value
+ */
+static inline void blend_span(pixel_t *dst, int len, pixel_t color, int alpha)
+{
+	pixel_t mix = blend(color, alpha);
+	int     inv = 255 - alpha;
+
+	if (alpha == 255) {
+		solid_hline(dst, len, color);
+		return;
+	}
+	for (; len--; dst++) *dst = blend(*dst, inv) + mix;
+}
+
+
+static void scr_draw_mask(struct gfx_ds_data *ds, int x, int y, const u16 *mask, color_t rgb)
+{
+	pixel_t color = rgba_to_pixel(rgb);
+	int     lines, runs, i, j, y1, y2;
+
+	for (; (lines = mask[0]) && y <= clip_y2; y += lines, mask += 2 + 2*runs) {
+		runs = mask[1];
+		y1   = MAX(y, clip_y1);
+		y2   = MIN(y + lines - 1, clip_y2);
+
+		for (j = y1; j <= y2; j++) {
+			const u16 *r   = mask + 2;
+			pixel_t   *dst = scr_adr + j*scr_width;
+			int        rx  = x;
+
+			for (i = 0; i < runs && rx <= clip_x2; i++, r += 2) {
+				int x1 = MAX(rx, clip_x1);
+				int x2 = MIN(rx + r[0] - 1, clip_x2);
+				if (r[1] && x1 <= x2)
+					blend_span(dst + x1, x2 - x1 + 1, color, r[1]);
+				rx += r[0];
+			}
+		}
+	}
+}
+
+
 static void scr_draw_string_line(struct gfx_ds_data *ds, int x, int y,
                             color_t fg_rgba, color_t bg_rgba, struct font *font,
                             char *str_signed)
 {
-	s32         *wtab = font->width_table;
-	s32         *otab = font->offset_table;
-	s32         img_w = font->img_w;
 	s32         img_h = font->img_h;
-	pixel_t     *dst = scr_adr + y*scr_width + x;
-	u8          *str = (u8 *)str_signed;
-	u8          *src = font->image;
-	u8          *s;
+	pixel_t     *dst = scr_adr + y*scr_width;
+	const u8    *str = (u8 *)str_signed;
+	const u8    *s;
 	pixel_t     *d;
-	int          j;
-	int          w;
+	struct glyph g;
+	int          j, cx1, cx2;
+	int          skip = 0;
 	int          h = font->img_h;
+	u32          ucs;
 	pixel_t      color = rgba_to_pixel(fg_rgba);
 
 	/* check top clipping */
 	if (y < clip_y1) {
-		src += (clip_y1 - y)*img_w;   /* skip upper lines in font image */
+		skip = clip_y1 - y;           /* skip upper lines in font image */
 		h   -= (clip_y1 - y);         /* decrement number of lines to draw */
 		dst += (clip_y1 - y)*scr_width;
 	}
@@ -427,71 +711,42 @@ static void scr_draw_string_line(struct gfx_ds_data *ds, int x, int y,
 
 	if (h < 1) return;
 
-	/* skip characters that are completely hidden by the left clipping border */
-	while (*str && (*str != '\n') && (x+wtab[(int)(*str)] < clip_x1)) {
-		x+=wtab[(int)(*str)];
-		dst+=wtab[(int)(*str)];
-		str++;
-	}
-
-	/* draw left cutted character */
-	if (*str && (*str != '\n') && (x+wtab[(int)(*str)] - 1 <= clip_x2) && (x < clip_x1)) {
-		w = wtab[(int)(*str)] - (clip_x1 - x);
-		s = src + otab[(int)(*str)] + (clip_x1 - x);
-		d = dst + (clip_x1 - x);
-		for (j = 0; j < h; j++) {
-			draw_glyph_line(s, color, d, w);
-			s = s + img_w;
-			d = d + scr_width;
-		}
-		dst += wtab[(int)(*str)];
-		x   += wtab[(int)(*str)];
-		str++;
-	}
-
-	/* draw horizontally full visible characters */
-	while (*str && (*str != '\n') && (x + wtab[(int)(*str)] - 1 < clip_x2)) {
-		w = wtab[(int)(*str)];
-		s = src + otab[(int)(*str)];
-		d = dst;
-		for (j = 0; j < h; j++) {
-			draw_glyph_line(s, color, d, w);
-			s = s + img_w;
-			d = d + scr_width;
-		}
-		dst += wtab[(int)(*str)];
-		x   += wtab[(int)(*str)];
-		str++;
-	}
-
-	/* draw right cutted character */
-	if (*str && (*str != '\n')) {
-		w = wtab[(int)(*str)];
-		s = src + otab[(int)(*str)];
-		d = dst;
-		if (x + w - 1 > clip_x2) {
-			w -= x + w - 1 - clip_x2;
-		}
-		if (x < clip_x1) {    /* check if character is also left-cutted */
-			w -= clip_x1 - x;
-			s += clip_x1 - x;
-			d += clip_x1 - x;
-		}
-		for (j = 0; j < h; j++) {
-			draw_glyph_line(s, color, d, w);
-			s += img_w;
-			d += scr_width;
+	while (*str && (*str != '\n') && (x <= clip_x2)) {
+		ucs = utf8_decode(&str);
+
+		/* fonts with up to 256 characters are accessed directly */
+		if (!font->glyphs) {
+			if (ucs > 255) ucs = FONT_REPLACEMENT_CHAR;
+			g.w      = font->width_table[ucs];
+			g.image  = font->image + font->offset_table[ucs];
+			g.stride = font->img_w;
+		} else if (fontman->get_glyph(font->font_id, ucs, &g))
+			continue;
+
+		/* draw visible part of the character */
+		cx1 = MAX(x, clip_x1);
+		cx2 = MIN(x + g.w - 1, clip_x2);
+		if (cx1 <= cx2) {
+			s = g.image + skip*g.stride + (cx1 - x);
+			d = dst + cx1;
+			for (j = 0; j < h; j++) {
+				draw_glyph_line(s, color, d, cx2 - cx1 + 1);
+				s += g.stride;
+				d += scr_width;
+			}
 		}
+		x += g.w;
 	}
 }
 
+
 static void scr_draw_string(struct gfx_ds_data *ds, int x, int y,
                             color_t fg_rgba, color_t bg_rgba, int fnt_id,
                             char *str)
 {
 	struct font *font = fontman->get_by_id(fnt_id);
 
-	if (!str) return;
+	if (!str || !font) return;
 	
 	while (*str) {
 		scr_draw_string_line(ds, x, y, fg_rgba, bg_rgba, font, str);
@@ -576,6 +831,7 @@ static int register_gfx_handler(struct gfx_ds_handler *handler)
 	handler->draw_slice     = scr_draw_slice;
 	handler->draw_img       = scr_draw_img;
 	handler->draw_string    = scr_draw_string;
+	handler->draw_mask      = scr_draw_mask;
 	handler->push_clipping  = scr_push_clipping;
 	handler->pop_clipping   = scr_pop_clipping;
 	handler->reset_clipping = scr_reset_clipping;
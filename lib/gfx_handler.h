@@ -23,12 +23,21 @@ struct gfx_handler_services {
 	int (*register_gfx_handler) (struct gfx_ds_handler *handler);
 };
 
+/**
+ * Handler of images whose pixel format is passed at creation
+ */
+struct gfx_raw_handler_services {
+	struct gfx_ds_data *(*create) (void *pixels, int width, int height, enum img_type type);
+	int (*register_gfx_handler) (struct gfx_ds_handler *handler);
+};
+
 struct gfx_ds {
 	struct gfx_ds_handler *handler;   /* ds type dependent handler callbacks  */
 	struct gfx_ds_data    *data;      /* ds type dependent data               */
 	int update_cnt;                   /* update counter (used for ds caching) */
 	int ref_cnt;                      /* reference counter                    */
 	int cache_idx;
+	int filter;                       /* filter used for scaled drawing       */
 };
 
 struct gfx_ds_handler {
@@ -53,6 +62,7 @@ struct gfx_ds_handler {
 	                     struct gfx_ds *img, u8 alpha);
 	void (*draw_string) (struct gfx_ds_data *ds, int x, int y, color_t fg_rgba,
 	                     color_t bg_rgba, int fnt_id, char *str);
+	void (*draw_mask)   (struct gfx_ds_data *ds, int x, int y, const u16 *mask, color_t rgb);
 
 	void (*push_clipping)  (struct gfx_ds_data *ds, int x, int y, int w, int h);
 	void (*pop_clipping)   (struct gfx_ds_data *ds);
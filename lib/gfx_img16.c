@@ -69,6 +69,9 @@ static int img_get_ident(struct gfx_ds_data *img, char *dst_ident)
  ***********************/
 
 
+/**
+ * Create image, use the caller-owned pixel buffer fb if specified
+ */
 static struct gfx_ds_data *create(void *fb, int width, int height, struct gfx_ds_handler **handler)
 {
 	struct gfx_ds_data *new = zalloc(sizeof(struct gfx_ds_data));
@@ -76,6 +79,12 @@ static struct gfx_ds_data *create(void *fb, int width, int height, struct gfx_ds
 
 	new->w      = width;
 	new->h      = height;
+
+	if (fb) {
+		new->pixels = (pixel_t *)fb;
+		return new;
+	}
+
 	new->smb    = shmem->alloc(width*height*sizeof(pixel_t));
 	new->pixels = (pixel_t *)(shmem->get_address(new->smb));
 
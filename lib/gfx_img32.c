@@ -50,6 +50,7 @@ static enum img_type img_get_type(struct gfx_ds_data *img)
 
 static void img_destroy(struct gfx_ds_data *img)
 {
+	shmem->destroy(img->smb);
 	free(img);
 }
 
@@ -70,13 +71,26 @@ static int img_get_ident(struct gfx_ds_data *img, char *dst_ident)
  ***********************/
 
 
+/**
+ * Create image
+ *
+ * If fb is specified, the image refers to the pixels at fb instead
+ * of allocating and clearing a new pixel buffer. The pixel data is
+ * owned by the caller and must outlive the image.
+ */
 static struct gfx_ds_data *create(void *fb, int width, int height, struct gfx_ds_handler **handler)
 {
 	struct gfx_ds_data *new;
-	new = zalloc(sizeof(struct gfx_ds_data) + width*height*4);
+	new = zalloc(sizeof(struct gfx_ds_data));
 	if (!new) return NULL;
 	new->w = width;
 	new->h = height;
+
+	if (fb) {
+		new->pixels = (pixel_t *)fb;
+		return new;
+	}
+
 	new->smb = shmem->alloc(width*height*4);
 	new->pixels = (u32 *)(shmem->get_address(new->smb));
 	if (new->pixels) memset(new->pixels, 0, width*height*4);
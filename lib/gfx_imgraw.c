@@ -0,0 +1,144 @@
+/*
+ * \brief   MTK gfx handler module for images in client pixel formats
+ *
+ * These images hold frames as produced by clients, e.g.,
+ * captured video or the output of a renderer. They cannot
+ * be drawn into. When drawn to the screen, their pixels are
+ * converted on the fly.
+ */
+
+/*
+ * Copyright (C) 2010 Sebastien Bourdeauducq
+ *
+ * This file is part of the MTK package, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+#include <stdlib.h>
+#include "mtkstd.h"
+#include "sharedmem.h"
+#include "gfx_handler.h"
+#include "gfx.h"
+
+static struct sharedmem_services *shmem;
+
+struct gfx_ds_data {
+	int           w, h;     /* width and height of the image */
+	enum img_type type;     /* pixel format                  */
+	SHAREDMEM    *smb;      /* shared memory block or NULL   */
+	void         *pixels;
+};
+
+int init_gfximgraw(struct mtk_services *d);
+
+
+/***************************
+ ** Gfx handler functions **
+ ***************************/
+
+static int img_get_width(struct gfx_ds_data *img)
+{
+	return img->w;
+}
+
+static int img_get_height(struct gfx_ds_data *img)
+{
+	return img->h;
+}
+
+static enum img_type img_get_type(struct gfx_ds_data *img)
+{
+	return img->type;
+}
+
+static void img_destroy(struct gfx_ds_data *img)
+{
+	if (img->smb) shmem->destroy(img->smb);
+	free(img);
+}
+
+static void *img_map(struct gfx_ds_data *img)
+{
+	return img->pixels;
+}
+
+static int img_get_ident(struct gfx_ds_data *img, char *dst_ident)
+{
+	if (!img->smb) return -1;
+	shmem->get_ident(img->smb, dst_ident);
+	return 0;
+}
+
+
+/***********************
+ ** Service functions **
+ ***********************/
+
+/**
+ * Create image, use the caller-owned pixel buffer if specified
+ */
+static struct gfx_ds_data *create(void *pixels, int width, int height, enum img_type type)
+{
+	struct gfx_ds_data *new;
+	int bpp;
+
+	switch (type) {
+	case GFX_IMG_TYPE_XRGB32:
+	case GFX_IMG_TYPE_ARGB32: bpp = 4; break;
+	case GFX_IMG_TYPE_YUV422: bpp = 2; break;
+	default: return NULL;
+	}
+
+	new = zalloc(sizeof(struct gfx_ds_data));
+	if (!new) return NULL;
+
+	new->w    = width;
+	new->h    = height;
+	new->type = type;
+
+	if (pixels) {
+		new->pixels = pixels;
+		return new;
+	}
+
+	new->smb    = shmem->alloc(width*height*bpp);
+	new->pixels = shmem->get_address(new->smb);
+
+	if (new->pixels)
+		memset(new->pixels, 0, width*height*bpp);
+
+	return new;
+}
+
+static int register_gfx_handler(struct gfx_ds_handler *handler)
+{
+	handler->get_width  = img_get_width;
+	handler->get_height = img_get_height;
+	handler->get_type   = img_get_type;
+	handler->destroy    = img_destroy;
+	handler->map        = img_map;
+	handler->get_ident  = img_get_ident;
+	return 0;
+}
+
+
+/**************************************
+ ** Service structure of this module **
+ **************************************/
+
+static struct gfx_raw_handler_services services = {
+	create,
+	register_gfx_handler,
+};
+
+
+/************************
+ ** Module entry point **
+ ************************/
+
+int init_gfximgraw(struct mtk_services *d)
+{
+	shmem = d->get_module("SharedMemory 1.0");
+	d->register_module("GfxImageRaw 1.0", &services);
+	return 1;
+}
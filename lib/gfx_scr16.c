@@ -14,6 +14,7 @@
 #include "scrdrv.h"
 #include "cache.h"
 #include "fontman.h"
+#include "utf8.h"
 #include "clipping.h"
 #include "gfx.h"
 #include "gfx_handler.h"
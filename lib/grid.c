@@ -45,22 +45,26 @@ static struct redraw_services     *redraw;
 
 #define GRID_UPDATE_CELLMAP    0x08
 
-struct section;
+#define SECTIONS_INIT_SIZE 8   /* initial capacity of section arrays */
+
+struct cell;
 struct section {
 	int   fixed;           /* fixed size or -1 (free)           */
 	int   size;            /* row size in pixels                */
 	int   offset;          /* position relative to grid parent  */
 	int   index;           /* index of row/column               */
+	int   pos;             /* position within section array     */
 	int   min;             /* minimal size of section           */
 	int   max;             /* maximal size of section           */
+	int   dirty;           /* min/max must be recalculated      */
+	int   moved;           /* size or offset changed            */
 	WIDGET *minforce;      /* widget that enforced the minsize  */
 	WIDGET *maxforce;      /* widget that enforced the maxsize  */
 	float weight;          /* weight of row/column              */
-	struct section *next;  /* next row/column in connected list */
+	struct cell *cells;    /* cells that start at this section  */
 };
 
 
-struct cell;
 struct cell {
 	struct section *row;     /* first row used by the cell            */
 	struct section *col;     /* first column used be the cell         */
@@ -69,19 +73,36 @@ struct cell {
 	u16 sticky;              /* alignment of widget inside its cell   */
 	s16 pad_x;               /* hor.distance of widget to cell border */
 	s16 pad_y;               /* ver.distance of widget to cell border */
+	u32 seq;                 /* creation order of the cell            */
+	u16 placed;              /* widget position matches the cell      */
 	WIDGET *wid;             /* associated widget                     */
 	struct cell *next;       /* next cell in connected cell-list      */
+	struct cell *row_next;   /* next cell that starts at same row     */
+	struct cell *col_next;   /* next cell that starts at same column  */
 };
 
 
+/*
+ * Rows and columns are kept in arrays that are sorted by the section
+ * index. Each section knows its position within the array. The cellmap
+ * has a capacity of map_rows*map_cols entries and is rebuilt lazily
+ * after the grid structure changed.
+ */
 struct grid_data {
-	struct section *rows;           /* list of rows                  */
-	struct section *cols;           /* list of columns               */
+	struct section **rows;          /* array of rows                 */
+	struct section **cols;          /* array of columns              */
 	int             num_rows;       /* number of rows                */
 	int             num_cols;       /* number of columns             */
+	int             max_rows;       /* capacity of row array         */
+	int             max_cols;       /* capacity of column array      */
 	struct cell    *cells;          /* list of cells                 */
+	u32             num_cells;      /* number of created cells       */
+	struct cell    *last_cell;      /* cell of last get_cell lookup  */
 	struct cell   **cellmap;        /* grid map with cell references */
-	u32             cellmapsize;    /* current size of cellmap       */
+	int             map_rows;       /* capacity of cellmap           */
+	int             map_cols;
+	int             map_valid;      /* cellmap matches cell list     */
+	int             frozen;         /* placement in progress         */
 	u32             update;         /* grid specific update flags    */
 };
 
@@ -99,6 +120,7 @@ void print_grid_info(GRID *g)
 	struct section *sec;
 	struct cell *cc;
 	WIDGET *cw;
+	int i;
 
 	printf("Grid info:\n");
 	if (!g) printf(" grid is zero!\n");
@@ -108,8 +130,8 @@ void print_grid_info(GRID *g)
 	printf(" width  = %d\n", (int)g->wd->w);
 	printf(" height = %d\n", (int)g->wd->h);
 	printf(" row-sections:\n");
-	sec = g->gd->rows;
-	while (sec) {
+	for (i = 0; i < g->gd->num_rows; i++) {
+		sec = g->gd->rows[i];
 		printf("  index: %d\n", sec->index);
 		printf("   offset:%d\n", sec->offset);
 		printf("   size:  %d\n", sec->size);
@@ -118,11 +140,10 @@ void print_grid_info(GRID *g)
 #else
 		printf("   weight:%f\n",  sec->weight);
 #endif
-		sec=sec->next;
 	}
 	printf(" column-sections:\n");
-	sec = g->gd->cols;
-	while (sec) {
+	for (i = 0; i < g->gd->num_cols; i++) {
+		sec = g->gd->cols[i];
 		printf("  index: %d\n", sec->index);
 		printf("   offset:%d\n", sec->offset);
 		printf("   size:  %d\n", sec->size);
@@ -131,7 +152,6 @@ void print_grid_info(GRID *g)
 #else
 		printf("   weight:%f\n",  sec->weight);
 #endif
-		sec = sec->next;
 	}
 	printf(" child-widgets:\n");
 	cc = g->gd->cells;
@@ -158,70 +178,113 @@ void print_grid_info(GRID *g)
 
 
 /**
- * Return the position of an element in a section list
+ * Return the position of a section in its section array
  */
-static inline int get_section_num(struct section *curr, struct section *s)
+static inline int get_section_num(struct section *s)
 {
-	int i;
-	for (i=0; curr; i++) {
-		if (curr == s) return i;
-		curr = curr->next;
-	}
-	return 0;
+	return s ? s->pos : 0;
 }
 
 
 /**
  * Set element of the cellmap
+ *
+ * If the cellmap could not grow with the grid, positions beyond its
+ * capacity are ignored.
  */
 static void cellmap_set(GRID *g, int x, int y, struct cell *value)
 {
-	/* check agains grid boundaries */
-	if (x >= g->gd->num_cols) return;
-	if (y >= g->gd->num_rows) return;
+	if (x < 0 || x >= g->gd->map_cols) return;
+	if (y < 0 || y >= g->gd->map_rows) return;
 
-	g->gd->cellmap[y*g->gd->num_cols + x] = value;
+	g->gd->cellmap[y*g->gd->map_cols + x] = value;
+}
+
+
+/**
+ * Get element of the cellmap
+ *
+ * \return  cell at the position or NULL
+ */
+static inline struct cell *cellmap_get(GRID *g, int x, int y)
+{
+	if (x < 0 || x >= g->gd->map_cols) return NULL;
+	if (y < 0 || y >= g->gd->map_rows) return NULL;
+
+	return g->gd->cellmap[y*g->gd->map_cols + x];
 }
 
 
 /**
  * Insert references to cells into cellmap
  */
-static inline void update_cellmap(GRID *g)
+static void update_cellmap(GRID *g)
 {
 	struct cell *curr = g->gd->cells;
 	int i, j;
 
-	memset(g->gd->cellmap, 0, g->gd->num_rows * g->gd->num_cols * sizeof(struct cell *));
+	if (!g->gd->cellmap) return;
+
+	memset(g->gd->cellmap, 0, g->gd->map_rows * g->gd->map_cols * sizeof(struct cell *));
 	while (curr) {
 		for (j=0; j<curr->row_span; j++) for (i=0; i<curr->col_span; i++) {
-			cellmap_set(g, get_section_num(g->gd->cols, curr->col) + i,
-		                   get_section_num(g->gd->rows, curr->row) + j, curr);
+			cellmap_set(g, get_section_num(curr->col) + i,
+		                   get_section_num(curr->row) + j, curr);
 		}
 		curr = curr->next;
 	}
+	g->gd->map_valid = 1;
+}
+
+
+/**
+ * Make sure that the cellmap reflects the current cell placement
+ */
+static inline void validate_cellmap(GRID *g)
+{
+	if (!g->gd->map_valid) update_cellmap(g);
+}
+
+
+/**
+ * Mark cellmap as outdated after the placement of a cell changed
+ */
+static inline void invalidate_cellmap(GRID *g)
+{
+	g->gd->update   |= GRID_UPDATE_CELLMAP;
+	g->gd->map_valid = 0;
 }
 
 
 /**
  * Reallocate cellmap
  *
- * This function must be called if the number of cells or
- * rows changes.
+ * This function must be called if the number of rows or columns
+ * changes. The capacity of the cellmap grows geometrically to
+ * prevent reallocations when rows or columns are added one by one.
  */
 static void realloc_cellmap(GRID *g)
 {
-	s32 map_size = g->gd->num_rows * g->gd->num_cols;
+	int map_rows = g->gd->map_rows, map_cols = g->gd->map_cols;
+	struct cell **new;
+
+	g->gd->map_valid = 0;
 
 	/* check if there is enough space in current cellmap */
-	if (map_size > g->gd->cellmapsize) {
+	if (g->gd->num_rows <= map_rows && g->gd->num_cols <= map_cols) return;
+
+	while (map_rows < g->gd->num_rows) map_rows = map_rows ? 2*map_rows : SECTIONS_INIT_SIZE;
+	while (map_cols < g->gd->num_cols) map_cols = map_cols ? 2*map_cols : SECTIONS_INIT_SIZE;
 
-		/* allocate new cellmap in a greedy way to prevent instand reallocations */
-		if (g->gd->cellmap) free(g->gd->cellmap);
-		g->gd->cellmapsize = 2 * map_size;
-		g->gd->cellmap = (struct cell **)zalloc(g->gd->cellmapsize * sizeof(struct cell *));
+	new = (struct cell **)zalloc(map_rows * map_cols * sizeof(struct cell *));
+	if (!new) {
+		INFO(printf("Grid(realloc_cellmap): out of memory!\n");)
+		return;
 	}
-	update_cellmap(g);
+	if (g->gd->cellmap) free(g->gd->cellmap);
+	g->gd->cellmap  = new;
+	g->gd->map_rows = map_rows;
+	g->gd->map_cols = map_cols;
 }
 
 
@@ -243,58 +306,77 @@ static struct section *new_section(u32 index)
 	new->offset = 0;
 	new->index  = index;
 	new->weight = 1.0;
-	new->next   = NULL;
+	new->dirty  = 1;
+	new->moved  = 1;
 	return new;
 }
 
 
 /**
- * Return section structure by its index
+ * Find position of a section index in a section array
  *
- * \return  section struct or NULL if there is no section with such index
+ * \return  position of the section or the position where a
+ *          section with this index must be inserted
  */
-static struct section *get_section(struct section *curr, s32 idx)
+static int find_section_pos(struct section **secs, int num, s32 idx)
 {
-	while (curr) {
-		if (curr->index == idx) return curr;
-		curr = curr->next;
+	int lo = 0, hi = num, mid;
+
+	/* shortcut for densely numbered sections */
+	if (idx >= 0 && idx < num && secs[idx]->index == idx) return idx;
+
+	while (lo < hi) {
+		mid = (lo + hi) >> 1;
+		if (secs[mid]->index < idx) lo = mid + 1;
+		else hi = mid;
 	}
-	return NULL;
+	return lo;
 }
 
 
 /**
- * Creates a new section and inserts it into section list
+ * Return section structure by its index
  *
- * \param head   head of destination section list
- * \return       newly created section or NULL if section could not be created
+ * \return  section struct or NULL if there is no section with such index
  */
-static struct section *insert_section(struct section **head, s32 idx)
+static struct section *get_section(struct section **secs, int num, s32 idx)
 {
-	struct section *new = new_section(idx);
-	struct section *curr;
-
-	if (!new) return NULL;
+	int pos = find_section_pos(secs, num, idx);
+	return (pos < num && secs[pos]->index == idx) ? secs[pos] : NULL;
+}
 
-	/* if section list has no elements yet, set first element */
-	if (*head == NULL) return *head = new;
 
-	/* if index of first element is higher than new index */
-	if ((*head)->index > idx) {
-		new->next = *head;
-		return *head = new;
+/**
+ * Creates a new section and inserts it into section array
+ *
+ * \param secs   destination section array
+ * \param num    number of sections in the array
+ * \param max    capacity of the array
+ * \return       newly created section or NULL if section could not be created
+ */
+static struct section *insert_section(struct section ***secs, int *num, int *max, s32 idx)
+{
+	struct section *new, **new_secs;
+	int pos, i;
+
+	/* grow section array geometrically */
+	if (*num == *max) {
+		int new_max = *max ? 2*(*max) : SECTIONS_INIT_SIZE;
+		new_secs = realloc(*secs, new_max*sizeof(struct section *));
+		if (!new_secs) return NULL;
+		*secs = new_secs;
+		*max  = new_max;
 	}
 
-	/* search for the needed index */
-	curr = *head;
-	while (curr->next) {
-		if (curr->next->index > idx) break;
-		curr = curr->next;
-	}
+	if (!(new = new_section(idx))) return NULL;
 
-	/* insert new element */
-	new->next = curr->next;
-	return curr->next = new;
+	pos = find_section_pos(*secs, *num, idx);
+	memmove(*secs + pos + 1, *secs + pos, (*num - pos)*sizeof(struct section *));
+	(*secs)[pos] = new;
+	(*num)++;
+
+	for (i = pos; i < *num; i++) (*secs)[i]->pos = i;
+	return new;
 }
 
 
@@ -305,13 +387,10 @@ static struct section *insert_section(struct section **head, s32 idx)
  */
 static struct section *get_row(GRID *g, s32 row_idx)
 {
-	struct section *ret = get_section(g->gd->rows, row_idx);
+	struct section *ret = get_section(g->gd->rows, g->gd->num_rows, row_idx);
 	if (!ret) {
-		ret = insert_section(&g->gd->rows, row_idx);
-		if (ret) {
-			g->gd->num_rows++;
-			realloc_cellmap(g);
-		}
+		ret = insert_section(&g->gd->rows, &g->gd->num_rows, &g->gd->max_rows, row_idx);
+		if (ret) realloc_cellmap(g);
 	}
 	return ret;
 }
@@ -324,18 +403,78 @@ static struct section *get_row(GRID *g, s32 row_idx)
  */
 static struct section *get_column(GRID *g, s32 col_idx)
 {
-	struct section *ret = get_section(g->gd->cols, col_idx);
+	struct section *ret = get_section(g->gd->cols, g->gd->num_cols, col_idx);
 	if (!ret) {
-		ret = insert_section(&g->gd->cols, col_idx);
-		if (ret) {
-			g->gd->num_cols++;
-			realloc_cellmap(g);
-		}
+		ret = insert_section(&g->gd->cols, &g->gd->num_cols, &g->gd->max_cols, col_idx);
+		if (ret) realloc_cellmap(g);
 	}
 	return ret;
 }
 
 
+/**
+ * Link cell into the cell list of its row or column
+ *
+ * The list is ordered like the cell list of the grid, newest cells
+ * first, such that the min/max calculation visits the cells in the
+ * same order.
+ */
+static void link_cell(struct section *s, struct cell *c, int is_row)
+{
+	struct cell **pp = &s->cells;
+
+	while (*pp && (*pp)->seq > c->seq)
+		pp = is_row ? &(*pp)->row_next : &(*pp)->col_next;
+
+	if (is_row) c->row_next = *pp;
+	else        c->col_next = *pp;
+	*pp = c;
+	s->dirty = 1;
+}
+
+
+static void unlink_cell(struct section *s, struct cell *c, int is_row)
+{
+	struct cell **pp = &s->cells;
+
+	while (*pp && *pp != c)
+		pp = is_row ? &(*pp)->row_next : &(*pp)->col_next;
+
+	if (*pp) *pp = is_row ? c->row_next : c->col_next;
+	s->dirty = 1;
+}
+
+
+/**
+ * Assign row or column to cell
+ */
+static void set_cell_row(struct cell *c, struct section *row)
+{
+	if (c->row) unlink_cell(c->row, c, 1);
+	c->row = row;
+	if (c->row) link_cell(c->row, c, 1);
+}
+
+
+static void set_cell_col(struct cell *c, struct section *col)
+{
+	if (c->col) unlink_cell(c->col, c, 0);
+	c->col = col;
+	if (c->col) link_cell(c->col, c, 0);
+}
+
+
+/**
+ * Mark row and column of a cell for min/max recalculation
+ */
+static inline void touch_cell(struct cell *c)
+{
+	if (c->row) c->row->dirty = 1;
+	if (c->col) c->col->dirty = 1;
+	c->placed = 0;
+}
+
+
 /**
  * Returns the grid-cell that is associated with a given widget
  */
@@ -344,9 +483,13 @@ static struct cell *get_cell(GRID *g, WIDGET *w)
 	struct cell *curr;
 	if (!g || !w) return NULL;
 	if (w->gen->get_parent(w) != g) return NULL;
+
+	/* subsequent calls usually refer to the same widget, e.g., in 'place' */
+	if (g->gd->last_cell && g->gd->last_cell->wid == w) return g->gd->last_cell;
+
 	curr = g->gd->cells;
 	while (curr) {
-		if (curr->wid == w) return curr;
+		if (curr->wid == w) return g->gd->last_cell = curr;
 		curr = curr->next;
 	}
 	return NULL;
@@ -356,39 +499,42 @@ static struct cell *get_cell(GRID *g, WIDGET *w)
 /**
  * Calculate the sizes of rows/columns-sections
  *
- * \param seclist     begin of section list
+ * \param secs        section array
+ * \param num_secs    number of sections
  * \param sum_size    desired overall size
- * \param num_secs    max.number of sections to modify
  */
-static void  calc_section_sizes(struct section *seclist,
-                                s32 sum_size, u32 num_secs) {
+static void calc_section_sizes(struct section **secs, int num_secs, s32 sum_size)
+{
 	struct section *curr;
 	float sum_weights  = 0.0;
 	s32   sum_weighted = sum_size;
+	s32   old_size[num_secs ? num_secs : 1];
 	s32   i;
 
 	/* sum weights of weighted sections */
-	for (curr=seclist, i=num_secs; (i--) && (curr); ) {
+	for (i = 0; i < num_secs; i++) {
+		curr = secs[i];
+		old_size[i] = curr->size;
 		if (curr->fixed < 0) {
 			curr->size = -1;
 			sum_weights += curr->weight;
 		}
-		curr = curr->next;
 	}
 
 	/* define sections with fixed sizes and sum fixed sizes */
-	for (curr=seclist, i=num_secs; (i--) && (curr); ) {
+	for (i = 0; i < num_secs; i++) {
+		curr = secs[i];
 		if (curr->fixed >= 0) {
 			curr->size = curr->fixed;
 			if (curr->size < curr->min) curr->size = curr->min;
 			if (curr->size > curr->max) curr->size = curr->max;
 			sum_weighted -= curr->size;
 		}
-		curr = curr->next;
 	}
 
 	/* enforce max constrains to weighted sections */
-	for (curr=seclist, i=num_secs; (i--) && (curr); ) {
+	for (i = 0; i < num_secs; ) {
+		curr = secs[i];
 		if (curr->size == -1) {
 			int size = (sum_weighted*curr->weight)/sum_weights;
 			if (size > curr->max) {
@@ -397,16 +543,16 @@ static void  calc_section_sizes(struct section *seclist,
 				sum_weights  -= curr->weight;
 
 				/* weights changed - so lets restart from the beginning of the list */
-				curr = seclist;
-				i = num_secs;
+				i = 0;
 				continue;
 			}
 		}
-		curr = curr->next;
+		i++;
 	}
 
 	/* apply min constrains to weighted sections */
-	for (curr=seclist, i=num_secs; (i--) && (curr); ) {
+	for (i = 0; i < num_secs; ) {
+		curr = secs[i];
 		if (curr->size == -1) {
 			int size = (sum_weighted*curr->weight)/sum_weights;
 			if (size < curr->min) {
@@ -415,16 +561,16 @@ static void  calc_section_sizes(struct section *seclist,
 				sum_weights  -= curr->weight;
 
 				/* weights changed - so lets restart from the beginning of the list */
-				curr = seclist;
-				i = num_secs;
+				i = 0;
 				continue;
 			}
 		}
-		curr = curr->next;
+		i++;
 	}
 
 	/* balance remaining weighted sections */
-	for (curr=seclist, i=num_secs; (i--) && (curr); ) {
+	for (i = 0; i < num_secs; i++) {
+		curr = secs[i];
 		if (curr->size == -1) {
 
 			/*
@@ -436,7 +582,7 @@ static void  calc_section_sizes(struct section *seclist,
 			sum_weighted -= curr->size;
 			sum_weights  -= curr->weight;
 		}
-		curr = curr->next;
+		if (curr->size != old_size[i]) curr->moved = 1;
 	}
 }
 
@@ -444,14 +590,15 @@ static void  calc_section_sizes(struct section *seclist,
 /**
  * Calculate offsets of sections relative to the first section
  */
-static void calc_section_offsets(struct section *curr)
+static void calc_section_offsets(struct section **secs, int num_secs)
 {
 	s32 curr_offset = 0;
-	if (!curr) return;
-	while (curr) {
-		curr->offset = curr_offset;
-		curr_offset = curr_offset + curr->size;
-		curr = curr->next;
+	int i;
+
+	for (i = 0; i < num_secs; i++) {
+		if (secs[i]->offset != curr_offset) secs[i]->moved = 1;
+		secs[i]->offset = curr_offset;
+		curr_offset += secs[i]->size;
 	}
 }
 
@@ -459,23 +606,50 @@ static void calc_section_offsets(struct section *curr)
 /**
  * Return size of the specified number of neighbour sections
  */
-static s32 get_section_size(struct section *curr, u32 num_sections)
+static s32 get_section_size(struct section **secs, int num_secs,
+                            struct section *curr, u32 num_sections)
 {
+	s32 size;
+	int i;
+
 	if (!curr || !num_sections) return 0;
-	if (num_sections > 1)
-		return curr->size + get_section_size(get_section(curr, curr->index+1), num_sections-1);
-	else
-		return curr->size;
+
+	size = curr->size;
+	for (i = curr->pos + 1; --num_sections && i < num_secs; i++) {
+		if (secs[i]->index != secs[i - 1]->index + 1) break;
+		size += secs[i]->size;
+	}
+	return size;
+}
+
+
+/**
+ * Return true if one of the specified neighbour sections changed
+ */
+static int sections_moved(struct section **secs, int num_secs,
+                          struct section *curr, u32 num_sections)
+{
+	int i;
+
+	if (!curr || !num_sections) return 0;
+	if (curr->moved) return 1;
+
+	for (i = curr->pos + 1; --num_sections && i < num_secs; i++) {
+		if (secs[i]->index != secs[i - 1]->index + 1) break;
+		if (secs[i]->moved) return 1;
+	}
+	return 0;
 }
 
 
 /**
  * Calculate sum of section min sizes
  */
-static s32 get_sections_minsum(struct section *s)
+static s32 get_sections_minsum(struct section **secs, int num_secs)
 {
 	s32 min = 0;
-	while (s) { min += s->min; s = s->next; }
+	int i;
+	for (i = 0; i < num_secs; i++) min += secs[i]->min;
 	return min;
 }
 
@@ -483,10 +657,11 @@ static s32 get_sections_minsum(struct section *s)
 /**
  * Calculate sum of section max sizes
  */
-static s32 get_sections_maxsum(struct section *s)
+static s32 get_sections_maxsum(struct section **secs, int num_secs)
 {
 	s32 max = 0;
-	while (s) { max += s->max; s = s->next; }
+	int i;
+	for (i = 0; i < num_secs; i++) max += secs[i]->max;
 	return max;
 }
 
@@ -540,31 +715,44 @@ static void position_widget(WIDGET *w, int cx, int cy, int cw, int ch, int stick
 
 /**
  * Set positions of grid widgets to its cells positions
+ *
+ * Only widgets whose cell changed or whose rows or columns
+ * moved since the last call are positioned again.
  */
 static void place_widgets(GRID *g)
 {
+	struct grid_data *gd = g->gd;
 	struct cell *cc;        /* current cell */
 	WIDGET *cw;             /* current widget */
 	s32 cell_x, cell_y, cell_w, cell_h;
+	int i;
 
-	cc = g->gd->cells;
+	cc = gd->cells;
 	while (cc) {
-		if (cc->col && cc->row) {
+		if (cc->col && cc->row
+		 && (!cc->placed
+		  || sections_moved(gd->cols, gd->num_cols, cc->col, cc->col_span)
+		  || sections_moved(gd->rows, gd->num_rows, cc->row, cc->row_span))) {
 			cell_x = cc->col->offset + cc->pad_x;
 			cell_y = cc->row->offset + cc->pad_y;
-			cell_w = get_section_size(cc->col, cc->col_span) - (float)(2*cc->pad_x);
-			cell_h = get_section_size(cc->row, cc->row_span) - (float)(2*cc->pad_y);
+			cell_w = get_section_size(gd->cols, gd->num_cols, cc->col, cc->col_span) - (float)(2*cc->pad_x);
+			cell_h = get_section_size(gd->rows, gd->num_rows, cc->row, cc->row_span) - (float)(2*cc->pad_y);
 			cw = cc->wid;
 			if (cw) position_widget(cw, cell_x, cell_y, cell_w, cell_h, cc->sticky);
+			cc->placed = 1;
 		}
 		cc = cc->next;
 	}
+
+	for (i = 0; i < gd->num_cols; i++) gd->cols[i]->moved = 0;
+	for (i = 0; i < gd->num_rows; i++) gd->rows[i]->moved = 0;
 }
 
 /**
  * Calculate range of sections that are visible at a specified pixel range
  *
- * \param cs    list of sections
+ * \param secs  section array
+ * \param num   number of sections
  * \param min   start of visible pixel range
  * \param max   end of visible pixel range
  * \param beg   result: index of first visible section
@@ -572,26 +760,53 @@ static void place_widgets(GRID *g)
  * \returns     1 if there are visible sections,
  *              0 if range does not contain any visible sections
  */
-static inline int calc_visible_sections(struct section *cs, int min, int max,
-                                        int *beg, int *end) {
-	int i = 0;
-
-	/* skip invisible sections at the beginning of section list */
-	for (; cs && (cs->offset + cs->size < min); cs = cs->next, i++);
-	if (!cs) return 0;
-	*beg = i;
+static inline int calc_visible_sections(struct section **secs, int num,
+                                        int min, int max, int *beg, int *end) {
+	int lo = 0, hi = num, mid;
+
+	/* skip invisible sections at the beginning of section array */
+	while (lo < hi) {
+		mid = (lo + hi) >> 1;
+		if (secs[mid]->offset + secs[mid]->size < min) lo = mid + 1;
+		else hi = mid;
+	}
+	if (lo == num) return 0;
+	*beg = lo;
 
 	/* search last visible section */
-	for (; cs && (cs->offset < max); cs = cs->next, i++);
+	hi = num;
+	while (lo < hi) {
+		mid = (lo + hi) >> 1;
+		if (secs[mid]->offset < max) lo = mid + 1;
+		else hi = mid;
+	}
 
-	/* i is the index after the last visible section */
-	*end = i - 1;
+	/* lo is the index after the last visible section */
+	*end = lo - 1;
 	if (*beg > *end) return 0;
 
 	return 1;
 }
 
 
+/**
+ * Return position of the section that contains the specified pixel
+ *
+ * \return  section position or -1 if no section contains the pixel
+ */
+static int find_section_at(struct section **secs, int num, int pixel)
+{
+	int lo = 0, hi = num, mid;
+
+	while (lo < hi) {
+		mid = (lo + hi) >> 1;
+		if (secs[mid]->offset + secs[mid]->size <= pixel) lo = mid + 1;
+		else hi = mid;
+	}
+	return (lo < num && secs[lo]->offset <= pixel) ? lo : -1;
+}
+
+
 /**
  * Utility: remove widgets that are in the area as the specified cell
  *
@@ -599,18 +814,17 @@ static inline int calc_visible_sections(struct section *cs, int min, int max,
  */
 static void erase_overlapping_cells(GRID *g, struct cell *new)
 {
-	struct cell *cc = g->gd->cells;
+	struct cell *cc;
 	if (!new || !new->row || !new->col) return;
 
 	/* remove widgets that occupy the same grid position */
+	cc = new->row->cells;
 	while (cc) {
-		struct cell *nc = cc->next;
+		struct cell *nc = cc->row_next;
 
-		if ((cc->row) && (cc->row->index == new->row->index)
-		 && (cc->col) && (cc->col->index == new->col->index)
-		 && (cc->wid) && (cc->wid != new->wid)) {
+		if ((cc->col == new->col) && (cc->wid) && (cc->wid != new->wid)) {
 			g->grid->remove(g, cc->wid);
-			g->gd->update |= GRID_UPDATE_CELLMAP;
+			invalidate_cellmap(g);
 		}
 		cc = nc;
 	}
@@ -622,7 +836,7 @@ static void erase_overlapping_cells(GRID *g, struct cell *new)
  ****************************/
 
 
-static int grid_draw(GRID *g, struct gfx_ds *ds, int x, int y, WIDGET *origin)
+static int grid_draw(GRID *g, struct gfx_ds *ds, int x, int y)
 {
 	s32  cx1 = gfx->get_clip_x(ds);
 	s32  cy1 = gfx->get_clip_y(ds);
@@ -635,18 +849,19 @@ static int grid_draw(GRID *g, struct gfx_ds *ds, int x, int y, WIDGET *origin)
 	int  i, j;
 	int  ret = 0;
 
-	if (origin == g) return 1;
 	if ((cx1 > cx2) || (cy1 > cy2)) return 0;
 
 	x += g->wd->x;
 	y += g->wd->y;
 
+	validate_cellmap(g);
+
 	/* determine visible cells of the grid */
-	if (!calc_visible_sections(g->gd->cols, cx1-x, cx2-x, &col_beg, &col_end)
-	 || !calc_visible_sections(g->gd->rows, cy1-y, cy2-y, &row_beg, &row_end)) {
+	if (!calc_visible_sections(g->gd->cols, g->gd->num_cols, cx1-x, cx2-x, &col_beg, &col_end)
+	 || !calc_visible_sections(g->gd->rows, g->gd->num_rows, cy1-y, cy2-y, &row_beg, &row_end)) {
 
 		/* if there are no visible sections at all we just draw the background */
-		ret |= g->gen->draw_bg(g, ds, cx1, cy1, cx2 - cx1 + 1, cy2 - cy1 + 1, origin, 0);
+		ret |= g->gen->draw_bg(g, ds, cx1, cy1, cx2 - cx1 + 1, cy2 - cy1 + 1, 0);
 		return ret;
 	}
 
@@ -663,7 +878,7 @@ static int grid_draw(GRID *g, struct gfx_ds *ds, int x, int y, WIDGET *origin)
 		for (i = col_beg, cx = cx1; i <= col_end; i++) {
 
 			/* fetch current cell from cell map, skip empty positions */
-			cc = g->gd->cellmap[g->gd->num_cols*j + i];
+			cc = cellmap_get(g, i, j);
 			if (!cc || !cc->wid || !cc->col || !cc->row) continue;
 
 			/* determine cell area */
@@ -677,7 +892,7 @@ static int grid_draw(GRID *g, struct gfx_ds *ds, int x, int y, WIDGET *origin)
 			 * above the current row is filled with background.
 			 */
 			if ((cx == cx1) && (cy != y1)) {
-				ret |= g->gen->draw_bg(g, ds, cx1, cy, cx2 - cx1 + 1, y1 - cy + 1, origin, 0);
+				ret |= g->gen->draw_bg(g, ds, cx1, cy, cx2 - cx1 + 1, y1 - cy + 1, 0);
 				cy = y1;
 			}
 
@@ -701,35 +916,35 @@ static int grid_draw(GRID *g, struct gfx_ds *ds, int x, int y, WIDGET *origin)
 				if (r < 0) r = 0;
 
 				/* fill background from last cursor position to left widget border */
-				ret |= g->gen->draw_bg(g, ds, cx, y1, x1 + l - cx, y2 - y1 + 1, origin, 0);
+				ret |= g->gen->draw_bg(g, ds, cx, y1, x1 + l - cx, y2 - y1 + 1, 0);
 
 				/* fill gaps at top and bottom with background */
-				if (t) ret |= g->gen->draw_bg(g, ds, x1 + l, y1, x2 - x1 + 1 - l - r, t, origin, 0);
-				if (b) ret |= g->gen->draw_bg(g, ds, x1 + l, y2 - b + 1, x2 - x1 + 1 - l - r, b, origin, 0);
+				if (t) ret |= g->gen->draw_bg(g, ds, x1 + l, y1, x2 - x1 + 1 - l - r, t, 0);
+				if (b) ret |= g->gen->draw_bg(g, ds, x1 + l, y2 - b + 1, x2 - x1 + 1 - l - r, b, 0);
 
 				/* set cursor to right border of widget */
 				cx = x2 - r + 1;
 
 			/* draw background for non-concealing widgets */
 			} else {
-				ret |= g->gen->draw_bg(g, ds, cx, y1, x2 - cx + 1, y2 - y1 + 1, origin, 0);
+				ret |= g->gen->draw_bg(g, ds, cx, y1, x2 - cx + 1, y2 - y1 + 1, 0);
 				cx = x2 + 1;
 			}
 
 			gfx->push_clipping(ds, x1, y1, x2 - x1 + 1, y2 - y1 + 1);
-			ret |= cc->wid->gen->draw(cc->wid, ds, x, y, origin);
+			ret |= cc->wid->gen->draw(cc->wid, ds, x, y);
 			gfx->pop_clipping(ds);
 		}
 
 		/* draw background at the right of the last cell of current row */
 		if (cx != cx1) {
-			ret |= g->gen->draw_bg(g, ds, cx, y1, cx2 - cx, y2 - y1 + 1, origin, 0);
+			ret |= g->gen->draw_bg(g, ds, cx, y1, cx2 - cx, y2 - y1 + 1, 0);
 			cy = y2 + 1;
 		}
 	}
 
 	/* draw background at the bottom of the last row */
-	ret |= g->gen->draw_bg(g, ds, cx1, cy, cx2 - cx1 + 1, cy2 - cy, origin, 0);
+	ret |= g->gen->draw_bg(g, ds, cx1, cy, cx2 - cx1 + 1, cy2 - cy, 0);
 
 	return ret;
 }
@@ -738,37 +953,41 @@ static int grid_draw(GRID *g, struct gfx_ds *ds, int x, int y, WIDGET *origin)
 static WIDGET *grid_find(GRID *g, int x, int y)
 {
 	struct cell *cc;
-	WIDGET *cw;
 	WIDGET *result;
+	int col, row;
 
 	x -= g->wd->x;
 	y -= g->wd->y;
 
 	/* check if position is inside the window */
-	if ((x >= 0) && (y >= 0) && (x < g->wd->w) && (y < g->wd->h)) {
+	if ((x < 0) || (y < 0) || (x >= g->wd->w) || (y >= g->wd->h)) return NULL;
 
-		/* go through all cells and check their widgets */
-		cc = g->gd->cells;
-		while (cc) {
-			cw = cc->wid;
-			if (cw) {
-				result = cw->gen->find(cw, x, y);
-				if (result) return result;
-			}
-			cc = cc->next;
-		}
-		return g;
-	}
-	return NULL;
+	/*
+	 * Widgets do not exceed their cells. So we look up the
+	 * cell at the position instead of asking all widgets.
+	 */
+	validate_cellmap(g);
+	col = find_section_at(g->gd->cols, g->gd->num_cols, x);
+	row = find_section_at(g->gd->rows, g->gd->num_rows, y);
+	if (!g->gd->cellmap || col < 0 || row < 0) return g;
+
+	cc = cellmap_get(g, col, row);
+	if (cc && cc->wid && (result = cc->wid->gen->find(cc->wid, x, y)))
+		return result;
+
+	return g;
 }
 
 
 /**
  * Update cellmap when placement changed
+ *
+ * While the grid is frozen, updates are deferred until 'thaw'.
  */
 static void (*orig_update) (GRID *);
 static void grid_update(GRID *g)
 {
+	if (g->gd->frozen) return;
 	if (g->gd->update & GRID_UPDATE_CELLMAP) {
 		g->wd->update |= WID_UPDATE_MINMAX;
 		update_cellmap(g);
@@ -787,12 +1006,12 @@ static void (*orig_updatepos) (GRID *g);
 static void grid_updatepos(GRID *g)
 {
 	/* calculate sizes of rows/columns */
-	calc_section_sizes(g->gd->cols, g->wd->w, 99999);
-	calc_section_sizes(g->gd->rows, g->wd->h, 99999);
+	calc_section_sizes(g->gd->cols, g->gd->num_cols, g->wd->w);
+	calc_section_sizes(g->gd->rows, g->gd->num_rows, g->wd->h);
 
 	/* calculate offsets of rows/columns */
-	calc_section_offsets(g->gd->cols);
-	calc_section_offsets(g->gd->rows);
+	calc_section_offsets(g->gd->cols, g->gd->num_cols);
+	calc_section_offsets(g->gd->rows, g->gd->num_rows);
 
 	/* set child widget positions */
 	place_widgets(g);
@@ -801,107 +1020,94 @@ static void grid_updatepos(GRID *g)
 
 
 /**
- * Determine min/max size of grid widget
+ * Calculate min/max values of a row or column
  *
- * The min/max properties of a Grid depend on the min/max properties of
- * its child widgets.
- *
- * FIXME: The span placement does not work, yet.
+ * The min/max values of a section are defined by the highest min and
+ * the lowest max value of the widgets that start inside the section.
  */
-static void grid_calc_minmax(GRID *g)
+static void calc_section_minmax(struct section *s, int is_row)
 {
 	struct cell *c;
-	struct section *s;
 	WIDGET *cw;
+	int cw_min, cw_max;
 
-	/* if grid has no content let it have any size */
-	if (!g->gd->rows || !g->gd->cols) {
-		g->wd->min_w = g->wd->min_h = 0;
-		return;
-	}
-
-	/* assign initial min/max values to all rows and columns */
-	s = g->gd->rows;
-	while (s) {
-		if (s->fixed < 0) {
-			s->min = 0; s->max = 999999;
-		} else {
-			s->min = s->max = s->fixed;
-		}
-		s = s->next;
-	}
-
-	s = g->gd->cols;
-	while (s) {
-		if (s->fixed < 0) {
-			s->min = 0; s->max = 999999;
-		} else {
-			s->min = s->max = s->fixed;
-		}
-		s = s->next;
+	/* assign initial min/max values */
+	if (s->fixed < 0) {
+		s->min = 0; s->max = 999999;
+	} else {
+		s->min = s->max = s->fixed;
 	}
 
-	/*
-	 * Calculate min/max values for columns/rows by finding the highest min
-	 * and lowest max value of the widgets inside a column/row.
-	 */
-
-	c = g->gd->cells;
-	while (c) {
-		int cw_min, cw_max;
+	for (c = s->cells; c; c = is_row ? c->row_next : c->col_next) {
 		cw = c->wid;
-//		if ((c->row) && (c->row->fixed < 0)) {
-		if (c->row) {
+		if (is_row) {
 			cw_min = cw->gen->get_min_h(cw) + 2*c->pad_y;
 			cw_max = cw->gen->get_max_h(cw) + 2*c->pad_y;
-			if (cw_min >= c->row->min) {
-				c->row->min = cw_min;
-				c->row->minforce = cw;
+			if (cw_min >= s->min) {
+				s->min = cw_min;
+				s->minforce = cw;
 			}
-			if ((cw_max <= c->row->max)
+			if ((cw_max <= s->max)
 			 && (c->sticky & GRID_STICKY_NORTH)
 			 && (c->sticky & GRID_STICKY_SOUTH)) {
-				c->row->max = cw_max;
-				c->row->maxforce = cw;
+				s->max = cw_max;
+				s->maxforce = cw;
 			}
-		}
-//		if ((c->col) && (c->col->fixed < 0)) {
-		if (c->col) {
+		} else {
 			cw_min = cw->gen->get_min_w(cw) + 2*c->pad_x;
 			cw_max = cw->gen->get_max_w(cw) + 2*c->pad_x;
-			if (cw_min >= c->col->min) {
-				c->col->min = cw_min;
-				c->col->minforce = cw;
+			if (cw_min >= s->min) {
+				s->min = cw_min;
+				s->minforce = cw;
 			}
-		if ((cw_max <= c->col->max)
+			if ((cw_max <= s->max)
 			 && (c->sticky & GRID_STICKY_EAST)
 			 && (c->sticky & GRID_STICKY_WEST)) {
-				c->col->max = cw_max;
-				c->col->maxforce = cw;
+				s->max = cw_max;
+				s->maxforce = cw;
 			}
 		}
-		c = c->next;
 	}
 
 	/* check if min > max - in this case min is stronger than max */
-	s = g->gd->rows;
-	while (s) {
-		if (s->min < s->fixed) s->min = s->fixed;
-		if (s->min > s->max)   s->max = s->min;
-		s = s->next;
-	}
-	s = g->gd->cols;
-	while (s) {
-		if (s->min < s->fixed) s->min = s->fixed;
-		if (s->min > s->max)   s->max = s->min;
-		s = s->next;
+	if (s->min < s->fixed) s->min = s->fixed;
+	if (s->min > s->max)   s->max = s->min;
+
+	s->dirty = 0;
+}
+
+
+/**
+ * Determine min/max size of grid widget
+ *
+ * The min/max properties of a Grid depend on the min/max properties of
+ * its child widgets. Only rows and columns that are marked as dirty
+ * are recalculated.
+ *
+ * FIXME: The span placement does not work, yet.
+ */
+static void grid_calc_minmax(GRID *g)
+{
+	struct grid_data *gd = g->gd;
+	int i;
+
+	/* if grid has no content let it have any size */
+	if (!gd->num_rows || !gd->num_cols) {
+		g->wd->min_w = g->wd->min_h = 0;
+		return;
 	}
 
-	g->wd->min_w = get_sections_minsum(g->gd->cols);
-	g->wd->max_w = get_sections_maxsum(g->gd->cols);
+	for (i = 0; i < gd->num_rows; i++)
+		if (gd->rows[i]->dirty) calc_section_minmax(gd->rows[i], 1);
 
-	g->wd->min_h = get_sections_minsum(g->gd->rows);
-	g->wd->max_h = get_sections_maxsum(g->gd->rows);
+	for (i = 0; i < gd->num_cols; i++)
+		if (gd->cols[i]->dirty) calc_section_minmax(gd->cols[i], 0);
+
+	g->wd->min_w = get_sections_minsum(gd->cols, gd->num_cols);
+	g->wd->max_w = get_sections_maxsum(gd->cols, gd->num_cols);
+
+	g->wd->min_h = get_sections_minsum(gd->rows, gd->num_rows);
+	g->wd->max_h = get_sections_maxsum(gd->rows, gd->num_rows);
 }
 
 
@@ -934,6 +1140,9 @@ static int grid_do_layout(GRID *g, WIDGET *child)
 	col = c->col;
 	row = c->row;
 
+	/* min/max of the child may have changed */
+	touch_cell(c);
+
 	/*
 	 * If a min size a the child conflicts with a current max
 	 * constraint of a non-fixed row/column, we need to recalculate
@@ -990,21 +1199,31 @@ static int grid_do_layout(GRID *g, WIDGET *child)
 static void grid_free_data(GRID *g)
 {
 	struct cell *cc = g->gd->cells, *nc;
+	int i;
 
-	/* decrement ref counters of all children */
+	/*
+	 * Decrement ref counters of all children. The grid goes away,
+	 * so there is no need to remove the cells one by one and to
+	 * update the layout after each of them.
+	 */
 	while (cc) {
 		nc = cc->next;
-		if (cc->wid) cc->wid->gen->release(cc->wid);
+		if (cc->wid) {
+			cc->wid->gen->set_parent(cc->wid, NULL);
+			cc->wid->gen->dec_ref(cc->wid);
+		}
 		cc = nc;
 	}
 
-	/* free cell list and section lists */
-	FREE_CONNECTED_LIST(struct cell,    g->gd->cells, free);
-	FREE_CONNECTED_LIST(struct section, g->gd->rows,  free);
-	FREE_CONNECTED_LIST(struct section, g->gd->cols,  free);
+	/* free cell list and section arrays */
+	FREE_CONNECTED_LIST(struct cell, g->gd->cells, free);
+	for (i = 0; i < g->gd->num_rows; i++) free(g->gd->rows[i]);
+	for (i = 0; i < g->gd->num_cols; i++) free(g->gd->cols[i]);
+	if (g->gd->rows) free(g->gd->rows);
+	if (g->gd->cols) free(g->gd->cols);
 
 	/* free cell map */
-	free(g->gd->cellmap);
+	if (g->gd->cellmap) free(g->gd->cellmap);
 }
 
 
@@ -1016,9 +1235,12 @@ static inline int get_position(GRID *g, WIDGET *cw, int *out_x, int *out_y)
 	struct cell *cc;
 	int x, y;
 
+	validate_cellmap(g);
+	if (!g->gd->cellmap) return 0;
+
 	/* go through the cellmap */
 	for (y = 0; y < g->gd->num_rows; y++) for (x = 0; x < g->gd->num_cols; x++) {
-		cc = g->gd->cellmap[g->gd->num_cols*y + x];
+		cc = cellmap_get(g, x, y);
 		if (cc && (cc->wid == cw)) {
 			*out_x = x;
 			*out_y = y;
@@ -1037,16 +1259,20 @@ static inline int get_position(GRID *g, WIDGET *cw, int *out_x, int *out_y)
  */
 static inline WIDGET *get_next_kfocus(GRID *g, int x, int y, int dir, int off)
 {
-	int max = g->gd->num_cols * g->gd->num_rows;
+	int num_cols = g->gd->num_cols;
+	int max = num_cols * g->gd->num_rows;
 	int offset;
 	WIDGET *nw;
 	struct cell *cc;
 
+	validate_cellmap(g);
+	if (!max || !g->gd->cellmap) return NULL;
+
 	/* determine start offset in cellmap to begin the search */
-	offset = (y*g->gd->num_cols + x + off) % max;
+	offset = (y*num_cols + x + off) % max;
 	for (; (offset >= 0) && (offset < max); offset += dir) {
 
-		cc = g->gd->cellmap[offset];
+		cc = cellmap_get(g, offset%num_cols, offset/num_cols);
 		if (cc && cc->wid && (nw = cc->wid->gen->first_kfocus(cc->wid)))
 			return nw;
 	}
@@ -1142,13 +1368,14 @@ static void grid_add(GRID *g, WIDGET *new_elem)
 	                    GRID_STICKY_EAST | GRID_STICKY_WEST;
 	new_cell->pad_x = 0;
 	new_cell->pad_y = 0;
+	new_cell->seq = g->gd->num_cells++;
 	new_cell->wid = new_elem;
 	new_elem->gen->inc_ref(new_elem);
 	new_elem->gen->set_parent(new_elem, g);
 	new_cell->next = g->gd->cells;
 	g->gd->cells = new_cell;
 
-	g->gd->update |= GRID_UPDATE_CELLMAP;
+	invalidate_cellmap(g);
 }
 
 
@@ -1168,7 +1395,11 @@ static void grid_remove(GRID *g, WIDGET *element)
 	element->gen->dec_ref(element);
 	cell->wid = NULL;
 
-	g->gd->update |= GRID_UPDATE_CELLMAP;
+	set_cell_row(cell, NULL);
+	set_cell_col(cell, NULL);
+	if (g->gd->last_cell == cell) g->gd->last_cell = NULL;
+
+	invalidate_cellmap(g);
 	g->wd->update |= WID_UPDATE_MINMAX;
 
 	/* is cell first element of cell list? */
@@ -1199,8 +1430,9 @@ static void grid_set_row(GRID *g, WIDGET *w, s32 row_idx)
 {
 	struct cell *cell = get_cell(g, w);
 	if (!cell) return;
-	cell->row = get_row(g, row_idx);
-	if (cell->row && cell->col) g->gd->update |= GRID_UPDATE_CELLMAP;
+	set_cell_row(cell, get_row(g, row_idx));
+	cell->placed = 0;
+	if (cell->row && cell->col) invalidate_cellmap(g);
 }
 
 
@@ -1211,8 +1443,9 @@ static void grid_set_col(GRID *g, WIDGET *w, s32 col_idx)
 {
 	struct cell *cell = get_cell(g, w);
 	if (!cell) return;
-	cell->col = get_column(g, col_idx);
-	if (cell->row && cell->col) g->gd->update |= GRID_UPDATE_CELLMAP;
+	set_cell_col(cell, get_column(g, col_idx));
+	cell->placed = 0;
+	if (cell->row && cell->col) invalidate_cellmap(g);
 }
 
 
@@ -1224,7 +1457,8 @@ static void grid_set_row_span(GRID *g, WIDGET *w, s32 num_rows)
 	struct cell *cell = get_cell(g, w);
 	if (!cell) return;
 	cell->row_span = num_rows;
-	g->gd->update |= GRID_UPDATE_CELLMAP;
+	cell->placed   = 0;
+	invalidate_cellmap(g);
 }
 
 
@@ -1236,7 +1470,8 @@ static void grid_set_col_span(GRID *g, WIDGET *w, s32 num_cols)
 	struct cell *cell = get_cell(g, w);
 	if (!cell) return;
 	cell->col_span = num_cols;
-	g->gd->update = g->gd->update | GRID_UPDATE_CELLMAP;
+	cell->placed   = 0;
+	invalidate_cellmap(g);
 }
 
 
@@ -1248,6 +1483,7 @@ static void grid_set_pad_x(GRID *g, WIDGET *w, s32 pad_x)
 	struct cell *cell = get_cell(g, w);
 	if (!cell) return;
 	cell->pad_x = pad_x;
+	touch_cell(cell);
 	g->wd->update |= WID_UPDATE_MINMAX;
 }
 
@@ -1260,6 +1496,7 @@ static void grid_set_pad_y(GRID *g, WIDGET *w, s32 pad_y)
 	struct cell *cell = get_cell(g, w);
 	if (!cell) return;
 	cell->pad_y = pad_y;
+	touch_cell(cell);
 	g->wd->update |= WID_UPDATE_MINMAX;
 }
 
@@ -1272,6 +1509,7 @@ static void grid_set_sticky(GRID *g, WIDGET *w, s32 sticky)
 	struct cell *cell = get_cell(g, w);
 	if (!cell) return;
 	cell->sticky = sticky;
+	touch_cell(cell);
 	g->wd->update |= WID_UPDATE_MINMAX;
 }
 
@@ -1284,6 +1522,7 @@ static void grid_set_row_h(GRID *g, u32 row_idx, u32 row_height)
 	struct section *row = get_row(g, row_idx);
 	if (!row) return;
 	row->fixed = row_height;
+	row->dirty = 1;
 	g->wd->update |= WID_UPDATE_MINMAX;
 }
 
@@ -1296,6 +1535,7 @@ static void grid_set_col_w(GRID *g, u32 col_idx, u32 col_width)
 	struct section *col = get_column(g, col_idx);
 	if (!col) return;
 	col->fixed = col_width;
+	col->dirty = 1;
 	g->wd->update |= WID_UPDATE_MINMAX;
 }
 
@@ -1309,6 +1549,7 @@ static void grid_set_row_weight(GRID *g, u32 row_idx, float row_weight)
 	if (!row) return;
 	row->weight = row_weight;
 	row->fixed  = -1;
+	row->dirty  = 1;
 	g->wd->update |= WID_UPDATE_MINMAX;
 }
 
@@ -1322,6 +1563,7 @@ static void grid_set_col_weight(GRID *g, u32 col_idx, float col_weight)
 	if (!col) return;
 	col->weight = col_weight;
 	col->fixed  = -1;
+	col->dirty  = 1;
 	g->wd->update |= WID_UPDATE_MINMAX;
 }
 
@@ -1344,7 +1586,7 @@ static GRID *create(void)
 	SET_WIDGET_DEFAULTS(new, struct grid, &grid_methods);
 
 	/* set grid specific widget attributes */
-	new->wd->flags |=  WID_FLAGS_CONCEALING;
+	new->wd->flags |=  WID_FLAGS_CONCEALING | WID_FLAGS_TILING;
 
 	return new;
 }
@@ -1371,7 +1613,7 @@ static void script_column_config(GRID *g, int index, float weight, int width)
 	 * create a column with default width.
 	 */
 	if (weight == -1 && width == -1
-	 && !get_section(g->gd->cols, index)) weight = 1.0;
+	 && !get_section(g->gd->cols, g->gd->num_cols, index)) weight = 1.0;
 
 	if (width!=-1) grid_set_col_w(g, index, width);
 	else if (weight > 0.0) grid_set_col_weight(g, index, weight);
@@ -1386,7 +1628,7 @@ static void script_row_config(GRID *g, int index, float weight, int width)
 	 * create a row with default width.
 	 */
 	if (weight == -1 && width == -1
-	 && !get_section(g->gd->rows, index)) weight = 1.0;
+	 && !get_section(g->gd->rows, g->gd->num_rows, index)) weight = 1.0;
 
 	if (width!=-1) grid_set_row_h(g, index, width);
 	else if (weight > 0.0) grid_set_row_weight(g, index, weight);
@@ -1429,6 +1671,7 @@ static void script_place_widget(GRID *g, WIDGET *w, int col, int row,
 
 	/* sweep the market for the newly placed widget */
 	erase_overlapping_cells(g, get_cell(g, w));
+	touch_cell(get_cell(g, w));
 
 	g->wd->update |= WID_UPDATE_MINMAX;
 	w->wd->update |= WID_UPDATE_NEWCHILD;
@@ -1436,6 +1679,23 @@ static void script_place_widget(GRID *g, WIDGET *w, int col, int row,
 }
 
 
+/**
+ * Defer layout updates while placing many widgets
+ */
+static void grid_freeze(GRID *g)
+{
+	g->gd->frozen = 1;
+}
+
+
+static void grid_thaw(GRID *g)
+{
+	g->gd->frozen = 0;
+	g->wd->update |= WID_UPDATE_MINMAX;
+	gen_methods.update(g);
+}
+
+
 static void build_script_lang(void)
 {
 	void *widtype;
@@ -1447,6 +1707,8 @@ static void build_script_lang(void)
 	script->reg_widget_method(widtype, "void place(Widget child,int column=9999,int row=9999,int columnspan=9999,int rowspan=9999,int padx=9999,int pady=9999,string align=\"\")", script_place_widget);
 	script->reg_widget_method(widtype, "void add(Widget child)", grid_add);
 	script->reg_widget_method(widtype, "void remove(Widget child)", grid_remove);
+	script->reg_widget_method(widtype, "void freeze()", grid_freeze);
+	script->reg_widget_method(widtype, "void thaw()", grid_thaw);
 
 	widman->build_script_lang(widtype, &gen_methods);
 }
@@ -22,12 +22,14 @@
 #include "mtkstd.h"
 #include "hashtab.h"
 #include "list_macros.h"
+#include "slab.h"
 
 #define MIN(a,b) ((a)<(b)?(a):(b))
 
 struct hashtab_entry;
 struct hashtab_entry {
 	char *ident;
+	int   ident_is_atom;    /* ident is referenced, not owned */
 	void *value;
 	struct hashtab_entry *next;
 	void (*destroy_elem_function) (void *value);
@@ -38,8 +40,12 @@ struct hashtab {
 	u32 tab_size;                   /* hash table size                     */
 	u32 max_hash_length;            /* number of chars for building hashes */
 	struct hashtab_entry **tab;     /* hash table itself                   */
+	void (*destroy)(void *value);   /* destroy function for new elements   */
 };
 
+static struct slab_services *slab;
+static SLAB *entry_pool;
+
 int init_hashtable(struct mtk_services *d);
 void hashtab_print_info(HASHTAB *h);
 
@@ -96,11 +102,11 @@ static HASHTAB *hashtab_create(u32 tab_size, u32 max_hash_length)
  */
 static inline void free_hashtab_entry(struct hashtab_entry *e)
 {
-	if (e->ident)
-		free(e->ident);
+	if (!e->ident_is_atom)
+		slab->free(e->ident);
 	if (e->destroy_elem_function)
 		e->destroy_elem_function(e->value);
-	free(e);
+	slab->free(e);
 }
 
 
@@ -200,14 +206,52 @@ static void hashtab_add_elem(HASHTAB *h, char *ident, void *value)
 	if (!h) return;
 	if (hashtab_get_elem(h, ident, 255)) hashtab_remove_elem(h, ident);
 	hashval = hash_value(ident, h->max_hash_length) % (h->tab_size);
-	ne = (struct hashtab_entry *)zalloc(sizeof(struct hashtab_entry));
-	ne->ident = strdup(ident);
+	ne = (struct hashtab_entry *)slab->alloc(entry_pool);
+	if (!ne) return;
+	ne->ident = slab->strdup(ident);
 	ne->value = value;
+	ne->destroy_elem_function = h->destroy;
 	ne->next  = h->tab[hashval];
 	h->tab[hashval] = ne;
 }
 
 
+/**
+ * Add new hash table entry identified by an atom
+ */
+static void hashtab_add_atom(HASHTAB *h, char *atom, void *value)
+{
+	u32 hashval;
+	struct hashtab_entry *ne;
+
+	if (!h || !atom) return;
+	if (hashtab_get_elem(h, atom, 255)) hashtab_remove_elem(h, atom);
+	hashval = hash_value(atom, h->max_hash_length) % (h->tab_size);
+	ne = (struct hashtab_entry *)slab->alloc(entry_pool);
+	if (!ne) return;
+	ne->ident         = atom;
+	ne->ident_is_atom = 1;
+	ne->value         = value;
+	ne->next          = h->tab[hashval];
+	ne->destroy_elem_function = h->destroy;
+	h->tab[hashval]   = ne;
+}
+
+
+/**
+ * Request an element of a hash table by its atom
+ */
+static void *hashtab_get_atom(HASHTAB *h, char *atom)
+{
+	struct hashtab_entry *ce;
+
+	if (!h || !atom) return NULL;
+	ce = h->tab[hash_value(atom, h->max_hash_length) % (h->tab_size)];
+	while (ce && ce->ident != atom) ce = ce->next;
+	return ce ? ce->value : NULL;
+}
+
+
 /**
  * Print information about a hash table (only for debugging issues)
  */
@@ -277,6 +321,30 @@ static void *hashtab_get_next(HASHTAB *h, void *value)
 }
 
 
+/**
+ * Define destroy function for the values of new elements
+ */
+static void hashtab_set_destroy(HASHTAB *h, void (*destroy)(void *value))
+{
+	if (h) h->destroy = destroy;
+}
+
+
+/**
+ * Call function for each element of a hash table
+ */
+static void hashtab_for_each(HASHTAB *h, void (*func)(void *value, void *arg), void *arg)
+{
+	struct hashtab_entry *e;
+	u32 i;
+
+	if (!h) return;
+	for (i=0; i < h->tab_size; i++)
+		for (e = h->tab[i]; e; e = e->next)
+			func(e->value, arg);
+}
+
+
 /**************************************
  ** Service structure of this module **
  **************************************/
@@ -290,6 +358,10 @@ static struct hashtab_services services = {
 	hashtab_remove_elem,
 	hashtab_get_first,
 	hashtab_get_next,
+	hashtab_add_atom,
+	hashtab_get_atom,
+	hashtab_set_destroy,
+	hashtab_for_each,
 };
 
 
@@ -299,6 +371,9 @@ static struct hashtab_services services = {
 
 int init_hashtable(struct mtk_services *d)
 {
+	slab       = d->get_module("Slab 1.0");
+	entry_pool = slab->get_pool("hashtab entry", sizeof(struct hashtab_entry));
+
 	d->register_module("HashTable 1.0", &services);
 	return 1;
 }
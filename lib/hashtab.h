@@ -25,6 +25,26 @@ struct hashtab_services {
 	void     (*remove_elem) (HASHTAB *h, char *ident);
 	void    *(*get_first)   (HASHTAB *h);
 	void    *(*get_next)    (HASHTAB *h, void *value);
+
+	/*
+	 * Atom-keyed variants of add_elem and get_elem. The identifier is
+	 * referenced instead of copied and elements are found by comparing
+	 * pointers. Elements added this way can also be requested by name.
+	 */
+	void     (*add_atom)    (HASHTAB *h, char *atom, void *value);
+	void    *(*get_atom)    (HASHTAB *h, char *atom);
+
+	/*
+	 * Define function that is called for the values of elements added
+	 * afterwards when they are removed or when the table is destroyed
+	 */
+	void     (*set_destroy) (HASHTAB *h, void (*destroy)(void *value));
+
+	/*
+	 * Call function for each value of the hash table. The function
+	 * must not add or remove elements.
+	 */
+	void     (*for_each)    (HASHTAB *h, void (*func)(void *value, void *arg), void *arg);
 };
 
 
@@ -37,6 +37,7 @@ struct label_data {
 	char     *text_original;  /* non-translated */
 	s32       font_id;
 	s32       tx, ty;         /* text position inside the label cell */
+	s32       tw, th;         /* pixel size of text                  */
 	VARIABLE *var;
 };
 
@@ -53,8 +54,8 @@ int init_label(struct mtk_services *d);
 static void update_text_pos(LABEL *l)
 {
 	if (!l->ld->text) return;
-	l->ld->tx = (l->wd->w - font->calc_str_width (l->ld->font_id, l->ld->text))>>1;
-	l->ld->ty = (l->wd->h - font->calc_str_height(l->ld->font_id, l->ld->text))>>1;
+	l->ld->tx = (l->wd->w - l->ld->tw)>>1;
+	l->ld->ty = (l->wd->h - l->ld->th)>>1;
 }
 
 
@@ -62,14 +63,11 @@ static void update_text_pos(LABEL *l)
  ** General widget methods **
  ****************************/
 
-static int lab_draw(LABEL *l, struct gfx_ds *ds, int x, int y, WIDGET *origin)
+static int lab_draw(LABEL *l, struct gfx_ds *ds, int x, int y)
 {
 	int tx = x + l->wd->x + l->ld->tx;
 	int ty = y + l->wd->y + l->ld->ty;
 
-	if (origin == l) return 1;
-	if (origin) return 0;
-
 	gfx->push_clipping(ds, x + l->wd->x, y + l->wd->y, l->wd->w, l->wd->h);
 	if (l->ld->text) {
 		gfx->draw_string(ds, tx, ty, GFX_RGB(200, 200, 200), 0, l->ld->font_id, l->ld->text);
@@ -82,14 +80,17 @@ static int lab_draw(LABEL *l, struct gfx_ds *ds, int x, int y, WIDGET *origin)
 
 /**
  * Determine min/max size of a label widget
+ *
+ * This function is called whenever the text or the font changes.
+ * So the text size is measured here and reused by update_text_pos.
  */
 static void lab_calc_minmax(LABEL *l)
 {
 	if (l->ld->text) {
-		l->wd->min_w = l->wd->max_w = font->calc_str_width (l->ld->font_id, l->ld->text)
-		                            + 2 * 2;
-		l->wd->min_h = l->wd->max_h = font->calc_str_height(l->ld->font_id, l->ld->text)
-		                            + 2 * 2;
+		l->ld->tw = font->calc_str_width (l->ld->font_id, l->ld->text);
+		l->ld->th = font->calc_str_height(l->ld->font_id, l->ld->text);
+		l->wd->min_w = l->wd->max_w = l->ld->tw + 2 * 2;
+		l->wd->min_h = l->wd->max_h = l->ld->th + 2 * 2;
 	} else {
 		l->wd->min_w = l->wd->min_h = 2 * 2;
 		l->wd->max_w = l->wd->max_h = 2 * 2;
@@ -146,18 +147,13 @@ static char *lab_get_text(LABEL *l)
 /**
  * Set font of label
  *
- * Currently, only the font identifiers 'default',
- * 'monospaced' and 'title' are defined.
+ * Built-in font identifiers are 'default', 'monospaced' and
+ * 'title'. Further fonts can be registered at the font manager.
  */
 static void lab_set_font(LABEL *l, char *fontname)
 {
-	if (mtk_streq(fontname, "default", 255)) {
-		l->ld->font_id = 0;
-	} else if (mtk_streq(fontname, "monospaced", 255)) {
-		l->ld->font_id = 1;
-	} else if (mtk_streq(fontname, "title", 255)) {
-		l->ld->font_id = 2;
-	}
+	s32 font_id = font->lookup(fontname);
+	if (font_id >= 0) l->ld->font_id = font_id;
 	l->wd->update |= WID_UPDATE_MINMAX;
 }
 
@@ -167,11 +163,8 @@ static void lab_set_font(LABEL *l, char *fontname)
  */
 static char *lab_get_font(LABEL *l)
 {
-	switch (l->ld->font_id) {
-		case 1:  return "monospaced";
-		case 2:  return "title";
-		default: return "default";
-	}
+	char *ident = font->get_ident(l->ld->font_id);
+	return ident ? ident : "default";
 }
 
 /**
@@ -18,13 +18,13 @@ SRC_C  += \
 	cache.c       clipping.c    container.c \
 	conv_fnt.c    mtkstd.c      entry.c     \
 	fontman.c     frame.c       gfx.c       \
-	gfx_img16.c   gfx_img32.c   \
+	gfx_img16.c   gfx_img32.c   gfx_imgraw.c \
 	widman.c      conv_tff.c    grid.c      \
 	hashtab.c     label.c     \
 	loaddisplay.c pool.c      \
 	winlayout.c   redraw.c      scale.c     \
 	window.c      screen.c      script.c    \
-	scrollbar.c   tick.c      \
+	scrollbar.c   tick.c        stream.c    \
 	tokenizer.c   userstate.c   variable.c  \
 	scope.c       i18n.c        clipboard.c \
 	bigmouse.c    default_fnt.c main.c      \
@@ -32,14 +32,29 @@ SRC_C  += \
 	scrdrv.c      eventmsg.c  \
 	sharedmem.c   gfx_scr16.c   scheduler.c \
 	vera16_tff.c  vera20_tff.c  edit.c \
-	separator.c   pixmap.c      list.c
+	separator.c   pixmap.c      list.c \
+	atom.c        textlayout.c  tables.c    \
+	table.c       slab.c
+
+#
+# Constant tables (converted fonts, drop shadow) are generated
+# at build time by a host tool and end up in read-only data.
+#
+MKTABLES_SRC = mktables.c conv_fnt.c conv_tff.c \
+               vera16_tff.c mono_fnt.c title_fnt.c
 
 vpath % $(LIBMTK_DIR)
 
 $(TARGET): $(SRC_C:.c=.o)
 	$(AR) -r $@ $^
 
+mktables: $(MKTABLES_SRC)
+	$(HOSTCC) -I$(LIBMTK_DIR) -I$(BASE_DIR)/include -o $@ $^
+
+tables.c: mktables
+	./mktables > $@
+
 clean:
-	rm -f $(TARGET) $(SRC_C:.c=.o) *.d
+	rm -f $(TARGET) $(SRC_C:.c=.o) *.d mktables tables.c
 
 -include *.d
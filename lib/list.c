@@ -27,20 +27,32 @@ struct list;
 #include "widman.h"
 #include "userstate.h"
 #include "mtkeycodes.h"
-#include "messenger.h"
+#include "mtklib.h"
+#include "redraw.h"
 
 static struct widman_services  *widman;
 static struct gfx_services     *gfx;
 static struct fontman_services *font;
 static struct script_services  *script;
 static struct userstate_services *userstate;
-static struct messenger_services *msg;
+static struct redraw_services    *redraw;
+
+#define LIST_INIT_SIZE 16   /* initial capacity of item array */
+
+struct list_item {
+	char *text;
+	s32   width;           /* pixel width of the text        */
+};
 
 struct list_data {
-	char     *text;
+	struct list_item *items;
+	s32       num_items;
+	s32       max_items;   /* capacity of item array         */
+	s32       max_w;       /* max item width or -1           */
+	char     *text;        /* items joined by '\n' or NULL   */
 	s32       font_id;
 	s32       ch;
-	s32       sel, nsel;
+	s32       sel;
 	VARIABLE *var;
 };
 
@@ -57,20 +69,134 @@ int init_list(struct mtk_services *d);
 
 static void update_pos(LIST *l)
 {
-	char *c;
-	
 	l->ld->ch = font->calc_str_height(l->ld->font_id, "W");
+	if(l->ld->sel >= l->ld->num_items) l->ld->sel = l->ld->num_items-1;
+}
 
-	l->ld->nsel = 0;
-	if(l->ld->text) {
-		l->ld->nsel++;
-		c = l->ld->text;
-		while(*c != 0) {
-			if(*c == '\n') l->ld->nsel++;
-			c++;
-		}
+
+/**
+ * Make sure that the item array can hold the specified number of items
+ */
+static int reserve_items(LIST *l, s32 num)
+{
+	struct list_item *new;
+	s32 new_max = l->ld->max_items ? l->ld->max_items : LIST_INIT_SIZE;
+
+	if (num <= l->ld->max_items) return 0;
+	while (new_max < num) new_max *= 2;
+
+	new = realloc(l->ld->items, new_max*sizeof(struct list_item));
+	if (!new) {
+		ERROR(printf("List(reserve_items): out of memory\n"));
+		return -1;
+	}
+	l->ld->items     = new;
+	l->ld->max_items = new_max;
+	return 0;
+}
+
+
+/**
+ * Assign text to an item, line breaks are replaced by spaces
+ */
+static int set_item_text(LIST *l, struct list_item *item, char *text, s32 len)
+{
+	char *c;
+
+	if (!(item->text = malloc(len + 1))) {
+		ERROR(printf("List(set_item_text): out of memory\n"));
+		return -1;
 	}
-	if(l->ld->sel >= l->ld->nsel) l->ld->sel = l->ld->nsel-1;
+	memcpy(item->text, text, len);
+	item->text[len] = 0;
+	for (c = item->text; *c; c++)
+		if (*c == '\n') *c = ' ';
+
+	item->width = font->calc_str_width(l->ld->font_id, item->text);
+	if ((l->ld->max_w >= 0) && (item->width > l->ld->max_w))
+		l->ld->max_w = item->width;
+	return 0;
+}
+
+
+static void free_item_text(LIST *l, struct list_item *item)
+{
+	if (item->width >= l->ld->max_w) l->ld->max_w = -1;
+	free(item->text);
+}
+
+
+/**
+ * Return pixel width of the widest item
+ */
+static s32 get_max_w(LIST *l)
+{
+	s32 i;
+
+	if (l->ld->max_w < 0) {
+		l->ld->max_w = 0;
+		for (i = 0; i < l->ld->num_items; i++)
+			l->ld->max_w = MAX(l->ld->max_w, l->ld->items[i].width);
+	}
+	return l->ld->max_w;
+}
+
+
+/**
+ * Invalidate the joined text after the items changed
+ */
+static void items_changed(LIST *l)
+{
+	if (l->ld->text) free(l->ld->text);
+	l->ld->text = NULL;
+	l->wd->update |= WID_UPDATE_MINMAX;
+}
+
+
+/**
+ * Determine rows that intersect the current clipping area
+ *
+ * \param ty  screen position of the first row
+ */
+static void visible_rows(LIST *l, struct gfx_ds *ds, int ty, s32 *first, s32 *last)
+{
+	int cy = gfx->get_clip_y(ds), ch = gfx->get_clip_h(ds);
+
+	*first = 0;
+	*last  = -1;
+	if (l->ld->ch <= 0 || ch <= 0) return;
+
+	*first = MAX(0, (cy - ty)/l->ld->ch);
+	*last  = MIN(l->ld->num_items - 1, (cy + ch - 1 - ty)/l->ld->ch);
+}
+
+
+/**
+ * Queue redraw of one row, e.g., after the selection changed
+ */
+static void redraw_row(LIST *l, s32 row)
+{
+	s32 y1 = 2 + 2 + row*l->ld->ch;
+	s32 y2 = y1 + l->ld->ch - 1;
+
+	if (row < 0) return;
+	y1 = MAX(y1, 0);
+	y2 = MIN(y2, l->wd->h - 1);
+	if (y1 <= y2) redraw->draw_widgetarea(l, 0, y1, l->wd->w - 1, y2);
+}
+
+
+static void select_row(LIST *l, s32 sel)
+{
+	s32 old = l->ld->sel;
+
+	if (sel >= l->ld->num_items) sel = l->ld->num_items - 1;
+	if (sel < 0) sel = l->ld->num_items ? 0 : -1;
+	if (sel == old) return;
+
+	l->ld->sel = sel;
+	redraw_row(l, old);
+	redraw_row(l, sel);
 }
 
 /****************************
@@ -94,13 +220,11 @@ static inline void draw_kfocus_frame(GFX_CONTAINER *d, s32 x, s32 y, s32 w, s32
 	gfx->draw_vline(d, x + w - 1, y,         h,     BLACK_SOLID);
 }
 
-static int lst_draw(LIST *l, struct gfx_ds *ds, int x, int y, WIDGET *origin)
+static int lst_draw(LIST *l, struct gfx_ds *ds, int x, int y)
 {
 	int tx, ty;
 	int w, h;
-
-	if (origin == l) return 1;
-	if (origin) return 0;
+	s32 i, first, last;
 
 	x += l->wd->x;
 	y += l->wd->y;
@@ -127,10 +251,12 @@ static int lst_draw(LIST *l, struct gfx_ds *ds, int x, int y, WIDGET *origin)
 	w -= 3;
 	gfx->push_clipping(ds, x+3, y+2, w, h-3);
 
-	if (l->ld->text) {
+	/* only draw the rows within the clipping area */
+	visible_rows(l, ds, ty, &first, &last);
+	if (l->ld->sel >= first && l->ld->sel <= last)
 		gfx->draw_box(ds, tx, ty+l->ld->ch*l->ld->sel, w, l->ld->ch, GFX_RGB(0,59,112));
-		gfx->draw_string(ds, tx, ty, GFX_RGB(200, 200, 200), 0, l->ld->font_id, l->ld->text);
-	}
+	for (i = first; i <= last; i++)
+		gfx->draw_string(ds, tx, ty+l->ld->ch*i, GFX_RGB(200, 200, 200), 0, l->ld->font_id, l->ld->items[i].text);
 
 	gfx->pop_clipping(ds);
 	gfx->pop_clipping(ds);
@@ -143,8 +269,7 @@ static void lst_handle_event(LIST *l, EVENT *ev, WIDGET *from)
 {
 	int ypos = userstate->get_my() - l->gen->get_abs_y(l);
 	int ev_done = 0;
-	int s;
-	char *message;
+	int s = l->ld->sel;
 
 	switch (ev->type) {
 	case EVENT_PRESS:
@@ -154,13 +279,8 @@ static void lst_handle_event(LIST *l, EVENT *ev, WIDGET *from)
 				ypos -= 2 + 2;
 				s = ypos/l->ld->ch;
 				if(s < 0) s = 0;
-				if(s >= l->ld->nsel) s = l->ld->nsel-1;
-				if(l->ld->sel == s) {
-					ev_done = 2;
-				} else {
-					l->ld->sel = s;
-					ev_done = 1;
-				}
+				if(s >= l->ld->num_items) s = l->ld->num_items-1;
+				ev_done = (l->ld->sel == s) ? 2 : 1;
 				break;
 
 			case MTK_KEY_ENTER:
@@ -168,22 +288,20 @@ static void lst_handle_event(LIST *l, EVENT *ev, WIDGET *from)
 				break;
 
 			case MTK_KEY_UP:
-				if(l->ld->sel > 0)
-					l->ld->sel--;
+				if(s > 0) s--;
 				ev_done = 1;
 				break;
 			case MTK_KEY_DOWN:
-				if(l->ld->sel < (l->ld->nsel-1))
-					l->ld->sel++;
+				if(s < (l->ld->num_items-1)) s++;
 				ev_done = 1;
 				break;
 
 			case MTK_KEY_HOME:
-				l->ld->sel = 0;
+				s = 0;
 				ev_done = 1;
 				break;
 			case MTK_KEY_END: {
-				l->ld->sel = l->ld->nsel-1;
+				s = l->ld->num_items-1;
 				ev_done = 1;
 				break;
 			}
@@ -195,18 +313,16 @@ static void lst_handle_event(LIST *l, EVENT *ev, WIDGET *from)
 				return;
 		}
 
+		select_row(l, s);
+
 		if(ev_done == 2) {
 			/* Selection committed */
-			message = l->gen->get_bind_msg(l, "selcommit");
-			if (message) msg->send_action_event(l->gen->get_app_id(l), "selcommit", message);
+			l->gen->send_action(l, MTK_BIND_SELCOMMIT, "selcommit");
 		}
 		if(ev_done == 1) {
 			/* Selection changed */
-			message = l->gen->get_bind_msg(l, "selchange");
-			if (message) msg->send_action_event(l->gen->get_app_id(l), "selchange", message);
+			l->gen->send_action(l, MTK_BIND_SELCHANGE, "selchange");
 		}
-		if (ev_done)
-			l->gen->force_redraw(l);
 	}
 }
 
@@ -217,16 +333,16 @@ static void lst_calc_minmax(LIST *l)
 {
 	int mw, mh;
 	
+	l->ld->ch = font->calc_str_height(l->ld->font_id, "W");
+
 	l->wd->min_w = 40;
 	l->wd->min_h = 100;
-	if (l->ld->text) {
-		mw = font->calc_str_width(l->ld->font_id, l->ld->text) + 8;
-		mh = font->calc_str_height(l->ld->font_id, l->ld->text) + 8;
-		if (l->wd->min_w < mw) l->wd->min_w = mw;
-		if (l->wd->min_h < mh) l->wd->min_h = mh;
-	}
+	mw = get_max_w(l) + 8;
+	mh = MAX(l->ld->num_items, 1)*l->ld->ch + 8;
+	if (l->wd->min_w < mw) l->wd->min_w = mw;
+	if (l->wd->min_h < mh) l->wd->min_h = mh;
 	l->wd->max_w = 99999;
-	l->wd->max_h = 99999;
+	l->wd->max_h = MAX(99999, l->wd->min_h);
 }
 
 
@@ -243,7 +359,11 @@ static void lst_updatepos(LIST *l)
  */
 static void lst_free_data(LIST *l)
 {
-	if (l->ld->text) free(l->ld->text);
+	s32 i;
+
+	for (i = 0; i < l->ld->num_items; i++) free(l->ld->items[i].text);
+	if (l->ld->items) free(l->ld->items);
+	if (l->ld->text)  free(l->ld->text);
 }
 
 
@@ -262,15 +382,57 @@ static char *lst_get_type(LIST *l)
 
 static void lst_set_text(LIST *l, char *new_txt)
 {
-	if ((!l) || (!l->ld)) return;
-	if (l->ld->text) free(l->ld->text);
-	l->ld->text = strdup(new_txt);
-	l->wd->update |= WID_UPDATE_MINMAX;
+	s32 i, num;
+	char *c, *end;
+
+	if ((!l) || (!l->ld) || (!new_txt)) return;
+
+	for (i = 0; i < l->ld->num_items; i++) free(l->ld->items[i].text);
+	l->ld->num_items = 0;
+	l->ld->max_w     = 0;
+
+	/* each line of the text becomes an item, an empty text has no items */
+	num = *new_txt ? 1 : 0;
+	for (c = new_txt; *c; c++)
+		if (*c == '\n') num++;
+	if (reserve_items(l, num)) return;
+
+	for (c = new_txt; l->ld->num_items < num; c = end + 1) {
+		for (end = c; *end && (*end != '\n'); end++);
+		if (set_item_text(l, &l->ld->items[l->ld->num_items], c, end - c)) break;
+		l->ld->num_items++;
+	}
+
+	/* select the first item of a list that had no items */
+	if ((l->ld->sel < 0) && l->ld->num_items) l->ld->sel = 0;
+	items_changed(l);
 }
 
 
+/**
+ * Request list content as text with one line per item
+ *
+ * The text is assembled on demand and kept until the next
+ * modification of the items.
+ */
 static char *lst_get_text(LIST *l)
 {
+	s32 i, len = 0;
+	char *dst;
+
+	if (l->ld->text) return l->ld->text;
+
+	for (i = 0; i < l->ld->num_items; i++)
+		len += strlen(l->ld->items[i].text) + 1;
+	if (!(l->ld->text = malloc(len + 1))) return "";
+
+	dst = l->ld->text;
+	for (i = 0; i < l->ld->num_items; i++) {
+		if (i) *dst++ = '\n';
+		strcpy(dst, l->ld->items[i].text);
+		dst += strlen(dst);
+	}
+	*dst = 0;
 	return l->ld->text;
 }
 
@@ -278,18 +440,17 @@ static char *lst_get_text(LIST *l)
 /**
  * Set font of list
  *
- * Currently, only the font identifiers 'default',
- * 'monospaced' and 'title' are defined.
+ * Built-in font identifiers are 'default', 'monospaced' and
+ * 'title'. Further fonts can be registered at the font manager.
  */
 static void lst_set_font(LIST *l, char *fontname)
 {
-	if (mtk_streq(fontname, "default", 255)) {
-		l->ld->font_id = 0;
-	} else if (mtk_streq(fontname, "monospaced", 255)) {
-		l->ld->font_id = 1;
-	} else if (mtk_streq(fontname, "title", 255)) {
-		l->ld->font_id = 2;
-	}
+	s32 i, font_id = font->lookup(fontname);
+	if (font_id >= 0) l->ld->font_id = font_id;
+
+	for (i = 0; i < l->ld->num_items; i++)
+		l->ld->items[i].width = font->calc_str_width(l->ld->font_id, l->ld->items[i].text);
+	l->ld->max_w = -1;
 	l->wd->update |= WID_UPDATE_MINMAX;
 }
 
@@ -298,19 +459,13 @@ static void lst_set_font(LIST *l, char *fontname)
  */
 static char *lst_get_font(LIST *l)
 {
-	switch (l->ld->font_id) {
-		case 1:  return "monospaced";
-		case 2:  return "title";
-		default: return "default";
-	}
+	char *ident = font->get_ident(l->ld->font_id);
+	return ident ? ident : "default";
 }
 
 void lst_set_selection(LIST *l, int selection)
 {
-	l->ld->sel = selection;
-	if(l->ld->sel < 0) l->ld->sel = 0;
-	if(l->ld->sel >= l->ld->nsel) l->ld->sel = l->ld->nsel-1;
-	l->gen->force_redraw(l);
+	select_row(l, selection);
 }
 
 int lst_get_selection(LIST *l)
@@ -318,6 +473,82 @@ int lst_get_selection(LIST *l)
 	return l->ld->sel;
 }
 
+
+/**
+ * Insert item before the item at the specified index
+ *
+ * An index outside the list appends the item.
+ */
+static void lst_insert(LIST *l, int index, char *item)
+{
+	if (!item || reserve_items(l, l->ld->num_items + 1)) return;
+	if ((index < 0) || (index > l->ld->num_items)) index = l->ld->num_items;
+
+	memmove(l->ld->items + index + 1, l->ld->items + index,
+	        (l->ld->num_items - index)*sizeof(struct list_item));
+	if (set_item_text(l, &l->ld->items[index], item, strlen(item))) {
+		memmove(l->ld->items + index, l->ld->items + index + 1,
+		        (l->ld->num_items - index)*sizeof(struct list_item));
+		return;
+	}
+	l->ld->num_items++;
+
+	/* keep the selected item selected */
+	if ((index <= l->ld->sel) || (l->ld->sel < 0)) l->ld->sel++;
+
+	items_changed(l);
+	l->gen->update(l);
+}
+
+
+static void lst_append(LIST *l, char *item)
+{
+	lst_insert(l, l->ld->num_items, item);
+}
+
+
+static void lst_remove(LIST *l, int index)
+{
+	if ((index < 0) || (index >= l->ld->num_items)) return;
+
+	free_item_text(l, &l->ld->items[index]);
+	l->ld->num_items--;
+	memmove(l->ld->items + index, l->ld->items + index + 1,
+	        (l->ld->num_items - index)*sizeof(struct list_item));
+
+	if ((index < l->ld->sel) || (l->ld->sel >= l->ld->num_items)) l->ld->sel--;
+
+	items_changed(l);
+	l->gen->update(l);
+}
+
+
+static void lst_set_item(LIST *l, int index, char *item)
+{
+	if (!item || (index < 0) || (index >= l->ld->num_items)) return;
+
+	free_item_text(l, &l->ld->items[index]);
+	if (set_item_text(l, &l->ld->items[index], item, strlen(item)))
+		set_item_text(l, &l->ld->items[index], "", 0);
+
+	items_changed(l);
+	l->gen->update(l);
+}
+
+
+static char *lst_get_item(LIST *l, int index)
+{
+	if ((index < 0) || (index >= l->ld->num_items)) return "";
+	return l->ld->items[index].text;
+}
+
+
+static int lst_get_count(LIST *l)
+{
+	return l->ld->num_items;
+}
+
+
 static struct widget_methods gen_methods;
 static struct list_methods lst_methods = {
 	lst_set_text,
@@ -326,6 +557,12 @@ static struct list_methods lst_methods = {
 	lst_get_font,
 	lst_set_selection,
 	lst_get_selection,
+	lst_append,
+	lst_insert,
+	lst_remove,
+	lst_set_item,
+	lst_get_item,
+	lst_get_count,
 };
 
 
@@ -339,8 +576,8 @@ static LIST *create(void)
 	SET_WIDGET_DEFAULTS(new, struct list, &lst_methods);
 
 	/* set list specific attributes */
-	new->ld->text = strdup("");
-	new->ld->nsel = 0;
+	new->ld->sel = -1;
+	lst_set_text(new, "");
 	new->wd->flags |= WID_FLAGS_EDITABLE | WID_FLAGS_TAKEFOCUS;
 	update_pos(new);
 
@@ -370,6 +607,12 @@ static void build_script_lang(void)
 	script->reg_widget_attrib(widtype, "string text", lst_get_text, lst_set_text, gen_methods.update);
 	script->reg_widget_attrib(widtype, "string font", lst_get_font, lst_set_font, gen_methods.update);
 	script->reg_widget_attrib(widtype, "int selection", lst_get_selection, lst_set_selection, gen_methods.update);
+	script->reg_widget_attrib(widtype, "int count", lst_get_count, NULL, NULL);
+	script->reg_widget_method(widtype, "void append(string item)", lst_append);
+	script->reg_widget_method(widtype, "void insert(int index,string item)", lst_insert);
+	script->reg_widget_method(widtype, "void remove(int index)", lst_remove);
+	script->reg_widget_method(widtype, "void set_item(int index,string item)", lst_set_item);
+	script->reg_widget_method(widtype, "string item(int index)", lst_get_item);
 
 	widman->build_script_lang(widtype, &gen_methods);
 }
@@ -382,7 +625,7 @@ int init_list(struct mtk_services *d)
 	font      = d->get_module("FontManager 1.0");
 	script    = d->get_module("Script 1.0");
 	userstate = d->get_module("UserState 1.0");
-	msg       = d->get_module("Messenger 1.0");
+	redraw    = d->get_module("RedrawManager 1.0");
 
 	/* define general widget functions */
 	widman->default_widget_methods(&gen_methods);
@@ -35,6 +35,12 @@ struct list_methods {
 	char     *(*get_font)       (LIST *);
 	void      (*set_selection)  (LIST *, int selection);
 	int       (*get_selection)  (LIST *);
+	void      (*append)         (LIST *, char *item);
+	void      (*insert)         (LIST *, int index, char *item);
+	void      (*remove)         (LIST *, int index);
+	void      (*set_item)       (LIST *, int index, char *item);
+	char     *(*get_item)       (LIST *, int index);
+	int       (*get_count)      (LIST *);
 };
 
 struct list_services {
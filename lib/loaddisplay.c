@@ -270,7 +270,7 @@ static color_t get_color_by_name(const char *colname)
  ** General widget methods **
  ****************************/
 
-static int ld_draw(LOADDISPLAY *ld, struct gfx_ds *ds, int x, int y, WIDGET *origin)
+static int ld_draw(LOADDISPLAY *ld, struct gfx_ds *ds, int x, int y)
 {
 	struct loadbar *lb = ld->ldd->bars;
 	int w = ld->wd->w - 2*ld->ldd->padx;
@@ -278,9 +278,6 @@ static int ld_draw(LOADDISPLAY *ld, struct gfx_ds *ds, int x, int y, WIDGET *ori
 	x    += ld->wd->x + ld->ldd->padx;
 	y    += ld->wd->y + ld->ldd->pady;
 
-	if (origin == ld) return 1;
-	if (origin) return 0;
-
 	gfx->push_clipping(ds, x, y, w, h);
 	gfx->draw_img(ds, x, y, w, h, bg_img, 255);
 
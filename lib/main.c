@@ -19,10 +19,14 @@
 #include "userstate.h"
 #include "widget.h"
 #include "screen.h"
+#include "script.h"
+#include "timer.h"
 
 static struct gfx_services       *gfx;
 static struct screen_services    *screen;
 static struct userstate_services *userstate;
+static struct script_services    *script;
+static struct timer_services     *timer;
 
 extern SCREEN *curr_scr;
 
@@ -40,7 +44,9 @@ extern int init_scrdrv           (struct mtk_services *);
 extern int init_widman           (struct mtk_services *);
 extern int init_screen           (struct mtk_services *);
 extern int init_timer            (struct mtk_services *);
+extern int init_slab             (struct mtk_services *);
 extern int init_tick             (struct mtk_services *);
+extern int init_stream           (struct mtk_services *);
 extern int init_button           (struct mtk_services *);
 extern int init_entry            (struct mtk_services *);
 extern int init_edit             (struct mtk_services *);
@@ -48,6 +54,7 @@ extern int init_loaddisplay      (struct mtk_services *);
 extern int init_variable         (struct mtk_services *);
 extern int init_label            (struct mtk_services *);
 extern int init_list             (struct mtk_services *);
+extern int init_table            (struct mtk_services *);
 extern int init_separator        (struct mtk_services *);
 extern int init_pixmap           (struct mtk_services *);
 extern int init_background       (struct mtk_services *);
@@ -57,10 +64,12 @@ extern int init_userstate        (struct mtk_services *);
 extern int init_conv_fnt         (struct mtk_services *);
 extern int init_conv_tff         (struct mtk_services *);
 extern int init_fontman          (struct mtk_services *);
+extern int init_textlayout       (struct mtk_services *);
 extern int init_gfx              (struct mtk_services *);
 extern int init_gfxscr16         (struct mtk_services *);
 extern int init_gfximg16         (struct mtk_services *);
 extern int init_gfximg32         (struct mtk_services *);
+extern int init_gfximgraw        (struct mtk_services *);
 extern int init_cache            (struct mtk_services *);
 extern int init_scale            (struct mtk_services *);
 extern int init_scrollbar        (struct mtk_services *);
@@ -69,6 +78,7 @@ extern int init_grid             (struct mtk_services *);
 extern int init_redraw           (struct mtk_services *);
 extern int init_simple_scheduler (struct mtk_services *);
 extern int init_hashtable        (struct mtk_services *);
+extern int init_atom             (struct mtk_services *);
 extern int init_tokenizer        (struct mtk_services *);
 extern int init_scope            (struct mtk_services *);
 extern int init_script           (struct mtk_services *);
@@ -79,6 +89,29 @@ extern int init_sharedmem        (struct mtk_services *);
 extern int init_clipboard        (struct mtk_services *);
 extern int init_i18n             (struct mtk_services *);
 
+/**
+ * Widget types whose modules are initialized on the first use
+ *
+ * These modules are not referenced by any other module. Hence, their
+ * initialization can be deferred until a widget of the type is created.
+ */
+static struct lazy_module {
+	char *widtype;
+	int (*init)(struct mtk_services *);
+} lazy_modules[] = {
+	{ "Entry",       init_entry       },
+	{ "Edit",        init_edit        },
+	{ "Variable",    init_variable    },
+	{ "Label",       init_label       },
+	{ "List",        init_list        },
+	{ "Table",       init_table       },
+	{ "Separator",   init_separator   },
+	{ "Pixmap",      init_pixmap      },
+	{ "LoadDisplay", init_loaddisplay },
+	{ "Scale",       init_scale       },
+	{ "Grid",        init_grid        },
+};
+
 /**
  * Prototypes from eventloop.c
  */
@@ -96,28 +129,42 @@ int config_menubar       = 0;   /* menubar visibility                     */
 int config_dropshadows   = 0;   /* draw dropshadows behind windows        */
 int config_adapt_redraw  = 0;   /* adapt redraw to duration time          */
 
+u32 boot_start_time;            /* timer value at the start of mtk_init */
+
 static GFX_CONTAINER *scr_ds;
 
 int mtk_init(void *fb, int width, int height)
 {
+	unsigned int i;
 	INFO(char *dbg="Main(init): ");
 
 	/**
 	 * init modules
 	 */
 
-	INFO(printf("%sSharedMemory\n",dbg));
-	init_sharedmem(&mtk);
-
 	INFO(printf("%sTimer\n",dbg));
 	init_timer(&mtk);
+	timer = pool_get("Timer 1.0");
+	boot_start_time = timer->get_time();
+
+	INFO(printf("%sSlab\n",dbg));
+	init_slab(&mtk);
+
+	INFO(printf("%sSharedMemory\n",dbg));
+	init_sharedmem(&mtk);
 
 	INFO(printf("%sTick\n",dbg));
 	init_tick(&mtk);
 
+	INFO(printf("%sStream\n",dbg));
+	init_stream(&mtk);
+
 	INFO(printf("%sCache\n",dbg));
 	init_cache(&mtk);
 
+	INFO(printf("%sAtom\n",dbg));
+	init_atom(&mtk);
+
 	INFO(printf("%sHashTable\n",dbg));
 	init_hashtable(&mtk);
 
@@ -135,6 +182,7 @@ int mtk_init(void *fb, int width, int height)
 
 	INFO(printf("%sScript\n",dbg));
 	init_script(&mtk);
+	script = pool_get("Script 1.0");
 
 	INFO(printf("%sClipping\n",dbg));
 	init_clipping(&mtk);
@@ -151,6 +199,9 @@ int mtk_init(void *fb, int width, int height)
 	INFO(printf("%sFontManager\n",dbg));
 	init_fontman(&mtk);
 
+	INFO(printf("%sTextLayout\n",dbg));
+	init_textlayout(&mtk);
+
 	INFO(printf("%sGfxScreen16\n",dbg));
 	init_gfxscr16(&mtk);
 
@@ -160,6 +211,9 @@ int mtk_init(void *fb, int width, int height)
 	INFO(printf("%sGfxImage32\n",dbg));
 	init_gfximg32(&mtk);
 
+	INFO(printf("%sGfxImageRaw\n",dbg));
+	init_gfximgraw(&mtk);
+
 	INFO(printf("%sGfx\n",dbg));
 	init_gfx(&mtk);
 
@@ -181,29 +235,10 @@ int mtk_init(void *fb, int width, int height)
 	INFO(printf("%sButton\n",dbg));
 	init_button(&mtk);
 
-	INFO(printf("%sEntry\n",dbg));
-	init_entry(&mtk);
-
-	INFO(printf("%sEdit\n",dbg));
-	init_edit(&mtk);
-
-	INFO(printf("%sVariable\n",dbg));
-	init_variable(&mtk);
-
-	INFO(printf("%sLabel\n",dbg));
-	init_label(&mtk);
-
-	INFO(printf("%sLabel\n",dbg));
-	init_list(&mtk);
-
-	INFO(printf("%sSeparator\n",dbg));
-	init_separator(&mtk);
-
-	INFO(printf("%sPixmap\n",dbg));
-	init_pixmap(&mtk);
-
-	INFO(printf("%sLoadDisplay\n",dbg));
-	init_loaddisplay(&mtk);
+	for (i = 0; i < sizeof(lazy_modules)/sizeof(struct lazy_module); i++) {
+		INFO(printf("%s%s (on demand)\n",dbg,lazy_modules[i].widtype));
+		script->reg_lazy_widget_type(lazy_modules[i].widtype, lazy_modules[i].init);
+	}
 
 	INFO(printf("%sBackground\n",dbg));
 	init_background(&mtk);
@@ -211,18 +246,12 @@ int mtk_init(void *fb, int width, int height)
 	INFO(printf("%sScrollbar\n",dbg));
 	init_scrollbar(&mtk);
 
-	INFO(printf("%sScale\n",dbg));
-	init_scale(&mtk);
-
 	INFO(printf("%sFrame\n",dbg));
 	init_frame(&mtk);
 
 	INFO(printf("%sContainer\n",dbg));
 	init_container(&mtk);
 
-	INFO(printf("%sGrid\n",dbg));
-	init_grid(&mtk);
-
 	INFO(printf("%sWinLayout\n",dbg));
 	init_winlayout(&mtk);
 
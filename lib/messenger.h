@@ -15,9 +15,17 @@
 
 #include "event.h"
 
+union mtklib_event_union;
+
 struct messenger_services {
 	void    (*send_input_event) (s32 app_id,EVENT *e,char *bindarg);
 	void    (*send_action_event)(s32 app_id,char *action,char *bindarg);
+
+	/**
+	 * Deliver events to a callback function of a native binding
+	 */
+	void    (*call_input_event) (EVENT *e, void (*callback)(union mtklib_event_union *, void *), void *arg);
+	void    (*call_action_event)(char *action, void (*callback)(union mtklib_event_union *, void *), void *arg);
 };
 
 #endif /* _MTK_MESSENGER_H_ */
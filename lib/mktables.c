@@ -0,0 +1,239 @@
+/*
+ * \brief   Build-time generator for constant MTK tables
+ *
+ * This host program is executed during the build of libmtk.
+ * It converts the built-in fonts to the format used by the
+ * font manager and computes the window drop-shadow image.
+ * The result is written as C source to stdout such that the
+ * tables end up in the read-only data of the library and no
+ * longer need to be computed or copied at startup.
+ */
+
+/*
+ * Copyright (C) 2010 Sebastien Bourdeauducq
+ *
+ * This file is part of the MTK package, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "mtkstd.h"
+#include "fontconv.h"
+#include "gfx.h"
+
+#define SHADOW_W 17   /* size of drop-shadow image */
+#define SHADOW_H 17
+
+extern int init_conv_fnt(struct mtk_services *);
+extern int init_conv_tff(struct mtk_services *);
+
+extern unsigned char vera16_tff[];
+extern unsigned char mono_fnt[];
+extern unsigned char title_fnt[];
+
+static struct fontconv_services *conv_fnt;
+static struct fontconv_services *conv_tff;
+
+/**
+ * Built-in fonts, the index corresponds to the font id
+ */
+static struct builtin_font {
+	const char *ident;
+	struct fontconv_services **conv;
+	void *data;
+} builtin_fonts[] = {
+	{ "vera16", &conv_tff, vera16_tff },
+	{ "mono",   &conv_fnt, mono_fnt   },
+	{ "title",  &conv_fnt, title_fnt  },
+};
+
+#define NUM_BUILTIN_FONTS (int)(sizeof(builtin_fonts)/sizeof(builtin_fonts[0]))
+
+
+/******************************************
+ ** Minimal module environment for conv **
+ ******************************************/
+
+static void *last_module;
+
+static int register_module(char *name, void *structure)
+{
+	last_module = structure;
+	return 1;
+}
+
+static void *get_module(char *name)
+{
+	return NULL;
+}
+
+static struct mtk_services mtk = {
+	get_module,
+	register_module,
+};
+
+void *zalloc(unsigned int size)
+{
+	return calloc(1, size);
+}
+
+
+/**********************
+ ** Table generation **
+ **********************/
+
+static void print_s32_table(const char *name, s32 *tab, int num)
+{
+	int i;
+	printf("static const s32 %s[%d] = {", name, num);
+	for (i = 0; i < num; i++)
+		printf("%s%d,", (i % 16) ? "" : "\n\t", (int)tab[i]);
+	printf("\n};\n\n");
+}
+
+
+static void print_u8_table(const char *name, u8 *tab, int num)
+{
+	int i;
+	printf("static const u8 %s[%d] = {", name, num);
+	for (i = 0; i < num; i++)
+		printf("%s0x%02x,", (i % 16) ? "" : "\n\t", tab[i]);
+	printf("\n};\n\n");
+}
+
+
+/**
+ * Emit width table, offset table and image of a font
+ */
+static int gen_font(struct builtin_font *f)
+{
+	struct fontconv_services *conv = *f->conv;
+	s32 wtab[256], otab[256];
+	u32 img_w, img_h;
+	u8 *img;
+	char name[64];
+
+	if (!conv->probe(f->data)) {
+		fprintf(stderr, "mktables: invalid font data of %s\n", f->ident);
+		return -1;
+	}
+
+	img_w = conv->get_image_width(f->data);
+	img_h = conv->get_image_height(f->data);
+	img   = zalloc(img_w*img_h);
+	if (!img) return -1;
+
+	conv->gen_width_table(f->data, wtab);
+	conv->gen_offset_table(f->data, otab);
+	conv->gen_image(f->data, img);
+
+	snprintf(name, sizeof(name), "%s_wtab", f->ident);
+	print_s32_table(name, wtab, 256);
+	snprintf(name, sizeof(name), "%s_otab", f->ident);
+	print_s32_table(name, otab, 256);
+	snprintf(name, sizeof(name), "%s_img", f->ident);
+	print_u8_table(name, img, img_w*img_h);
+
+	free(img);
+	return 0;
+}
+
+
+static void gen_font_structs(void)
+{
+	int i;
+	struct fontconv_services *conv;
+	struct builtin_font *f;
+
+	printf("const struct font builtin_fonts[%d] = {\n", NUM_BUILTIN_FONTS);
+	for (i = 0; i < NUM_BUILTIN_FONTS; i++) {
+		f = &builtin_fonts[i];
+		conv = *f->conv;
+		printf("\t{ %d, %s_wtab, %s_otab, %u, %u, %u, %u, %s_img, (u8 *)\"%s\" },\n",
+		       i, f->ident, f->ident,
+		       conv->get_image_width(f->data), conv->get_image_height(f->data),
+		       conv->get_top(f->data), conv->get_bottom(f->data),
+		       f->ident, (char *)conv->get_name(f->data));
+	}
+	printf("};\n\n");
+	printf("const int num_builtin_fonts = %d;\n\n", NUM_BUILTIN_FONTS);
+}
+
+
+/**
+ * Calculate square root
+ *
+ * The valid argument range is 0..65535.
+ */
+static int sqroot(u32 v)
+{
+	u32 c = 0x8000;
+	u32 res = 0;
+	while (c) {
+		if (v >= ((res | c)*(res | c))) res |= c;
+		c = c >> 1;
+	}
+	return res;
+}
+
+
+/**
+ * Generate radial shadow image
+ */
+static void gen_shadow(u32 *dst, int w, int h, int mx, int my)
+{
+	int x, y, r, ry;
+	u32 *d;
+	int scale = (255*255)/(w*h);
+
+	mx += mx;
+	my += my;
+
+	ry = mx*mx + my*my;
+	for (y = 0; y < h; y++) {
+		d = dst;
+		for (x = 0, r = ry; x < w; x++) {
+			d[x] = GFX_RGBA(0, 0, 0, ((255 - MIN(sqroot(r*scale), 255))*2)/3);
+			r += 4*(2*x - mx) + 4;
+		}
+		ry  += 4*(2*y - my) + 4;
+		dst += w;
+	}
+}
+
+
+static void gen_shadow_img(void)
+{
+	u32 img[SHADOW_W*SHADOW_H];
+	int i;
+
+	gen_shadow(img, SHADOW_W, SHADOW_H, SHADOW_W >> 1, SHADOW_H >> 1);
+
+	printf("const int shadow_img_w = %d;\n", SHADOW_W);
+	printf("const int shadow_img_h = %d;\n\n", SHADOW_H);
+	printf("const u32 shadow_img[%d] = {", SHADOW_W*SHADOW_H);
+	for (i = 0; i < SHADOW_W*SHADOW_H; i++)
+		printf("%s0x%08x,", (i % SHADOW_W) ? "" : "\n\t", img[i]);
+	printf("\n};\n");
+}
+
+
+int main(int argc, char **argv)
+{
+	int i;
+
+	init_conv_fnt(&mtk); conv_fnt = last_module;
+	init_conv_tff(&mtk); conv_tff = last_module;
+
+	printf("/*\n * Generated by mktables - do not edit\n */\n\n");
+	printf("#include \"mtkstd.h\"\n");
+	printf("#include \"fontman.h\"\n\n");
+
+	for (i = 0; i < NUM_BUILTIN_FONTS; i++)
+		if (gen_font(&builtin_fonts[i])) return 1;
+
+	gen_font_structs();
+	gen_shadow_img();
+	return 0;
+}
@@ -21,56 +21,114 @@ struct pixmap;
 #include "messenger.h"
 #include "mtkeycodes.h"
 #include "window.h"
+#include "stream.h"
 
 static struct widman_services      *widman;
 static struct script_services      *script;
 static struct redraw_services      *redraw;
 static struct gfx_services         *gfx;
+static struct stream_services      *stream;
 
 struct pixmap_data {
 	s32 xres, yres;
 	void *fb;
+	GFX_CONTAINER *img;   /* image that refers to fb or NULL */
+	enum img_type format; /* pixel format of fb              */
+	enum gfx_filter filter;
+	s32 dispw, disph;     /* displayed size, 0 means xres/yres */
+	STREAM *stream;       /* stream that provides fb or NULL */
 };
 
+static struct {
+	char *name;
+	enum img_type type;
+} formats[] = {
+	{ "rgb565",   GFX_IMG_TYPE_RGB16  },
+	{ "xrgb8888", GFX_IMG_TYPE_XRGB32 },
+	{ "argb8888", GFX_IMG_TYPE_ARGB32 },
+	{ "yuv422",   GFX_IMG_TYPE_YUV422 },
+};
+
+#define NUM_FORMATS (sizeof(formats)/sizeof(formats[0]))
+
 int init_pixmap(struct mtk_services *d);
 
+/********************************
+ ** Functions for internal use **
+ ********************************/
+
+/**
+ * Drop image that refers to the client buffer
+ *
+ * Must be called whenever the buffer or its size changes. Afterwards,
+ * the old buffer is not referenced anymore.
+ */
+static void release_img(PIXMAP *pm)
+{
+	if (!pm->pd->img) return;
+	gfx->dec_ref(pm->pd->img);
+	pm->pd->img = NULL;
+}
+
+
+static inline int disp_w(PIXMAP *pm) { return pm->pd->dispw ? pm->pd->dispw : pm->pd->xres; }
+static inline int disp_h(PIXMAP *pm) { return pm->pd->disph ? pm->pd->disph : pm->pd->yres; }
+
+
+/**
+ * Fix widget size to the displayed size
+ */
+static void update_size(PIXMAP *pm)
+{
+	pm->wd->min_w = pm->wd->max_w = disp_w(pm);
+	pm->wd->min_h = pm->wd->max_h = disp_h(pm);
+	pm->wd->update |= WID_UPDATE_MINMAX;
+}
+
+
 /****************************
  ** General widget methods **
  ****************************/
 
 /**
  * Draw pixmap widget
+ *
+ * The client buffer is drawn directly without copying it. Pixels that
+ * are not in RGB565 format are converted while drawing. If the displayed
+ * size differs from the buffer size, the buffer is scaled.
  */
-static int pixm_draw(PIXMAP *pm, struct gfx_ds *ds, int x, int y, WIDGET *origin)
+static int pixm_draw(PIXMAP *pm, struct gfx_ds *ds, int x, int y)
 {
-	GFX_CONTAINER *image;
-	void *newb;
-
 	x += pm->wd->x;
 	y += pm->wd->y;
 
-	if(origin == pm) return 1;
-	if(origin) return 0;
-
 	if((pm->pd->xres == 0) || (pm->pd->yres == 0) || (pm->pd->fb == NULL))
 		return 1;
 
-	image = gfx->alloc_img(pm->pd->xres, pm->pd->yres, GFX_IMG_TYPE_RGB16);
-	if(image == NULL)
-		return 1;
-	newb = gfx->map(image);
-	memcpy(newb, pm->pd->fb, pm->pd->xres*pm->pd->yres*2);
-	gfx->unmap(image);
-	
+	if (!pm->pd->img) {
+		pm->pd->img = gfx->alloc_ext_img(pm->pd->fb, pm->pd->xres, pm->pd->yres, pm->pd->format);
+		if (!pm->pd->img)
+			return 1;
+		gfx->set_filter(pm->pd->img, pm->pd->filter);
+	}
+
 	gfx->push_clipping(ds, x, y, pm->wd->w, pm->wd->h);
-	gfx->draw_img(ds, x, y, pm->pd->xres, pm->pd->yres, image, 255);
+	gfx->draw_img(ds, x, y, disp_w(pm), disp_h(pm), pm->pd->img, 255);
 	gfx->pop_clipping(ds);
 
-	gfx->dec_ref(image);
-
 	return 1;
 }
 
+
+/**
+ * Free pixmap specific data
+ */
+static void pixm_free_data(PIXMAP *pm)
+{
+	if (pm->pd->stream) stream->bind(pm->pd->stream, NULL, NULL);
+	release_img(pm);
+}
+
 /**
  * Return widget type identifier
  */
@@ -86,8 +144,9 @@ static char *pixm_get_type(PIXMAP *pm)
 
 static void pixm_set_w(PIXMAP *pm, int new_w)
 {
-	pm->pd->xres = pm->wd->min_w = pm->wd->max_w = new_w;
-	pm->wd->update |= WID_UPDATE_MINMAX;
+	release_img(pm);
+	pm->pd->xres = new_w;
+	update_size(pm);
 }
 
 static int pixm_get_w(PIXMAP *pm)
@@ -97,8 +156,9 @@ static int pixm_get_w(PIXMAP *pm)
 
 static void pixm_set_h(PIXMAP *pm, int new_h)
 {
-	pm->pd->yres = pm->wd->min_h = pm->wd->max_h = new_h;
-	pm->wd->update |= WID_UPDATE_MINMAX;
+	release_img(pm);
+	pm->pd->yres = new_h;
+	update_size(pm);
 }
 
 static int pixm_get_h(PIXMAP *pm)
@@ -108,8 +168,9 @@ static int pixm_get_h(PIXMAP *pm)
 
 static void pixm_set_fb(PIXMAP *pm, int new_fb)
 {
+	release_img(pm);
 	pm->pd->fb = (void *)new_fb;
-	pm->wd->update |= WID_UPDATE_MINMAX;
+	pm->wd->update |= WID_UPDATE_REFRESH;
 }
 
 static int pixm_get_fb(PIXMAP *pm)
@@ -117,14 +178,145 @@ static int pixm_get_fb(PIXMAP *pm)
 	return (int)pm->pd->fb;
 }
 
-static void pixm_refresh(PIXMAP *pm)
+static void pixm_set_format(PIXMAP *pm, char *name)
+{
+	int i;
+
+	for (i = 0; i < NUM_FORMATS; i++)
+		if (name && !strcmp(name, formats[i].name)) break;
+	if (i == NUM_FORMATS) {
+		ERROR(printf("Pixmap(set_format): unknown format %s\n", name ? name : "<null>"));
+		return;
+	}
+	release_img(pm);
+	pm->pd->format = formats[i].type;
+	pm->wd->update |= WID_UPDATE_REFRESH;
+}
+
+static char *pixm_get_format(PIXMAP *pm)
+{
+	int i;
+
+	for (i = 0; i < NUM_FORMATS; i++)
+		if (formats[i].type == pm->pd->format) return formats[i].name;
+	return "";
+}
+
+static void pixm_set_filter(PIXMAP *pm, char *name)
+{
+	pm->pd->filter = (name && !strcmp(name, "bilinear")) ? GFX_FILTER_BILINEAR
+	                                                     : GFX_FILTER_NEAREST;
+	if (pm->pd->img) gfx->set_filter(pm->pd->img, pm->pd->filter);
+	pm->wd->update |= WID_UPDATE_REFRESH;
+}
+
+static char *pixm_get_filter(PIXMAP *pm)
+{
+	return pm->pd->filter == GFX_FILTER_BILINEAR ? "bilinear" : "nearest";
+}
+
+static void pixm_set_dispw(PIXMAP *pm, int new_w)
+{
+	pm->pd->dispw = MAX(new_w, 0);
+	update_size(pm);
+}
+
+static int pixm_get_dispw(PIXMAP *pm)
+{
+	return pm->pd->dispw;
+}
+
+static void pixm_set_disph(PIXMAP *pm, int new_h)
+{
+	pm->pd->disph = MAX(new_h, 0);
+	update_size(pm);
+}
+
+static int pixm_get_disph(PIXMAP *pm)
+{
+	return pm->pd->disph;
+}
+
+/**
+ * Redraw the changed area of the client buffer
+ *
+ * A negative width or height refers to the whole buffer.
+ */
+static void pixm_refresh(PIXMAP *pm, int x, int y, int w, int h)
+{
+	int dw = disp_w(pm), dh = disp_h(pm);
+
+	if (w < 0 || h < 0) {
+		x = y = 0;
+		w = pm->pd->xres;
+		h = pm->pd->yres;
+	}
+	if (w == 0 || h == 0 || !pm->pd->xres || !pm->pd->yres) return;
+
+	if (dw == pm->pd->xres && dh == pm->pd->yres) {
+		redraw->draw_widgetarea(pm, x, y, x + w - 1, y + h - 1);
+		return;
+	}
+
+	/* map area to displayed size, widen it by one pixel for filtering */
+	redraw->draw_widgetarea(pm, x*dw/pm->pd->xres - 1, y*dh/pm->pd->yres - 1,
+	                        ((x + w)*dw + pm->pd->xres - 1)/pm->pd->xres,
+	                        ((y + h)*dh + pm->pd->yres - 1)/pm->pd->yres);
+}
+
+/**
+ * Bind new client buffer of the same size and redraw the widget
+ *
+ * The old buffer is not accessed anymore after this call. So the
+ * client may switch between buffers without tearing.
+ */
+static void pixm_swap(PIXMAP *pm, int new_fb)
+{
+	release_img(pm);
+	pm->pd->fb = (void *)new_fb;
+	pixm_refresh(pm, 0, 0, -1, -1);
+}
+
+/**
+ * Display latest frame of the stream
+ *
+ * The frame is not switched while a redraw of the window is pending.
+ * Otherwise, parts of the widget could show different frames.
+ */
+static int stream_notify(void *arg)
+{
+	PIXMAP *pm = arg;
+	WIDGET *win = pm->gen->get_window(pm);
+	void *fb;
+
+	if (win && redraw->is_queued(win)) return 0;
+
+	if (!(fb = stream->latest(pm->pd->stream))) return 1;
+	if (fb != pm->pd->fb) {
+		release_img(pm);
+		pm->pd->fb = fb;
+	}
+	if (win) pixm_refresh(pm, 0, 0, -1, -1);
+	return 1;
+}
+
+/**
+ * Attach stream that provides the frames of the pixmap
+ *
+ * Passing NULL detaches the current stream.
+ */
+static void pixm_set_stream(PIXMAP *pm, STREAM *new_stream)
 {
-	redraw->draw_widgetarea(pm, 0, 0, pm->pd->xres, pm->pd->yres);
+	if (pm->pd->stream) stream->bind(pm->pd->stream, NULL, NULL);
+	pm->pd->stream = new_stream;
+	if (pm->pd->stream) stream->bind(pm->pd->stream, stream_notify, pm);
 }
 
 static struct widget_methods gen_methods;
 static struct pixmap_methods pixmap_methods = {
-	pixm_refresh
+	pixm_refresh,
+	pixm_swap,
+	pixm_set_stream,
 };
 
 
@@ -140,6 +332,9 @@ static PIXMAP *create(void)
 	new->pd->xres = 0;
 	new->pd->yres = 0;
 	new->pd->fb = NULL;
+	new->pd->img = NULL;
+	new->pd->format = GFX_IMG_TYPE_RGB16;
+	new->pd->filter = GFX_FILTER_NEAREST;
 	return new;
 }
 
@@ -163,10 +358,15 @@ static void build_script_lang(void)
 
 	widtype = script->reg_widget_type("Pixmap", (void *(*)(void))create);
 
-	script->reg_widget_method(widtype, "void refresh()", pixm_refresh);
+	script->reg_widget_method(widtype, "void refresh(int x=0,int y=0,int w=-1,int h=-1)", pixm_refresh);
+	script->reg_widget_method(widtype, "void swap(int fb)", pixm_swap);
 	script->reg_widget_attrib(widtype, "int w", pixm_get_w, pixm_set_w, gen_methods.update);
 	script->reg_widget_attrib(widtype, "int h", pixm_get_h, pixm_set_h, gen_methods.update);
 	script->reg_widget_attrib(widtype, "int fb", pixm_get_fb, pixm_set_fb, gen_methods.update);
+	script->reg_widget_attrib(widtype, "string format", pixm_get_format, pixm_set_format, gen_methods.update);
+	script->reg_widget_attrib(widtype, "string filter", pixm_get_filter, pixm_set_filter, gen_methods.update);
+	script->reg_widget_attrib(widtype, "int dispw", pixm_get_dispw, pixm_set_dispw, gen_methods.update);
+	script->reg_widget_attrib(widtype, "int disph", pixm_get_disph, pixm_set_disph, gen_methods.update);
 
 	widman->build_script_lang(widtype, &gen_methods);
 }
@@ -178,12 +378,14 @@ int init_pixmap(struct mtk_services *d)
 	script      = d->get_module("Script 1.0");
 	widman      = d->get_module("WidgetManager 1.0");
 	redraw      = d->get_module("RedrawManager 1.0");
+	stream      = d->get_module("Stream 1.0");
 
 	/* define general widget functions */
 	widman->default_widget_methods(&gen_methods);
 
 	gen_methods.get_type     = pixm_get_type;
 	gen_methods.draw         = pixm_draw;
+	gen_methods.free_data    = pixm_free_data;
 
 	build_script_lang();
 
@@ -12,6 +12,7 @@
 
 struct pixmap_methods;
 struct pixmap_data;
+struct stream;
 
 #define PIXMAP struct pixmap
 
@@ -25,7 +26,9 @@ struct pixmap {
 };
 
 struct pixmap_methods {
-	void (*refresh)    (PIXMAP *);
+	void (*refresh)    (PIXMAP *, int x, int y, int w, int h);
+	void (*swap)       (PIXMAP *, int fb);
+	void (*set_stream) (PIXMAP *, struct stream *);
 };
 
 struct pixmap_services {
@@ -25,11 +25,13 @@
 
 struct pool_entry {
 	char    *name;          /* id of system module */
+	u32      hash;          /* hash value of name */
 	void    *structure;     /* system module structure */
 };
 
 static struct pool_entry pool[MAX_POOL_ENTRIES];
 static int pool_size=0;
+static int pool_top=0;      /* index after the last used pool entry */
 
 
 /**
@@ -40,18 +42,34 @@ void pool_remove(char *name);
 void *pool_get(char *name);
 
 
+/**
+ * Calculate hash value of a module name
+ */
+static u32 name_hash(const char *name)
+{
+	u32 result = 2166136261u;
+	while (*name) {
+		result ^= (u8)*(name++);
+		result *= 16777619;
+	}
+	return result;
+}
+
+
 /**
  * Add new pool entry
  */
 int pool_add(char *name,void *structure)
 {
 	int i;
-	if (pool_size>=100) return 0;
+	if (pool_size>=MAX_POOL_ENTRIES) return 0;
 	else {
 		for (i=0;pool[i].name!=NULL;i++) {};
 
 		pool[i].name=name;
+		pool[i].hash=name_hash(name);
 		pool[i].structure=structure;
+		if (i>=pool_top) pool_top=i+1;
 
 		pool_size++;
 		INFO(printf("Pool(add): %s\n",name));
@@ -67,7 +85,7 @@ void pool_remove(char *name)
 {
 	int i;
 	char *s;
-	for (i=0;i<100;i++) {
+	for (i=0;i<pool_top;i++) {
 		s=pool[i].name;
 		if (s!=NULL) {
 			if (mtk_streq(name,pool[i].name,255)) {
@@ -87,11 +105,12 @@ void pool_remove(char *name)
 void *pool_get(char *name)
 {
 	int i;
+	u32 hash=name_hash(name);
 	char *s;
-	for (i=0;i<MAX_POOL_ENTRIES;i++) {
+	for (i=0;i<pool_top;i++) {
 		s=pool[i].name;
-		if (s!=NULL) {
-			if (mtk_streq(name,pool[i].name,255)) {
+		if (s!=NULL && pool[i].hash==hash) {
+			if (s==name || mtk_streq(name,s,255)) {
 				INFO(printf("Pool(get): module matched: %s\n",name));
 			    return pool[i].structure;
 			}
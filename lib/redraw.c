@@ -205,25 +205,31 @@ static void add_redraw_action(WIDGET *w, int x1, int y1, int x2, int y2)
  */
 static void draw_area(WIDGET *cw, int cx1, int cy1, int cx2, int cy2)
 {
-	/* the parent of a window is a screen, the screen has no parent */
-	while (cw && cw->wd->parent && cw->wd->parent->wd->parent) {
-
-		/* increment position by relative widget position */
-		cx1 += cw->wd->x;
-		cy1 += cw->wd->y;
-		cx2 += cw->wd->x;
-		cy2 += cw->wd->y;
+	WIDGET *parent, *win;
+	int x1, y1, x2, y2, dx, dy;
 
-		cw = cw->wd->parent;
+	if (!cw) return;
 
-		/* shink current area to parent view area */
-		if (cx1 < 0) cx1 = 0;
-		if (cy1 < 0) cy1 = 0;
-		if (cx2 > cw->wd->w - 1) cx2 = cw->wd->w - 1;
-		if (cy2 > cw->wd->h - 1) cy2 = cw->wd->h - 1;
+	/* the parent of a window is a screen, the screen has no parent */
+	parent = cw->wd->parent;
+	if (!parent || !parent->wd->parent) {
+		add_redraw_action(cw, cx1, cy1, cx2, cy2);
+		return;
 	}
 
-	if (cw) add_redraw_action(cw, cx1, cy1, cx2, cy2);
+	/* shrink area to the visible area of the parent */
+	win = parent->gen->get_abs_clip(parent, &x1, &y1, &x2, &y2);
+	dx  = cw->gen->get_abs_x(cw);
+	dy  = cw->gen->get_abs_y(cw);
+	x1  = MAX(x1, cx1 + dx);
+	y1  = MAX(y1, cy1 + dy);
+	x2  = MIN(x2, cx2 + dx);
+	y2  = MIN(y2, cy2 + dy);
+
+	/* redraw area is relative to the window */
+	dx = win->gen->get_abs_x(win);
+	dy = win->gen->get_abs_y(win);
+	add_redraw_action(win, x1 - dx, y1 - dy, x2 - dx, y2 - dy);
 }
 
 
@@ -27,14 +27,13 @@ struct scale;
 #include "widman.h"
 #include "script.h"
 #include "userstate.h"
-#include "messenger.h"
+#include "mtklib.h"
 
 static struct gfx_services       *gfx;
 static struct widman_services    *widman;
 static struct button_services    *but;
 static struct script_services    *script;
 static struct userstate_services *userstate;
-static struct messenger_services *msg;
 
 #define SCALE_SIZE 14
 
@@ -102,24 +101,19 @@ static WIDGET *new_button(char *txt,void *clic,int context)
  ** General widget methods **
  ****************************/
 
-static int scale_draw(SCALE *w, struct gfx_ds *ds, int x, int y, WIDGET *origin)
+static int scale_draw(SCALE *w, struct gfx_ds *ds, int x, int y)
 {
 	int x1, y1, x2, y2;
 	int ret = 0;
 
-	if (origin == w) return 1;
-
 	x1 = w->wd->x + x;
 	y1 = w->wd->y + y;
 	x2 = x1 + w->wd->w - 1;
 	y2 = y1 + w->wd->h - 1;
 
 	/* draw elements of the scale */
-	ret |= w->sd->slider_bg->gen->draw(w->sd->slider_bg, ds, w->wd->x + x, w->wd->y + y, origin);
-	ret |= w->sd->slider->gen->draw(w->sd->slider, ds, w->wd->x + x, w->wd->y + y, origin);
-
-	/* do not draw groove if visibility is requested */
-	if (origin) return ret;
+	ret |= w->sd->slider_bg->gen->draw(w->sd->slider_bg, ds, w->wd->x + x, w->wd->y + y);
+	ret |= w->sd->slider->gen->draw(w->sd->slider, ds, w->wd->x + x, w->wd->y + y);
 
 	if (w->sd->type & SCALE_VER) {
 		int x = x1 + w->sd->padx + 4;
@@ -272,6 +266,21 @@ static void scale_bind(SCALE *s, char *bind_ident, char *message)
 }
 
 
+static void (*orig_bind_callback)(WIDGET *w, int type,
+                                  void (*callback)(union mtklib_event_union *, void *),
+                                  void *arg, int filter);
+static void scale_bind_callback(SCALE *s, int type,
+                                void (*callback)(union mtklib_event_union *, void *),
+                                void *arg, int filter)
+{
+	WIDGET *cw;
+
+	if ((cw = s->sd->slider))    cw->gen->bind_callback(cw, type, callback, arg, filter);
+	if ((cw = s->sd->slider_bg)) cw->gen->bind_callback(cw, type, callback, arg, filter);
+	orig_bind_callback(s, type, callback, arg, filter);
+}
+
+
 /**
  * Propagate application id to child widgets
  */
@@ -333,17 +342,13 @@ static u32 scale_get_orient_bit (SCALE *s)
 static void scale_set_value(SCALE *s,float new_value)
 {
 	static char strbuf[24];
-	int app_id;
-	char *m;
 
 	s->sd->value = check_value(s->sd->from, s->sd->to, new_value);
 	mtk_ftoa(s->sd->value, 2, strbuf, 24);
 	if (s->sd->var) s->sd->var->var->set_string(s->sd->var, &strbuf[0]);
 	
 	/* notify client that bound an "change"-event */
-	m = s->gen->get_bind_msg(s, "change");
-	app_id = s->gen->get_app_id(s);
-	if (m) msg->send_action_event(app_id, "change", m);
+	s->gen->send_action(s, MTK_BIND_CHANGE, "change");
 
 	s->wd->update |= WID_UPDATE_REFRESH;
 }
@@ -435,8 +440,7 @@ static SCALE *curr_scale;       /* currently modified scale widget */
 static void slider_motion_callback(WIDGET *w, int dx, int dy)
 {
 	float from, to, value;
-	s32 pos, size, app_id;
-	char *m;
+	s32 pos, size;
 
 	if (!(scale_get_orient_bit(curr_scale) & SCALE_VER)) {
 		pos  = osx + dx;
@@ -453,9 +457,7 @@ static void slider_motion_callback(WIDGET *w, int dx, int dy)
 
 	scale_set_value(curr_scale, value);
 
-	m = curr_scale->gen->get_bind_msg(curr_scale, "slide");
-	app_id = curr_scale->gen->get_app_id(curr_scale);
-	if (m) msg->send_action_event(app_id, "slide", m);
+	curr_scale->gen->send_action(curr_scale, MTK_BIND_SLIDE, "slide");
 
 	curr_scale->wd->update |= WID_UPDATE_REFRESH;
 	curr_scale->gen->update((WIDGET *)curr_scale);
@@ -464,9 +466,7 @@ static void slider_motion_callback(WIDGET *w, int dx, int dy)
 
 static void slider_release_callback(WIDGET *s, int dx, int dy)
 {
-	char *m = curr_scale->gen->get_bind_msg(curr_scale, "slid");
-	int app_id = curr_scale->gen->get_app_id(curr_scale);
-	if (m) msg->send_action_event(app_id, "slid", m);
+	curr_scale->gen->send_action(curr_scale, MTK_BIND_SLID, "slid");
 }
 
 
@@ -594,12 +594,12 @@ int init_scale(struct mtk_services *d)
 	script    = d->get_module("Script 1.0");
 	widman    = d->get_module("WidgetManager 1.0");
 	userstate = d->get_module("UserState 1.0");
-	msg       = d->get_module("Messenger 1.0");
 
 	/* define general widget functions */
 	widman->default_widget_methods(&gen_methods);
 
 	orig_bind                = gen_methods.bind;
+	orig_bind_callback       = gen_methods.bind_callback;
 	orig_set_app_id          = gen_methods.set_app_id;
 	orig_updatepos           = gen_methods.updatepos;
 
@@ -608,6 +608,7 @@ int init_scale(struct mtk_services *d)
 	gen_methods.updatepos    = scale_updatepos;
 	gen_methods.find         = scale_find;
 	gen_methods.bind         = scale_bind;
+	gen_methods.bind_callback = scale_bind_callback;
 	gen_methods.set_app_id   = scale_set_app_id;
 	gen_methods.calc_minmax  = scale_calc_minmax;
 	gen_methods.free_data    = scale_free_data;
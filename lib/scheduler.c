@@ -23,6 +23,13 @@
 #include "scope.h"
 #include "screen.h"
 #include "timer.h"
+#include "fontman.h"
+#include "tick.h"
+#include "stream.h"
+#include "slab.h"
+#include "widman.h"
+#include "table.h"
+#include "pixmap.h"
 
 /* MTK client includes */
 #include "mtklib.h"
@@ -36,9 +43,18 @@ static struct screen_services    *screen;
 static struct redraw_services    *redraw;
 static struct timer_services     *timer;
 static struct userstate_services *userstate;
+static struct fontman_services   *fontman;
+static struct tick_services      *tick;
+static struct stream_services    *stream;
+static struct slab_services      *slab;
+static struct widman_services    *widman;
 
 int config_redraw_granularity = 350*1000;
 
+extern u32 boot_start_time;
+extern SCREEN *curr_scr;
+static int boot_time = -1;   /* boot-to-first-frame time in microseconds */
+
 
 /*******************************
  ** MTK client lib emulation **
@@ -46,10 +62,24 @@ int config_redraw_granularity = 350*1000;
 
 static char cmdstr[32768];
 
+/**
+ * Execute command with allocations going to the arena of the application
+ */
+static int exec_in_arena(int app_id, const char *cmd, char *dst, int dst_size)
+{
+	int prev = slab->set_arena(app_id);
+	int ret  = script->exec_command(app_id, (char *)cmd, dst, dst_size);
+
+	slab->set_arena(prev);
+	return ret;
+}
+
 int mtk_init_app(const char *appname)
 {
 	s32 app_id = appman->reg_app(appname);
+	int prev = slab->set_arena(app_id);
 	SCOPE *rootscope = scope->create();
+	slab->set_arena(prev);
 	INFO(printf("mtk_init_app called\n"));
 	appman->set_rootscope(app_id, rootscope);
 	INFO(printf("mtk_init_app returns app_id=%d\n", (int)app_id));
@@ -61,13 +91,16 @@ int mtk_deinit_app(int app_id)
 	INFO(printf("Server(deinit_app): application (id=%lu) deinit requested\n", app_id);)
 	screen->forget_children(app_id);
 	appman->unreg_app(app_id);
+
+	/* hand the chunks of the application back to the heap at once */
+	slab->release_arena(app_id);
 	return 0;
 }
 
 int mtk_cmd(int app_id, const char *cmd)
 {
 	INFO(printf("app %d requests mtk_cmd \"%s\"\n", (int)app_id, cmd));
-	return script->exec_command(app_id, (char *)cmd, NULL, 0);
+	return exec_in_arena(app_id, cmd, NULL, 0);
 }
 
 int mtk_cmdf(int app_id, const char *format, ...)
@@ -104,7 +137,7 @@ int mtk_req(int app_id, char *dst, int dst_size, const char *cmd)
 	int ret;
 
 	INFO(printf("mtk_req \"%s\" requested by app_id=%lu\n", cmd, (u32)app_id);)
-	ret = script->exec_command(app_id, (char *)cmd, dst, dst_size);
+	ret = exec_in_arena(app_id, cmd, dst, dst_size);
 
 	return ret;
 }
@@ -119,14 +152,52 @@ int mtk_reqf(int app_id, char *dst, int dst_size, const char *format, ...)
 	return mtk_req(app_id, dst, dst_size, cmdstr);
 }
 
-void mtk_bind(int app_id,const char *var, const char *event_type,
-               void (*callback)(mtk_event *,void *),void *arg) {
-	mtk_cmdf(app_id, "%s.bind(%s, \"%08lx, %08lx\")",
-	          var, event_type, (int)callback, (int)arg);
+int mtk_bind_event(int app_id, const char *var, int event,
+                   void (*callback)(mtk_event *,void *), void *arg, int filter) {
+	WIDGET *w = script->lookup_widget(app_id, var);
+	int prev;
+
+	if (!w || (event < 0) || (event >= MTK_BIND_NUM_TYPES)) return -1;
+
+	prev = slab->set_arena(app_id);
+	w->gen->bind_callback(w, event, callback, arg, filter);
+	slab->set_arena(prev);
+	return 0;
+}
+
+/**
+ * Look up event type by its identifier
+ *
+ * \return  event type (MTK_BIND_*) or -1 if the event is unknown
+ */
+static int lookup_bind_type(const char *event_type)
+{
+	char ident[16];
+	int len;
+
+	/* the event type may be specified with quotes */
+	if (event_type[0] == '"') event_type++;
+	len = strlen(event_type);
+	if (len && (event_type[len - 1] == '"')) len--;
+
+	/* longer identifiers are no event types known to MTK */
+	if (len >= sizeof(ident)) return -1;
+	memcpy(ident, event_type, len);
+	ident[len] = 0;
+
+	return widman->get_bind_type(ident);
+}
+
+int mtk_bind(int app_id,const char *var, const char *event_type,
+             void (*callback)(mtk_event *,void *),void *arg) {
+	int type = lookup_bind_type(event_type);
+
+	if (type < 0) return -1;
+	return mtk_bind_event(app_id, var, type, callback, arg, 0);
 }
 
-void mtk_bindf(int id, const char *varfmt, const char *event_type,
-                void (*callback)(mtk_event *,void *), void *arg,...) {
+int mtk_bindf(int id, const char *varfmt, const char *event_type,
+              void (*callback)(mtk_event *,void *), void *arg,...) {
 	static char varstr[1024];
 	va_list list;
 
@@ -134,9 +205,18 @@ void mtk_bindf(int id, const char *varfmt, const char *event_type,
 	vsnprintf(varstr, 1024, varfmt, list);
 	va_end(list);
 
-	snprintf(cmdstr, 256,"%s.bind(\"%s\", \"%08x, %08x\")",
-	         varstr, event_type, (int)callback, (int)arg);
-	mtk_cmd(id, cmdstr);
+	return mtk_bind(id, varstr, event_type, callback, arg);
+}
+
+int mtk_table_source(int app_id, const char *var,
+                     void (*callback)(int row, int column, char *dst, int dst_size, void *arg),
+                     void *arg) {
+	WIDGET *w = script->lookup_widget(app_id, var);
+
+	if (!w || strcmp(w->gen->get_type(w), "Table")) return -1;
+
+	((TABLE *)w)->tab->set_source((TABLE *)w, callback, arg);
+	return 0;
 }
 
 static int convert_type(int t)
@@ -154,7 +234,7 @@ static int convert_type(int t)
 void mtk_input(mtk_event *e, int count)
 {
 	EVENT internal_event[MAX_EVENTS+1];
-	int i;
+	int i, processed;
 	static int meta_l, meta_r;
 	static int up, down, left, right, btn;
 	static int multiplier;
@@ -255,7 +335,122 @@ void mtk_input(mtk_event *e, int count)
 	} else
 		multiplier = 0;
 	userstate->handle(internal_event, count);
-	redraw->process_pixels(config_redraw_granularity);
+	stream->poll();
+	processed = redraw->process_pixels(config_redraw_granularity);
+
+	/* the first frame is complete when the initial redraw queue ran empty */
+	if ((boot_time < 0) && (processed > 0) && !redraw->get_noque()) {
+		boot_time = timer->get_diff(boot_start_time, timer->get_time());
+		INFO(printf("Scheduler: first frame after %d usec\n", boot_time));
+	}
+}
+
+int mtk_next_deadline(void)
+{
+	/* pending redraws are processed by the next call of mtk_input */
+	if (redraw->get_noque() || stream->pending()) return 0;
+
+	return tick->next_deadline();
+}
+
+struct mtk_stream *mtk_stream_create(void *buf0, void *buf1, void *buf2)
+{
+	return (struct mtk_stream *)stream->create(buf0, buf1, buf2);
+}
+
+void mtk_stream_destroy(struct mtk_stream *s)
+{
+	stream->destroy((STREAM *)s);
+}
+
+void *mtk_stream_acquire(struct mtk_stream *s)
+{
+	return stream->acquire((STREAM *)s);
+}
+
+void mtk_stream_publish(struct mtk_stream *s)
+{
+	stream->publish((STREAM *)s);
+}
+
+void mtk_stream_stats(struct mtk_stream *s, unsigned int *produced,
+                      unsigned int *displayed, unsigned int *dropped)
+{
+	stream->get_stats((STREAM *)s, produced, displayed, dropped);
+}
+
+int mtk_pixmap_stream(int app_id, const char *var, struct mtk_stream *s)
+{
+	WIDGET *w = script->lookup_widget(app_id, var);
+
+	if (!w || strcmp(w->gen->get_type(w), "Pixmap")) return -1;
+
+	((PIXMAP *)w)->pixm->set_stream((PIXMAP *)w, (STREAM *)s);
+	return 0;
+}
+
+int mtk_register_font(const char *name, const void *tff, unsigned int size)
+{
+	return fontman->register_tff((char *)name, (void *)tff, size);
+}
+
+int mtk_load_font(const char *name, const char *path)
+{
+	return fontman->load_tff((char *)name, (char *)path);
+}
+
+int mtk_register_utff_font(const char *name, const void *utff, unsigned int size)
+{
+	return fontman->register_utff((char *)name, (void *)utff, size);
+}
+
+int mtk_get_glyph_hit_rate(void)
+{
+	s32 hits, misses;
+
+	fontman->get_atlas_stats(&hits, &misses);
+	if (hits + misses == 0) return -1;
+	return (int)(((long long)hits*100)/(hits + misses));
+}
+
+void mtk_get_layout_stats(int *passes, int *avoided)
+{
+	s32 p, a;
+
+	widman->get_layout_stats(&p, &a);
+	if (passes)  *passes  = p;
+	if (avoided) *avoided = a;
+}
+
+int mtk_get_find_hit_rate(void)
+{
+	s32 finds, cached;
+
+	screen->get_find_stats(curr_scr, &finds, &cached);
+	if (finds == 0) return -1;
+	return (int)(((long long)cached*100)/finds);
+}
+
+int mtk_get_boot_time(void)
+{
+	return boot_time;
+}
+
+int mtk_get_pool_stats(int index, const char **name, int *obj_size,
+                       int *used, int *avail, int *chunks)
+{
+	SLAB *p = slab->next(NULL);
+
+	for (; p && index > 0; index--) p = slab->next(p);
+	if (!p) return -1;
+
+	slab->get_stats(p, (char **)name, obj_size, used, avail, chunks);
+	return 0;
+}
+
+int mtk_release_memory(void)
+{
+	return slab->shrink();
 }
 
 int mtk_get_keystate(int app_id, int keycode)
@@ -281,6 +476,11 @@ int init_simple_scheduler(struct mtk_services *d)
 	scope     = (struct scope_services     *)d->get_module("Scope 1.0");
 	screen    = (struct screen_services    *)d->get_module("Screen 1.0");
 	timer     = (struct timer_services     *)d->get_module("Timer 1.0");
+	fontman   = (struct fontman_services   *)d->get_module("FontManager 1.0");
+	tick      = (struct tick_services      *)d->get_module("Tick 1.0");
+	stream    = (struct stream_services    *)d->get_module("Stream 1.0");
+	slab      = (struct slab_services      *)d->get_module("Slab 1.0");
+	widman    = (struct widman_services    *)d->get_module("WidgetManager 1.0");
 
 	return 1;
 }
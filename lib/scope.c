@@ -19,12 +19,14 @@ struct scope;
 #include <stdio.h>
 #include "mtkstd.h"
 #include "hashtab.h"
+#include "atom.h"
 #include "scope.h"
 #include "script.h"
 #include "widman.h"
 #include "appman.h"
 #include "widget_data.h"
 #include "widget_help.h"
+#include "slab.h"
 
 #define VAR_HASHTAB_SIZE  32    /* applications variable hash table config */
 #define VAR_HASH_CHARS     5
@@ -33,14 +35,19 @@ static struct hashtab_services *hashtab;
 static struct widman_services  *widman;
 static struct script_services  *script;
 static struct appman_services  *appman;
+static struct atom_services    *atom;
+static struct slab_services    *slab;
+
+static char *atom_scope;        /* type identifier of Scope widgets */
+static SLAB *var_pool;
 
 struct scope_data {
 	HASHTAB *vars;
 };
 
 struct variable {
-	char   *name;   /* variable name  */
-	char   *type;   /* variable type  */
+	char   *name;   /* variable name (atom) */
+	char   *type;   /* variable type (atom) */
 	WIDGET *value;  /* variable value */
 };
 
@@ -51,24 +58,32 @@ int init_scope(struct mtk_services *d);
  ** General widget methods **
  ****************************/
 
+/**
+ * Delete variable and dissolve the reference to its widget
+ *
+ * This function is called by the hash table for each variable when
+ * the last scope that uses the table goes away.
+ */
+static void free_var(void *value)
+{
+	struct variable *v = value;
+
+	if (v->value)
+		v->value->gen->dec_ref(v->value);
+	slab->free(v);
+}
+
+
 /**
  * Deallocate scope data
  */
 static void scope_free_data(SCOPE *s)
 {
-	struct variable *var;
-	WIDGET *w;
-
-	/* delete variables and dissolve the references to their widgets */
-	var = hashtab->get_first(s->sd->vars);
-	while (var) {
-		if ((w = var->value))
-			w->gen->dec_ref(w);
-		var = hashtab->get_next(s->sd->vars, var);
-	}
-
-	/* now, destroy the hash table */
+	/* destroy the hash table, imported tables stay with their owner */
 	hashtab->dec_ref(s->sd->vars);
+
+	/* paths that were resolved through this scope are stale now */
+	script->invalidate_paths();
 }
 
 
@@ -77,7 +92,7 @@ static void scope_free_data(SCOPE *s)
  */
 static char *scope_get_type(SCOPE *v)
 {
-	return "Scope";
+	return atom_scope;
 }
 
 
@@ -88,44 +103,61 @@ static char *scope_get_type(SCOPE *v)
 /**
  * Redefine a variable or create a new one if needed
  *
- * The type argument is not replicated. The caller must ensure that the
- * type string exists as int as the variable exists!
+ * The variable name and type are interned as atoms. Hence, the caller
+ * does not need to keep the type string around.
  */
 static int scope_set_var(SCOPE *s, char *type, char *name, int len, WIDGET *value)
 {
 	struct variable *v;
+	char *name_atom = atom->intern(name, len);
+
+	if (!name_atom) return -1;
 
 	/* does variable already exists? */
-	v = hashtab->get_elem(s->sd->vars, name, len);
+	v = hashtab->get_atom(s->sd->vars, name_atom);
 	
 	/* create a new variable */
 	if (!v) {
-		int name_len = MIN(strlen(name), len);
-		v = zalloc(sizeof(struct variable) + strlen(name) + 2);
+		v = slab->alloc(var_pool);
 		if (!v) return -1;
-		v->name = (char *)((adr)v + sizeof(struct variable));
-		memcpy(v->name, name, name_len);
-		v->name[name_len] = 0;
+		v->name = name_atom;
 		INFO(printf("scope_set_var: variable %s\n", v->name));
-		hashtab->add_elem(s->sd->vars, v->name, v);
+		hashtab->add_atom(s->sd->vars, v->name, v);
 	} else {
 
 		/* loose the reference to the old content */
 		if (v->value)
 			v->value->gen->dec_ref(v->value);
 	}
-	v->type  = type;
+	v->type  = atom->intern(type, 255);
 	v->value = value;
+
+	/* cached paths may refer to the old content of the variable */
+	script->invalidate_paths();
 	return 0;
 }
 
 
+/**
+ * Look up variable by the name given as token
+ */
+static inline struct variable *lookup_var(SCOPE *s, char *name, int len)
+{
+	char *name_atom = atom->lookup(name, len);
+
+	/* the name was never interned - so there cannot be such a variable */
+	if (!name_atom) return NULL;
+
+	return hashtab->get_atom(s->sd->vars, name_atom);
+}
+
+
 /**
  * Request the value of a variable
  */
 static WIDGET *scope_get_var(SCOPE *s, char *name, int len)
 {
-	struct variable *v = hashtab->get_elem(s->sd->vars, name, len);
+	struct variable *v = lookup_var(s, name, len);
 	return v ? v->value : NULL;
 }
 
@@ -135,7 +167,7 @@ static WIDGET *scope_get_var(SCOPE *s, char *name, int len)
  */
 static char *scope_get_vartype(SCOPE *s, char *name, int len)
 {
-	struct variable *v = hashtab->get_elem(s->sd->vars, name, len);
+	struct variable *v = lookup_var(s, name, len);
 	return v ? v->type : NULL;
 }
 
@@ -145,23 +177,31 @@ static char *scope_get_vartype(SCOPE *s, char *name, int len)
  */
 static SCOPE *scope_get_subscope(SCOPE *s, char *name, int len)
 {
-	struct variable *v = hashtab->get_elem(s->sd->vars, name, len);
+	struct variable *v = lookup_var(s, name, len);
 
-	if (!v || !v->type || !v->value) return NULL;
-	if (!mtk_streq(v->type, "Scope", 256)) return NULL;
+	if (!v || !v->value || v->type != atom_scope) return NULL;
 
 	return v->value;
 }
 
+struct enum_args {
+	scope_enum e;
+	void *user;
+};
+
+static void enum_var(void *value, void *arg)
+{
+	struct variable *v = value;
+	struct enum_args *args = arg;
+
+	args->e(v->name, v->type, v->value, args->user);
+}
+
 void scope_enumerate(SCOPE *s, scope_enum e, void *user)
 {
-	struct variable *v;
-	
-	v = hashtab->get_first(s->sd->vars);
-	while(v != NULL) {
-		e(v->name, v->type, v->value, user);
-		v = hashtab->get_next(s->sd->vars, v);
-	}
+	struct enum_args args = { e, user };
+
+	hashtab->for_each(s->sd->vars, enum_var, &args);
 }
 
 /**
@@ -182,6 +222,7 @@ static int scope_voodoo(SCOPE *s, char *app_name)
 	hashtab->dec_ref(s->sd->vars);
 	hashtab->inc_ref(rs->sd->vars);
 	s->sd->vars = rs->sd->vars;
+	script->invalidate_paths();
 
 	return 1;
 }
@@ -209,9 +250,10 @@ static SCOPE *create(void)
 	/* create hash table to store the variables of the scope */
 	new->sd->vars = hashtab->create(VAR_HASHTAB_SIZE, VAR_HASH_CHARS);
 	if (!new->sd->vars) {
-		free(new);
+		slab->free(new);
 		return NULL;
 	}
+	hashtab->set_destroy(new->sd->vars, free_var);
 	return new;
 }
 
@@ -243,6 +285,11 @@ int init_scope(struct mtk_services *d)
 	script  = d->get_module("Script 1.0");
 	hashtab = d->get_module("HashTable 1.0");
 	appman  = d->get_module("ApplicationManager 1.0");
+	atom    = d->get_module("Atom 1.0");
+	slab    = d->get_module("Slab 1.0");
+
+	atom_scope = atom->intern("Scope", 255);
+	var_pool   = slab->get_pool("variable", sizeof(struct variable));
 
 	/* define general widget functions */
 	widman->default_widget_methods(&gen_methods);
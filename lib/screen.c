@@ -20,6 +20,7 @@ struct screen;
 #define WIDGET struct screen
 
 #include <stdio.h>
+#include <string.h>
 #include "mtkstd.h"
 #include "widget_data.h"
 #include "widget_help.h"
@@ -57,6 +58,16 @@ struct screen_data {
 	struct gfx_ds *scr_ds;   /* GFX container to use for the screen output */
 	WINDOW *desk;            /* Desktop                                    */
 	SCREEN *next;            /* next screen in the screen list             */
+
+	/* hit-test cache, see 'scr_find' */
+	WIDGET *hit;             /* result of last find or NULL                */
+	WIDGET *hit_win;         /* window that contains the hit widget        */
+	int     hit_x1, hit_y1;  /* screen area for which the hit is valid     */
+	int     hit_x2, hit_y2;
+	int     hit_px, hit_py;  /* absolute position of the hit's parent      */
+	u32     hit_gen;         /* layout generation of the cached hit        */
+	s32     num_finds;       /* number of find calls                       */
+	s32     num_cached;      /* number of find calls answered by the cache */
 };
 
 int init_screen(struct mtk_services *d);
@@ -65,12 +76,34 @@ SCREEN *first_scr;
 SCREEN *curr_scr;
 
 extern int config_dropshadows;
+extern int config_transparency;
 
 
 /********************************
  ** Functions for internal use **
  ********************************/
 
+/**
+ * Check if the origin of a redraw request is visible through a window
+ *
+ * The redraw request refers to the area of the origin window. A window
+ * in front of the origin only needs to be drawn if the origin shines
+ * through it, which is possible within its drop shadow and, with
+ * transparency enabled, anywhere. The area is given in screen
+ * coordinates and lies within the window.
+ */
+static inline int origin_visible(WIDGET *cw, WIDGET *origin, int x1, int y1, int x2, int y2)
+{
+	if (!origin || cw == origin || config_transparency) return 1;
+	if (!config_dropshadows) return 0;
+
+	return (x1 < cw->wd->x + win->shadow_left)
+	    || (x2 > cw->wd->x + cw->wd->w - 1 - win->shadow_right)
+	    || (y1 < cw->wd->y + win->shadow_top)
+	    || (y2 > cw->wd->y + cw->wd->h - 1 - win->shadow_bottom);
+}
+
+
 static int draw_rec(GFX_CONTAINER *ds, WIDGET *cw, WIDGET *origin,
                     int cx1, int cy1, int cx2, int cy2, int do_update) {
 	int   sx1, sy1, sx2, sy2;
@@ -88,22 +121,22 @@ static int draw_rec(GFX_CONTAINER *ds, WIDGET *cw, WIDGET *origin,
 	/* if there is an intersection - subdivide area */
 	if ((sx1 <= sx2) && (sy1 <= sy2)) {
 
-		gfx->push_clipping(ds, sx1, sy1, sx2 - sx1 + 1, sy2 - sy1 + 1);
-
 		/*
-		 * If an origin is specified, first find out if the specified
-		 * origin is visible at the current screen area and then, draw
-		 * it (by specifying NULL as origin). In fact, if we specify
-		 * an origin != NULL, no drawing is performed at all.
+		 * If an origin is specified, only draw the window if the
+		 * origin is visible at the current screen area.
 		 */
-		need_update |= cw->gen->draw(cw, ds, 0, 0, origin);
-		if (origin && need_update)
-			cw->gen->draw(cw, ds, 0, 0, NULL);
+		if (origin_visible(cw, origin, sx1, sy1, sx2, sy2)) {
+			gfx->push_clipping(ds, sx1, sy1, sx2 - sx1 + 1, sy2 - sy1 + 1);
+			need_update |= cw->gen->draw(cw, ds, 0, 0) | (origin != NULL);
+			gfx->pop_clipping(ds);
+		}
 
-		gfx->pop_clipping(ds);
 		if (need_update && do_update)
 			gfx->update(ds, sx1, sy1, sx2 - sx1 + 1, sy2 - sy1 + 1);
 
+		/* the origin cannot be visible through windows behind it */
+		if (cw == origin) return need_update;
+
 		/* take care about the rest */
 		if ((next = cw->gen->get_next(cw)) == NULL) return need_update;
 		if (sx1 > cx1) need_update |= draw_rec(ds, next, origin, cx1, MAX(cy1, sy1), sx1 - 1, MIN(cy2, sy2), do_update);
@@ -182,6 +215,9 @@ static void create_desktop(SCREEN *scr)
 		scr->sd->desk->gen->update((WIDGET *)scr->sd->desk);
 	}
 
+	/* scale the wallpaper once instead of at each redraw */
+	bg->prepare_wallpaper(scr_w, scr_h);
+
 	/* move desktop window to the screen area */
 	scr->scr->place(scr, (WIDGET *)scr->sd->desk, -win->shadow_left, -win->shadow_top,
 		scr_w+win->shadow_left+win->shadow_right,
@@ -211,6 +247,8 @@ static void chain_window(SCREEN *scr, WIDGET *win, WIDGET *after)
 	}
 
 	win->wd->parent = scr;
+	scr->sd->hit = NULL;
+	widman->invalidate_geometry();
 }
 
 
@@ -243,6 +281,8 @@ static void unchain_window(SCREEN *scr, WIDGET *win)
 
 	/* isolate unchained window */
 	win->wd->parent = win->wd->next = NULL;
+	scr->sd->hit = NULL;
+	widman->invalidate_geometry();
 }
 
 
@@ -261,6 +301,60 @@ static inline void redraw_window_area(SCREEN *scr, WIDGET *win)
  ** General widget methods **
  ****************************/
 
+/**
+ * Check if the hit-test cache answers a find request
+ *
+ * The cached hit is valid as long as no widget changed its geometry,
+ * the position lies within the screen area of the hit, no window
+ * above covers the position, and the hit widget has no child at the
+ * position.
+ */
+static inline int hit_cached(SCREEN *scr, int x, int y)
+{
+	struct screen_data *sd = scr->sd;
+	WIDGET *cw;
+
+	if (!sd->hit || sd->hit_gen != widman->get_layout_gen()
+	 || x < sd->hit_x1 || x > sd->hit_x2 || y < sd->hit_y1 || y > sd->hit_y2)
+		return 0;
+
+	for (cw = sd->first_win; cw && cw != sd->hit_win; cw = cw->gen->get_next(cw))
+		if (x >= cw->wd->x && x < cw->wd->x + cw->wd->w
+		 && y >= cw->wd->y && y < cw->wd->y + cw->wd->h) return 0;
+
+	return sd->hit->gen->find(sd->hit, x - sd->hit_px, y - sd->hit_py) == sd->hit;
+}
+
+
+/**
+ * Remember result of a find request in the hit-test cache
+ *
+ * The screen area of the hit is the widget area clipped to the areas
+ * of its parents. Children of widgets with the WID_FLAGS_TILING flag,
+ * such as Grids and Windows, cannot be covered by their siblings. For
+ * other parents, such as frames with scrollbars on top of their
+ * content, the result is not cached.
+ */
+static void remember_hit(SCREEN *scr, WIDGET *hit)
+{
+	struct screen_data *sd = scr->sd;
+	WIDGET *cw, *parent;
+
+	sd->hit = NULL;
+	if (!hit) return;
+
+	for (cw = hit; (parent = cw->wd->parent) != (WIDGET *)scr; cw = parent)
+		if (!parent || !(parent->wd->flags & WID_FLAGS_TILING)) return;
+
+	sd->hit_px  = hit->gen->get_abs_x(hit->wd->parent);
+	sd->hit_py  = hit->gen->get_abs_y(hit->wd->parent);
+	sd->hit_win = hit->gen->get_abs_clip(hit, &sd->hit_x1, &sd->hit_y1,
+	                                          &sd->hit_x2, &sd->hit_y2);
+	sd->hit_gen = widman->get_layout_gen();
+	sd->hit     = hit;
+}
+
+
 /**
  * Find widget at a specified absolute screen position
  */
@@ -268,14 +362,35 @@ static WIDGET *scr_find(SCREEN *scr, int x, int y)
 {
 	WIDGET *win = scr->sd->first_win;
 	WIDGET *result;
+
+	scr->sd->num_finds++;
+	if (hit_cached(scr, x, y)) {
+		scr->sd->num_cached++;
+		return scr->sd->hit;
+	}
+
 	while (win != NULL) {
-		if ((result = win->gen->find(win, x, y))) return result;
+		if ((result = win->gen->find(win, x, y))) {
+			remember_hit(scr, result);
+			return result;
+		}
 		win = win->gen->get_next(win);
 	}
+	scr->sd->hit = NULL;
 	return NULL;
 }
 
 
+/**
+ * Request number of find calls and of calls answered by the hit cache
+ */
+static void get_find_stats(SCREEN *scr, s32 *finds, s32 *cached)
+{
+	if (finds)  *finds  = scr ? scr->sd->num_finds  : 0;
+	if (cached) *cached = scr ? scr->sd->num_cached : 0;
+}
+
+
 /**
  * Draw content at the specified area of the screen
  *
@@ -303,7 +418,7 @@ static int scr_drawarea(SCREEN *scr, WIDGET *origin, int x, int y, int w, int h)
 int transparency_depth;  /* current depth of transparency */
 
 static int scr_drawbehind(SCREEN *scr, WIDGET *win,
-                          int x, int y, int w, int h, WIDGET *origin) {
+                          int x, int y, int w, int h) {
 	int ret = 0;
 	WIDGET *next;
 
@@ -316,11 +431,11 @@ static int scr_drawbehind(SCREEN *scr, WIDGET *win,
 
 	/* if maximum depth is reached, just paint a black box */
 	if (transparency_depth >= 1) {
-		if (!origin) win->gen->draw_bg(win, scr->sd->scr_ds, x, y, w, h, NULL, 1);
+		win->gen->draw_bg(win, scr->sd->scr_ds, x, y, w, h, 1);
 		return 0;
 	}
 	transparency_depth++;
-	if (next) ret |= draw_rec(scr->sd->scr_ds, next, origin, x, y, x + w - 1, y + h - 1, 0);
+	if (next) ret |= draw_rec(scr->sd->scr_ds, next, NULL, x, y, x + w - 1, y + h - 1, 0);
 	transparency_depth--;
 
 	return ret;
@@ -402,8 +517,10 @@ void scr_move_windows_inside(SCREEN *scr, int maxx, int maxy)
 static void scr_set_gfx(SCREEN *scr, GFX_CONTAINER *ds)
 {
 	scr->sd->scr_ds = ds;
+	scr->sd->hit    = NULL;
 	scr->wd->min_w = scr->wd->max_w = scr->wd->w = gfx->get_width(ds);
 	scr->wd->min_h = scr->wd->max_h = scr->wd->h = gfx->get_height(ds);
+	widman->invalidate_geometry();
 
 	/*
 	 * Now we know the size of the gfx container,
@@ -704,6 +821,7 @@ static void forget_children(int app_id)
 static struct screen_services services = {
 	create,
 	forget_children,
+	get_find_stats,
 };
 
 
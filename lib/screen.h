@@ -49,6 +49,12 @@ struct screen_services {
 	 * all child widgets from all screens.
 	 */
 	void (*forget_children) (int app_id);
+
+	/*
+	 * Request number of find requests and the number of requests
+	 * that were answered by the hit-test cache of the screen
+	 */
+	void (*get_find_stats) (SCREEN *scr, s32 *finds, s32 *cached);
 };
 
 #define NOARG -2147483646   /* magic value to indicate the use of a default value */
@@ -16,11 +16,13 @@
 #include "widget.h"
 #include "appman.h"
 #include "hashtab.h"
+#include "atom.h"
 #include "tokenizer.h"
 #include "script.h"
 #include "scope.h"
 #include "window.h"
 #include "widget_data.h"
+#include "slab.h"
 
 #include "mtkdef.h"
 
@@ -38,11 +40,22 @@
 #define MAX_ARGS      16    /* max number of arguments per mtk command */
 #define MAX_ERRBUF    256   /* max size of error result substring       */
 
+#define PATH_CACHE_SIZE   16  /* number of cached paths per application    */
+#define PATH_CACHE_MAXLEN 64  /* max length of a cacheable path string     */
+
 static struct appman_services    *appman;
 static struct hashtab_services   *hashtab;
 static struct tokenizer_services *tokenizer;
+static struct atom_services      *atom;
+static struct slab_services      *slab;
 
 static HASHTAB *widtypes;
+static HASHTAB *lazy_widtypes;
+static struct mtk_services *mtk_services;
+
+/* atoms of identifiers that are known to the interpreter */
+static char *atom_int, *atom_float, *atom_string, *atom_boolean;
+static char *atom_widget, *atom_scope, *atom_new, *atom_set;
 
 
 /**
@@ -91,20 +104,28 @@ struct interpreter {
  * Internal widget type representation
  */
 struct widtype {
-	char    *ident;          /* name of widget type          */
+	char    *ident;          /* name of widget type (atom)   */
 	void * (*create)(void);  /* widget creation routine      */
 	HASHTAB *methods;        /* widget methods information   */
 	HASHTAB *attribs;        /* widget attributs information */
 };
 
 
+/**
+ * Widget type whose module is initialized on the first use
+ */
+struct lazy_widtype {
+	int (*init)(struct mtk_services *);   /* module entry point */
+};
+
+
 /**
  * Internal method argument representation
  */
 struct methodarg;
 struct methodarg {
-	char *arg_name;          /* argument name                   */
-	char *arg_type;          /* argument type identifier string */
+	char *arg_name;          /* argument name (atom)            */
+	char *arg_type;          /* argument type identifier (atom) */
 	char *arg_default;       /* argument default value          */
 	int   baseclass;         /* base class of argument type     */
 	struct methodarg *next;  /* next argument in argument list  */
@@ -115,8 +136,8 @@ struct methodarg {
  * Internal method representation
  */
 struct method {
-	char    *name;                  /* method name string               */
-	char    *ret_type;              /* identifier string of return type */
+	char    *name;                  /* method name (atom)               */
+	char    *ret_type;              /* identifier of return type (atom) */
 	int      ret_baseclass;         /* base class of return type        */
 	void  *(*routine)(void *,...);  /* method address                   */
 	struct methodarg *args;         /* list of arguments                */
@@ -127,8 +148,8 @@ struct method {
  * Internal attribute representation
  */
 struct attrib {
-	char    *name;                   /* name of attribute                    */
-	char    *type;                   /* type of attribute                    */
+	char    *name;                   /* name of attribute (atom)             */
+	char    *type;                   /* type of attribute (atom)             */
 	int      baseclass;              /* base class of attribute type         */
 	void  *(*get) (void *);          /* get function to request the attibute */
 	void   (*set) (void *, void *);  /* set function to set the attribute    */
@@ -148,6 +169,24 @@ struct attrib {
 #define CMD_TYPE_REQUEST    3
 
 
+/**
+ * Cached resolution of a dotted variable path such as 'a.b.c'
+ *
+ * Entries are valid as long as their generation matches the global
+ * path_cache_gen, which is incremented on each change of any scope.
+ */
+struct path_cache_entry {
+	u32             gen;                      /* generation of the entry  */
+	int             len;                      /* length of path string    */
+	char            path[PATH_CACHE_MAXLEN];  /* path string              */
+	WIDGET         *w;                        /* resolved widget          */
+	struct widtype *w_type;                   /* type of resolved widget  */
+};
+
+static struct path_cache_entry *path_cache[MAX_APPS];
+static u32 path_cache_gen = 1;
+
+
 int init_script(struct mtk_services *d);
 
 
@@ -288,15 +327,32 @@ static char *new_symbol(const char *s,u32 length)
 }
 
 
+/**
+ * Return atom of the specified token or NULL if there is none
+ */
+static inline char *token_atom(INTERPRETER *ci, int tok)
+{
+	return atom->lookup(ci->tokens[tok], ci->tok_len[tok]);
+}
+
+
+/**
+ * Determine base class of a type
+ *
+ * \param vartype  atom of the type identifier
+ */
 static u32 get_baseclass(char *vartype)
 {
 	if (!vartype) return 0;
-	if (mtk_streq(vartype,"int",    5)) return VAR_BASECLASS_LONG;
-	if (mtk_streq(vartype,"float",   6)) return VAR_BASECLASS_FLOAT;
-	if (mtk_streq(vartype,"string",  7)) return VAR_BASECLASS_STRING;
-	if (mtk_streq(vartype,"boolean", 8)) return VAR_BASECLASS_BOOLEAN;
-	if (mtk_streq(vartype,"Widget",  7)) return VAR_BASECLASS_WIDGET;
-	if (hashtab->get_elem(widtypes, vartype, 255)) return VAR_BASECLASS_WIDGET;
+	if (vartype == atom_int)     return VAR_BASECLASS_LONG;
+	if (vartype == atom_float)   return VAR_BASECLASS_FLOAT;
+	if (vartype == atom_string)  return VAR_BASECLASS_STRING;
+	if (vartype == atom_boolean) return VAR_BASECLASS_BOOLEAN;
+	if (vartype == atom_widget)  return VAR_BASECLASS_WIDGET;
+	if (hashtab->get_atom(widtypes, vartype)) return VAR_BASECLASS_WIDGET;
+
+	/* types of modules that are not initialized yet are widgets too */
+	if (hashtab->get_atom(lazy_widtypes, vartype)) return VAR_BASECLASS_WIDGET;
 	return VAR_BASECLASS_UNDEFINED;
 }
 
@@ -464,30 +520,83 @@ static int convert_result(int baseclass, union arg *value, char *dst, int dst_le
 }
 
 
+/**
+ * Look up widget type, initialize its module on the first use
+ */
+static struct widtype *get_widtype(char *ident)
+{
+	struct widtype *w_type = hashtab->get_atom(widtypes, ident);
+	struct lazy_widtype *lazy;
+	int (*init)(struct mtk_services *);
+	int arena;
+
+	if (w_type) return w_type;
+
+	lazy = hashtab->get_atom(lazy_widtypes, ident);
+	if (!lazy || !lazy->init) return NULL;
+
+	/*
+	 * The module registers the widget type by itself. Its data must
+	 * not end up in the arena of the application that uses it first.
+	 */
+	init = lazy->init;
+	lazy->init = NULL;
+	INFO(printf("Script(get_widtype): init module of %s\n", ident);)
+	arena = slab->set_arena(0);
+	init(mtk_services);
+	slab->set_arena(arena);
+
+	return hashtab->get_atom(widtypes, ident);
+}
+
+
 /***********************
  ** Service functions **
  ***********************/
 
 static void *register_widget_type(char *widtype_name,void *(*create_func)(void))
 {
-	struct widtype *new = (struct widtype *)zalloc(sizeof(struct widtype));
+	struct widtype *new;
+	char *ident = atom->intern(widtype_name, 255);
 
-	if (hashtab->get_elem(widtypes, widtype_name, 255)) {
+	if (hashtab->get_atom(widtypes, ident)) {
 		INFO(printf("Script(register_widget_type): widget type already exists\n");)
 		return NULL;
 	}
 
+	new = (struct widtype *)zalloc(sizeof(struct widtype));
+	if (!new) return NULL;
+
 	new->create  = create_func;
 	new->methods = hashtab->create(METHODS_HASHTAB_SIZE, METHODS_HASH_CHARS);
 	new->attribs = hashtab->create(ATTRIBS_HASHTAB_SIZE, ATTRIBS_HASH_CHARS);
-	new->ident   = widtype_name;
-	hashtab->add_elem(widtypes, widtype_name, new);
+	new->ident   = ident;
+	hashtab->add_atom(widtypes, ident, new);
 
 	/* return pointer to widget type structure */
 	return new;
 }
 
 
+static void register_lazy_widget_type(char *widtype_name,
+                                      int (*init_func)(struct mtk_services *))
+{
+	struct lazy_widtype *new;
+	char *ident = atom->intern(widtype_name, 255);
+
+	if (hashtab->get_atom(widtypes, ident) || hashtab->get_atom(lazy_widtypes, ident)) {
+		INFO(printf("Script(register_lazy_widget_type): widget type already exists\n");)
+		return;
+	}
+
+	new = (struct lazy_widtype *)zalloc(sizeof(struct lazy_widtype));
+	if (!new) return;
+
+	new->init = init_func;
+	hashtab->add_atom(lazy_widtypes, ident, new);
+}
+
+
 static void register_widget_method(struct widtype *widtype, char *desc, void *methadr)
 {
 	struct method  *method;
@@ -505,8 +614,8 @@ static void register_widget_method(struct widtype *widtype, char *desc, void *me
 
 	method = (struct method *)zalloc(sizeof(struct method));
 	method->routine       = methadr;
-	method->name          = new_symbol(desc + tok_off[1], tok_len[1]);
-	method->ret_type      = new_symbol(desc + tok_off[0], tok_len[0]);
+	method->name          = atom->intern(desc + tok_off[1], tok_len[1]);
+	method->ret_type      = atom->intern(desc + tok_off[0], tok_len[0]);
 	method->ret_baseclass = get_baseclass(method->ret_type);
 	cl = (struct methodarg **)&method->args;
 
@@ -516,13 +625,13 @@ static void register_widget_method(struct widtype *widtype, char *desc, void *me
 			m_arg = new_methodarg();
 
 			/* read argument type */
-			m_arg->arg_type  = new_symbol(desc + tok_off[i], tok_len[i]);
+			m_arg->arg_type  = atom->intern(desc + tok_off[i], tok_len[i]);
 			m_arg->baseclass = get_baseclass(m_arg->arg_type);
 
 			if (++i >= num_tok) break;
 
 			/* read argument name */
-			m_arg->arg_name = new_symbol(desc + tok_off[i], tok_len[i]);
+			m_arg->arg_name = atom->intern(desc + tok_off[i], tok_len[i]);
 			if (++i >= num_tok) break;
 
 			/* check if a default value is specified */
@@ -544,7 +653,7 @@ static void register_widget_method(struct widtype *widtype, char *desc, void *me
 		}
 	}
 
-	hashtab->add_elem(widtype->methods, method->name, method);
+	hashtab->add_atom(widtype->methods, method->name, method);
 }
 
 
@@ -560,14 +669,18 @@ static void register_widget_attrib(struct widtype *widtype, char *desc,
 	attrib = (struct attrib *)zalloc(sizeof(struct attrib));
 	if (!attrib) return;
 
-	attrib->name      = new_symbol(desc + tok_off[1], tok_len[1]);
-	attrib->type      = new_symbol(desc + tok_off[0], tok_len[0]);
+	attrib->name      = atom->intern(desc + tok_off[1], tok_len[1]);
+	attrib->type      = atom->intern(desc + tok_off[0], tok_len[0]);
 	attrib->baseclass = get_baseclass(attrib->type);
 	attrib->get       = get;
 	attrib->set       = set;
 	attrib->update    = update;
 
-	hashtab->add_elem(widtype->attribs, attrib->name, attrib);
+	/* the types of all attributes must be known when they are registered */
+	if (attrib->baseclass == VAR_BASECLASS_UNDEFINED)
+		ERROR(printf("Script(register_widget_attrib): unknown type of attribute %s\n", attrib->name));
+
+	hashtab->add_atom(widtype->attribs, attrib->name, attrib);
 }
 
 
@@ -686,7 +799,9 @@ static int get_variable(INTERPRETER *ci, SCOPE *s, int tok,
 		if (!typename)
 			ERR(INVALID_VAR, "variable '%s' has invalid type", err_token(ci, tok));
 
-		*out_w_type = hashtab->get_elem(widtypes, typename, 255);
+		*out_w_type = hashtab->get_atom(widtypes, typename);
+		if (!*out_w_type)
+			ERR(INVALID_TYPE, "variable '%s' has unknown type", err_token(ci, tok));
 
 		/* we can skip two tokens (the variable name and the dot) */
 		return 2;
@@ -700,7 +815,7 @@ static int get_variable(INTERPRETER *ci, SCOPE *s, int tok,
 
 	/* return the scope */
 	*out_w = (WIDGET *)s;
-	*out_w_type = hashtab->get_elem(widtypes, "Scope", 255);
+	*out_w_type = hashtab->get_atom(widtypes, atom_scope);
 
 	/* keep current token */
 	return 0;
@@ -728,7 +843,8 @@ static int parse_assignment(INTERPRETER *ci, WIDGET *w, struct widtype *widtype,
 
 	/* determine attribute type */
 	CHECK(constraints_tag(ci, tok));
-	attrib = hashtab->get_elem(widtype->attribs, tag + 1, ci->tok_len[tok] - 1);
+	attrib = hashtab->get_atom(widtype->attribs,
+	                           atom->lookup(tag + 1, ci->tok_len[tok] - 1));
 
 	if (!attrib)
 		ERR(UNKNOWN_TAG, "'%s' is not a valid tag", err_token(ci, tok));
@@ -910,11 +1026,12 @@ static int exec_function(INTERPRETER *ci, WIDGET *w, struct widtype *w_type,
 
 	/* set optional parameters that are specified as tag value pairs */
 	for (; tok<ci->num_tok-1;) {
-		char *tag = ci->tokens[tok];
+		char *tag;
 
 		CHECK(constraints_tag(ci, tok));
+		tag = atom->lookup(ci->tokens[tok] + 1, ci->tok_len[tok] - 1);
 		for (o_arg = m_arg, i = num_args; o_arg; o_arg = o_arg->next, i++)
-			if (mtk_streq(tag+1, o_arg->arg_name, ci->tok_len[tok]-1))
+			if (tag && tag == o_arg->arg_name)
 				break;
 
 		if (!o_arg)
@@ -948,7 +1065,7 @@ static int exec_attrib(INTERPRETER *ci, WIDGET *w, struct attrib *attrib, int to
 	if (!attrib->get)
 		ERR(ATTR_R_PERM, "attribute '%s' is not readable", attrib->name);
 
-	if (mtk_streq(attrib->type, "float", 6)) {
+	if (attrib->baseclass == VAR_BASECLASS_FLOAT) {
 		float (*float_get)(WIDGET *w) = (float (*)(WIDGET *))attrib->get;
 		res.float_value = float_get(w);
 	} else {
@@ -958,6 +1075,92 @@ static int exec_attrib(INTERPRETER *ci, WIDGET *w, struct attrib *attrib, int to
 }
 
 
+/**
+ * Determine index of the method or attribute token of a command
+ *
+ * \return  token index or -1 if the command has no such token
+ */
+static int get_member_token(INTERPRETER *ci, int cmd_type)
+{
+	int tok;
+
+	if (cmd_type == CMD_TYPE_REQUEST) return ci->num_tok - 1;
+
+	for (tok = 0; tok < ci->num_tok; tok++)
+		if (ci->tokens[tok][0] == '(') return tok - 1;
+
+	return -1;
+}
+
+
+/**
+ * Return cache slot for the specified path of an application
+ */
+static struct path_cache_entry *path_cache_slot(u32 app_id, const char *path, int len)
+{
+	u32 hash = 0;
+	int i;
+
+	if (!path_cache[app_id])
+		path_cache[app_id] = zalloc(sizeof(struct path_cache_entry)*PATH_CACHE_SIZE);
+	if (!path_cache[app_id]) return NULL;
+
+	for (i = 0; i < len; i++) hash = hash*31 + path[i];
+	return &path_cache[app_id][hash % PATH_CACHE_SIZE];
+}
+
+
+/**
+ * Resolve the widget that is addressed by the first tokens of a command
+ *
+ * \param out_w       resolved widget
+ * \param out_w_type  type information of resolved widget
+ * \return            index of method/attribute token or negative error code
+ *
+ * Paths of the form 'a.b.c.member' are looked up in the path cache
+ * of the application first. Only if the path is not cached, the
+ * path is resolved scope by scope.
+ */
+static int resolve_variable(INTERPRETER *ci, u32 app_id, int cmd_type,
+                            WIDGET **out_w, struct widtype **out_w_type) {
+	struct path_cache_entry *pce = NULL;
+	int member = get_member_token(ci, cmd_type);
+	int path_len = 0, tok = 0, ret;
+	SCOPE *s;
+
+	/* the path ends with the dot in front of the member token */
+	if ((member >= 2) && (ci->tokens[member - 1][0] == '.')) {
+		path_len = ci->tok_off[member - 1] - ci->tok_off[0];
+		if (path_len <= PATH_CACHE_MAXLEN)
+			pce = path_cache_slot(app_id, ci->tokens[0], path_len);
+	}
+
+	if (pce && (pce->gen == path_cache_gen) && (pce->len == path_len)
+	 && !memcmp(pce->path, ci->tokens[0], path_len)) {
+		*out_w      = pce->w;
+		*out_w_type = pce->w_type;
+		return member;
+	}
+
+	/* resolve scope of the first command tokens */
+	tok += resolve_scope(ci, ci->scope, tok, &s);
+
+	/* determine widget and its type of the given variable symbol */
+	ret = get_variable(ci, s, tok, out_w, out_w_type);
+	if (ret < 0) return ret;
+	tok += ret;
+
+	if (pce && (tok == member)) {
+		pce->gen    = path_cache_gen;
+		pce->len    = path_len;
+		pce->w      = *out_w;
+		pce->w_type = *out_w_type;
+		memcpy(pce->path, ci->tokens[0], path_len);
+	}
+	return tok;
+}
+
+
 static int exec_command(u32 app_id, const char *cmd, char *dst, int dst_len)
 {
 	s32 i;
@@ -968,6 +1171,7 @@ static int exec_command(u32 app_id, const char *cmd, char *dst, int dst_len)
 	int ret, tok = 0;
 	void *res_value = NULL;
 	char *res_type  = NULL;
+	char *member;
 	int cmd_type;
 	SCOPE *s;
 
@@ -990,14 +1194,12 @@ static int exec_command(u32 app_id, const char *cmd, char *dst, int dst_len)
 
 	cmd_type = get_command_type(ci, tok);
 
-	/* resolve scope of the first command tokens */
-	ret = resolve_scope(ci, ci->scope, tok, &s);
-	if (ret < 0) return ret;
-	tok += ret;
-
 	if (cmd_type == CMD_TYPE_ASSIGNMENT) {
 		SCOPE *ns;
 
+		/* resolve scope of the first command tokens */
+		tok += resolve_scope(ci, ci->scope, tok, &s);
+
 		if ((tok + 1 < ci->num_tok)
 		 && (ns = s->scope->get_subscope(s, ci->tokens[tok], ci->tok_len[tok]))
 		 && (ci->tokens[tok + 1][0] == '.')) {
@@ -1008,10 +1210,10 @@ static int exec_command(u32 app_id, const char *cmd, char *dst, int dst_len)
 		if (ci->num_tok < tok + 4)
 			ERR(UNCOMPLETE, "unexpected end of command");
 
-		if (!mtk_streq(ci->tokens[tok + 2], "new", ci->tok_len[tok + 2]))
+		if (token_atom(ci, tok + 2) != atom_new)
 			ERR(ILLEGAL_CMD, "unknown keyword '%s'", err_token(ci, tok + 2));
 
-		w_type = hashtab->get_elem(widtypes, ci->tokens[tok + 3], ci->tok_len[tok + 3]);
+		w_type = get_widtype(token_atom(ci, tok + 3));
 		if (!w_type)
 			ERR(UNKNOWN_VAR, "widget type '%s' does not exist", err_token(ci, 3));
 
@@ -1038,7 +1240,7 @@ static int exec_command(u32 app_id, const char *cmd, char *dst, int dst_len)
 
 		/* assign method result to variable */
 		if (res_type) {
-			if (mtk_streq(res_type, "Widget", 7)) {
+			if (res_type == atom_widget) {
 				res_type = ((WIDGET *)res_value)->gen->get_type(res_value);
 			}
 			s->scope->set_var(s, res_type, ci->tokens[tok], ci->tok_len[tok], res_value);
@@ -1051,22 +1253,24 @@ static int exec_command(u32 app_id, const char *cmd, char *dst, int dst_len)
 		int res;
 
 		/* determine widget and its type of the given variable symbol */
-		res = get_variable(ci, s, tok, &w, &w_type);
+		res = resolve_variable(ci, app_id, cmd_type, &w, &w_type);
 
 		if (res < 0)
 			ERR(UNKNOWN_VAR, "unknown variable '%s'", err_token(ci, tok));
 
-		tok += res;
+		tok = res;
 		if (tok >= ci->num_tok) ERR(UNCOMPLETE, "unexpected end of command");
 
+		member = token_atom(ci, tok);
+
 		if (cmd_type == CMD_TYPE_METHOD) {
 
 			/* get information structure of the method to call */
-			meth = hashtab->get_elem(w_type->methods, ci->tokens[tok], ci->tok_len[tok]);
+			meth = hashtab->get_atom(w_type->methods, member);
 
 			if (meth) {
 				return exec_function(ci, w, w_type, meth, tok + 1);
-			} else if (mtk_streq(ci->tokens[tok], "set", ci->tok_len[tok])) {
+			} else if (member == atom_set) {
 				return exec_set(ci, w, w_type, tok + 1);
 			}
 		}
@@ -1074,7 +1278,7 @@ static int exec_command(u32 app_id, const char *cmd, char *dst, int dst_len)
 		if (cmd_type == CMD_TYPE_REQUEST) {
 
 			/* get widget attribute information structure */
-			attrib = hashtab->get_elem(w_type->attribs, ci->tokens[tok], ci->tok_len[tok]);
+			attrib = hashtab->get_atom(w_type->attribs, member);
 
 			if (!attrib)
 				ERR(NO_SUCH_MEMBER, "attribute '%s' does not exist", err_token(ci, tok));
@@ -1090,15 +1294,50 @@ static int exec_command(u32 app_id, const char *cmd, char *dst, int dst_len)
 }
 
 
+/**
+ * Invalidate all cached path resolutions
+ */
+static void invalidate_paths(void)
+{
+	path_cache_gen++;
+}
+
+
+/**
+ * Look up widget by its variable path, e.g., 'scope.button'
+ */
+static WIDGET *lookup_widget(u32 app_id, const char *path)
+{
+	SCOPE *s = appman->get_rootscope(app_id);
+	int i, tok;
+
+	if (!s || !path) return NULL;
+
+	ci->num_tok = tokenizer->parse(path, MAX_TOKENS, &ci->tok_off[0], &ci->tok_len[0]);
+	for (i = 0; i < ci->num_tok; i++)
+		ci->tokens[i] = (char *)(path + ci->tok_off[i]);
+
+	tok = resolve_scope(ci, s, 0, &s);
+
+	/* the path must end with the variable */
+	if (tok + 1 != ci->num_tok) return NULL;
+
+	return s->scope->get_var(s, ci->tokens[tok], ci->tok_len[tok]);
+}
+
+
 /**************************************
  ** Service structure of this module **
  **************************************/
 
 static struct script_services services = {
 	register_widget_type,
+	register_lazy_widget_type,
 	register_widget_method,
 	register_widget_attrib,
 	exec_command,
+	invalidate_paths,
+	lookup_widget,
 };
 
 
@@ -1108,12 +1347,26 @@ static struct script_services services = {
 
 int init_script(struct mtk_services *d)
 {
+	mtk_services = d;
+
 	hashtab     = d->get_module("HashTable 1.0");
 	appman      = d->get_module("ApplicationManager 1.0");
 	tokenizer   = d->get_module("Tokenizer 1.0");
+	atom        = d->get_module("Atom 1.0");
+	slab        = d->get_module("Slab 1.0");
+
+	atom_int     = atom->intern("int",     255);
+	atom_float   = atom->intern("float",   255);
+	atom_string  = atom->intern("string",  255);
+	atom_boolean = atom->intern("boolean", 255);
+	atom_widget  = atom->intern("Widget",  255);
+	atom_scope   = atom->intern("Scope",   255);
+	atom_new     = atom->intern("new",     255);
+	atom_set     = atom->intern("set",     255);
 
 	INFO(printf("creating hashtab:\n");)
 	widtypes = hashtab->create(WIDTYPE_HASHTAB_SIZE, WIDTYPE_HASH_CHARS);
+	lazy_widtypes = hashtab->create(WIDTYPE_HASHTAB_SIZE, WIDTYPE_HASH_CHARS);
 	INFO(printf("hashtab created\n");)
 
 	d->register_module("Script 1.0",&services);
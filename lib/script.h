@@ -14,11 +14,35 @@
 #define _MTK_SCRIPT_H_
 
 struct widtype;
+struct widget;
 struct script_services {
 	void *(*reg_widget_type)   (char *widtype_name, void *(*create_func)(void));
+
+	/**
+	 * Register widget type whose module is initialized on demand
+	 *
+	 * The init function is called when the first widget of the type
+	 * is created. It must register the widget type via reg_widget_type.
+	 */
+	void  (*reg_lazy_widget_type) (char *widtype_name, int (*init_func)(struct mtk_services *));
+
 	void  (*reg_widget_method) (struct widtype *, char *desc, void *methadr);
 	void  (*reg_widget_attrib) (struct widtype *, char *desc, void *get, void *set, void *update);
 	int   (*exec_command)      (u32 app_id, const char *cmd, char *dst, int dst_len);
+
+	/**
+	 * Drop all cached variable path resolutions
+	 *
+	 * Must be called whenever the content of a scope changes.
+	 */
+	void  (*invalidate_paths)  (void);
+
+	/**
+	 * Look up widget by its variable path within an application
+	 *
+	 * \return  widget or NULL if the path does not refer to a widget
+	 */
+	struct widget *(*lookup_widget) (u32 app_id, const char *path);
 };
 
 
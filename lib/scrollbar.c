@@ -25,12 +25,11 @@ struct scrollbar;
 #include "scrollbar.h"
 #include "userstate.h"
 #include "script.h"
-#include "messenger.h"
+#include "mtklib.h"
 
 static struct widman_services    *widman;
 static struct button_services    *but;
 static struct script_services    *script;
-static struct messenger_services *msg;
 static struct userstate_services *userstate;
 
 #define SCROLLBAR_NUM_ELEM 4  /* number of scrollbar element widgets */
@@ -199,18 +198,16 @@ static void scrollstep_leave_callback(WIDGET *cw, int dx, int dy)
  ** General widget methods **
  ****************************/
 
-static int scrollbar_draw(SCROLLBAR *w, struct gfx_ds *ds, int x, int y, WIDGET *origin)
+static int scrollbar_draw(SCROLLBAR *w, struct gfx_ds *ds, int x, int y)
 {
 	int ret = 0, i;
 
-	if (origin == w) return 1;
-
 	/* draw elements of the scrollbar */
 	for (i = 0; i < SCROLLBAR_NUM_ELEM; i++) {
 
 		/* get element widget, begin with slider background */
 		WIDGET *cw = w->sd->elem[(i + SB_ELEM_SLIDER_BG) % SCROLLBAR_NUM_ELEM];
-		ret |= cw->gen->draw(cw, ds, w->wd->x + x, w->wd->y + y, origin);
+		ret |= cw->gen->draw(cw, ds, w->wd->x + x, w->wd->y + y);
 	}
 	return ret;
 }
@@ -371,11 +368,7 @@ static void scrollbar_set_view_offset (SCROLLBAR *s, s32 new_view_offset)
 	s->sd->view_offset = new_view_offset;
 
 	/* send change event to the application */
-	{
-		char *message = s->gen->get_bind_msg(s, "change");
-		int   app_id  = s->gen->get_app_id(s);
-		if (message) msg->send_action_event(app_id, "change", message);
-	}
+	s->gen->send_action(s, MTK_BIND_CHANGE, "change");
 	s->wd->update |= WID_UPDATE_REFRESH;
 }
 static u32 scrollbar_get_view_offset (SCROLLBAR *s)
@@ -577,7 +570,6 @@ static void build_script_lang(void)
 int init_scrollbar(struct mtk_services *d)
 {
 	but       = d->get_module("Button 1.0");
-	msg       = d->get_module("Messenger 1.0");
 	script    = d->get_module("Script 1.0");
 	widman    = d->get_module("WidgetManager 1.0");
 	userstate = d->get_module("UserState 1.0");
@@ -62,12 +62,9 @@ static inline void draw_pressed_frame(GFX_CONTAINER *d, s32 x, s32 y, s32 w, s32
 	gfx->draw_vline(d, x + w - 2, y + 1, h - 2, WHITE_MIXED);
 }
 
-static int sep_draw(SEPARATOR *s, struct gfx_ds *ds, int x, int y, WIDGET *origin)
+static int sep_draw(SEPARATOR *s, struct gfx_ds *ds, int x, int y)
 {
 	int w, h;
-	
-	if (origin == s) return 1;
-	if (origin) return 0;
 
 	x += s->wd->x;
 	y += s->wd->y;
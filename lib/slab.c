@@ -0,0 +1,355 @@
+/*
+ * \brief   MTK slab allocator module
+ *
+ * Small objects that are created and destroyed in large numbers,
+ * e.g., widgets, hash table entries and bindings, are allocated
+ * from pools of equally-sized objects. A pool requests chunks of
+ * several objects from the system heap and keeps freed objects in
+ * a free list. This way, rebuilding a user interface reuses the
+ * same memory instead of fragmenting the heap.
+ *
+ * Objects allocated on behalf of an application are kept in chunks
+ * of an arena that belongs to the application. When the application
+ * goes away, the chunks of its arena are released at once.
+ *
+ * Each object is preceded by a header that refers to its chunk.
+ * Hence, objects can be freed without knowing their pool. Strings
+ * that are too long for the string pools are allocated from the
+ * heap with an empty header.
+ */
+
+/*
+ * Copyright (C) 2010 Sebastien Bourdeauducq
+ *
+ * This file is part of the MTK package, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mtkstd.h"
+#include "slab.h"
+
+#define CHUNK_SIZE   2048   /* preferred size of a chunk in bytes */
+#define MIN_OBJS     8      /* minimal number of objects per chunk */
+#define ALIGN(x)     (((x) + 7) & ~7)
+#define ORPHAN       -1     /* arena of chunks left by a released arena  */
+
+struct chunk;
+
+union slot {
+	struct chunk *chunk;    /* chunk of the object, NULL for heap blocks */
+	double        align;    /* keep objects 8-byte aligned               */
+};
+
+struct chunk {
+	struct slab  *pool;
+	struct chunk *next;
+	int           used;     /* number of allocated objects */
+	int           arena;    /* owning arena or ORPHAN      */
+};
+
+#define CHUNK_HDR ALIGN(sizeof(struct chunk))
+
+struct slab {
+	char         *name;
+	int           obj_size;
+	int           slot_size;  /* object size including header */
+	int           per_chunk;  /* number of objects per chunk  */
+	struct chunk *chunks;
+	union slot   *free_list[SLAB_ARENAS];  /* link is stored in the object */
+	int           used, avail, num_chunks;
+	struct slab  *next;
+};
+
+/* size classes of the string pools */
+static const int str_sizes[] = { 16, 32, 64, 128 };
+#define NUM_STR_POOLS (sizeof(str_sizes)/sizeof(int))
+
+static struct slab *pools;
+static struct slab *str_pools[NUM_STR_POOLS];
+static int          curr_arena;   /* arena used for allocations */
+
+int init_slab(struct mtk_services *d);
+
+
+/********************************
+ ** Functions for internal use **
+ ********************************/
+
+static inline union slot **link_of(union slot *s)
+{
+	return (union slot **)(s + 1);
+}
+
+
+static inline union slot *slot_at(struct chunk *c, int i)
+{
+	return (union slot *)((char *)c + CHUNK_HDR + i*c->pool->slot_size);
+}
+
+
+/**
+ * Request new chunk from the heap and put its objects into the free list
+ */
+static int add_chunk(struct slab *p, int arena)
+{
+	struct chunk *c = malloc(CHUNK_HDR + p->per_chunk*p->slot_size);
+	int i;
+
+	if (!c) return -1;
+
+	c->pool  = p;
+	c->used  = 0;
+	c->arena = arena;
+	c->next  = p->chunks;
+	p->chunks = c;
+	p->num_chunks++;
+
+	for (i = p->per_chunk - 1; i >= 0; i--) {
+		union slot *s = slot_at(c, i);
+		s->chunk     = c;
+		*link_of(s)  = p->free_list[arena];
+		p->free_list[arena] = s;
+	}
+	p->avail += p->per_chunk;
+	return 0;
+}
+
+
+/**
+ * Unlink chunk from its pool and give it back to the heap
+ */
+static void drop_chunk(struct chunk *c)
+{
+	struct slab *p = c->pool;
+	struct chunk **l;
+
+	for (l = &p->chunks; *l != c; l = &(*l)->next);
+	*l = c->next;
+	p->num_chunks--;
+	free(c);
+}
+
+
+/**
+ * Free chunks of an arena that hold no allocated objects
+ *
+ * If 'release' is set, the remaining chunks of the arena become
+ * orphans. Their free objects are not reused and each orphan is
+ * dropped as soon as its last object is freed.
+ */
+static int free_chunks(struct slab *p, int arena, int release)
+{
+	struct chunk **c, *empty;
+	union slot **s;
+	int released = 0;
+
+	/* remove objects of chunks to drop from the free list */
+	for (s = &p->free_list[arena]; *s; )
+		if (release || (*s)->chunk->used == 0) *s = *link_of(*s);
+		else s = link_of(*s);
+
+	for (c = &p->chunks; *c; ) {
+		if ((*c)->arena != arena || ((*c)->used && !release)) {
+			c = &(*c)->next;
+			continue;
+		}
+		if ((*c)->used) {
+			p->avail -= p->per_chunk - (*c)->used;
+			(*c)->arena = ORPHAN;
+			c = &(*c)->next;
+			continue;
+		}
+		empty = *c;
+		*c = empty->next;
+		p->num_chunks--;
+		p->avail -= p->per_chunk;
+		released += CHUNK_HDR + p->per_chunk*p->slot_size;
+		free(empty);
+	}
+	return released;
+}
+
+
+/***********************
+ ** Service functions **
+ ***********************/
+
+static SLAB *get_pool(char *name, int obj_size)
+{
+	struct slab *p;
+
+	for (p = pools; p; p = p->next)
+		if (p->obj_size == obj_size && !strcmp(p->name, name)) return p;
+
+	if (!(p = zalloc(sizeof(struct slab)))) return NULL;
+
+	p->name      = name;
+	p->obj_size  = obj_size;
+	p->slot_size = sizeof(union slot) + ALIGN(MAX(obj_size, sizeof(void *)));
+	p->per_chunk = MAX(MIN_OBJS, (CHUNK_SIZE - CHUNK_HDR)/p->slot_size);
+	p->next      = pools;
+	pools        = p;
+	return p;
+}
+
+
+static void *alloc(SLAB *p)
+{
+	union slot *s;
+
+	if (!p || (!p->free_list[curr_arena] && add_chunk(p, curr_arena))) {
+		ERROR(printf("Slab(alloc): out of memory\n"));
+		return NULL;
+	}
+
+	s = p->free_list[curr_arena];
+	p->free_list[curr_arena] = *link_of(s);
+	s->chunk->used++;
+	p->used++;
+	p->avail--;
+
+	memset(s + 1, 0, p->obj_size);
+	return s + 1;
+}
+
+
+static void slab_free(void *obj)
+{
+	union slot *s = (union slot *)obj - 1;
+	struct slab *p;
+
+	if (!obj) return;
+
+	/* block was allocated from the heap */
+	if (!s->chunk) {
+		free(s);
+		return;
+	}
+
+	p = s->chunk->pool;
+	s->chunk->used--;
+	p->used--;
+
+	if (s->chunk->arena == ORPHAN) {
+		if (s->chunk->used == 0) drop_chunk(s->chunk);
+		return;
+	}
+	p->avail++;
+	*link_of(s) = p->free_list[s->chunk->arena];
+	p->free_list[s->chunk->arena] = s;
+}
+
+
+static char *slab_strdup(const char *str)
+{
+	int i, len;
+	union slot *s;
+	char *dst;
+
+	if (!str) return NULL;
+	len = strlen(str) + 1;
+
+	for (i = 0; i < NUM_STR_POOLS; i++)
+		if (len <= str_sizes[i]) break;
+
+	if (i < NUM_STR_POOLS) {
+		if (!(dst = alloc(str_pools[i]))) return NULL;
+	} else {
+		if (!(s = malloc(sizeof(union slot) + len))) return NULL;
+		s->chunk = NULL;
+		dst = (char *)(s + 1);
+	}
+	memcpy(dst, str, len);
+	return dst;
+}
+
+
+static int shrink(void)
+{
+	struct slab *p;
+	int i, released = 0;
+
+	for (p = pools; p; p = p->next)
+		for (i = 0; i < SLAB_ARENAS; i++)
+			released += free_chunks(p, i, 0);
+	return released;
+}
+
+
+static SLAB *next(SLAB *prev)
+{
+	return prev ? prev->next : pools;
+}
+
+
+static void get_stats(SLAB *p, char **name, int *obj_size,
+                      int *used, int *avail, int *chunks)
+{
+	if (name)     *name     = p ? p->name       : NULL;
+	if (obj_size) *obj_size = p ? p->obj_size   : 0;
+	if (used)     *used     = p ? p->used       : 0;
+	if (avail)    *avail    = p ? p->avail      : 0;
+	if (chunks)   *chunks   = p ? p->num_chunks : 0;
+}
+
+
+static int set_arena(int arena)
+{
+	int prev = curr_arena;
+
+	if (arena >= 0 && arena < SLAB_ARENAS) curr_arena = arena;
+	return prev;
+}
+
+
+static int release_arena(int arena)
+{
+	struct slab *p;
+	int released = 0;
+
+	if (arena <= 0 || arena >= SLAB_ARENAS) return 0;
+
+	for (p = pools; p; p = p->next)
+		released += free_chunks(p, arena, 1);
+	if (curr_arena == arena) curr_arena = 0;
+	return released;
+}
+
+
+/**************************************
+ ** Service structure of this module **
+ **************************************/
+
+static struct slab_services services = {
+	get_pool,
+	alloc,
+	slab_free,
+	slab_strdup,
+	shrink,
+	next,
+	get_stats,
+	set_arena,
+	release_arena,
+};
+
+
+/************************
+ ** Module entry point **
+ ************************/
+
+int init_slab(struct mtk_services *d)
+{
+	static char *str_names[NUM_STR_POOLS] = {
+		"string 16", "string 32", "string 64", "string 128"
+	};
+	int i;
+
+	for (i = 0; i < NUM_STR_POOLS; i++)
+		str_pools[i] = get_pool(str_names[i], str_sizes[i]);
+
+	d->register_module("Slab 1.0", &services);
+	return 1;
+}
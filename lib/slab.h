@@ -0,0 +1,94 @@
+/*
+ * \brief   Interface of the MTK slab allocator module
+ */
+
+/*
+ * Copyright (C) 2010 Sebastien Bourdeauducq
+ *
+ * This file is part of the MTK package, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+#ifndef _MTK_SLAB_H_
+#define _MTK_SLAB_H_
+
+#define SLAB struct slab
+struct slab;
+
+#define SLAB_ARENAS 64   /* number of arenas, arena 0 is shared */
+
+struct slab_services {
+
+	/**
+	 * Request pool for objects of the specified size
+	 *
+	 * Pools are identified by their name and object size. If no
+	 * such pool exists, it is created. The name is referenced and
+	 * must stay valid.
+	 */
+	SLAB *(*get_pool)  (char *name, int obj_size);
+
+	/**
+	 * Allocate zeroed object from pool
+	 */
+	void *(*alloc)     (SLAB *pool);
+
+	/**
+	 * Return object to its pool
+	 *
+	 * This function frees objects of all pools as well as strings
+	 * returned by 'strdup'. NULL is ignored.
+	 */
+	void  (*free)      (void *obj);
+
+	/**
+	 * Duplicate string, short strings are kept in size-class pools
+	 */
+	char *(*strdup)    (const char *s);
+
+	/**
+	 * Release chunks that hold no allocated objects to the system heap
+	 *
+	 * \return  number of released bytes
+	 */
+	int   (*shrink)    (void);
+
+	/**
+	 * Iterate over all pools, pass NULL to get the first one
+	 */
+	SLAB *(*next)      (SLAB *prev);
+
+	/**
+	 * Request occupancy of a pool
+	 *
+	 * \param used    number of allocated objects
+	 * \param avail   number of free objects in the chunks of the pool
+	 * \param chunks  number of chunks requested from the system heap
+	 */
+	void  (*get_stats) (SLAB *pool, char **name, int *obj_size,
+	                    int *used, int *avail, int *chunks);
+
+	/**
+	 * Select arena for subsequent allocations
+	 *
+	 * Each arena uses chunks of its own. Hence, the objects of an
+	 * arena can be given back to the heap together.
+	 *
+	 * \return  previously selected arena
+	 */
+	int   (*set_arena)     (int arena);
+
+	/**
+	 * Release chunks of an arena to the heap
+	 *
+	 * Objects of the arena that are still referenced elsewhere stay
+	 * valid. Their chunks are given back as soon as these objects
+	 * are freed.
+	 *
+	 * \return  number of released bytes
+	 */
+	int   (*release_arena) (int arena);
+};
+
+
+#endif /* _MTK_SLAB_H_ */
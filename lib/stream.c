@@ -0,0 +1,216 @@
+/*
+ * \brief   MTK frame stream module
+ *
+ * The producer and the user interface share three buffers. At
+ * any time, one buffer is being filled by the producer, one holds
+ * the latest published frame and one is being displayed. The
+ * published and the displayed buffer are announced via words that
+ * are only written by one side each, so no locking is needed.
+ *
+ * The published word holds the buffer index in its lowest two bits
+ * and the frame sequence number above. Before the user interface
+ * displays a published buffer, it claims the buffer and checks that
+ * the producer did not publish another frame meanwhile. The producer
+ * only fills buffers that are neither published nor claimed.
+ *
+ * Both sides store their word and then load the word of the other
+ * side. Full memory barriers between the store and the load keep
+ * the CPU from reordering them, so the handshake also holds when
+ * the producer runs on another processor.
+ */
+
+/*
+ * Copyright (C) 2010 Sebastien Bourdeauducq
+ *
+ * This file is part of the MTK package, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+#include <stdlib.h>
+#include "mtkstd.h"
+#include "stream.h"
+
+#define NO_BUF 3   /* buffer index that refers to no buffer */
+
+struct stream {
+	void *buf[3];
+
+	/* written by the producer only */
+	volatile u32 published;   /* (sequence number << 2) | buffer index */
+	u32 acquired;             /* buffer filled by the producer         */
+	u32 produced;
+
+	/* written by the user interface only */
+	volatile u32 claimed;     /* buffer being displayed                */
+	u32 shown_seq;            /* sequence number of displayed frame    */
+	u32 displayed, dropped;
+
+	int  (*notify)(void *arg);
+	void  *arg;
+	struct stream *next;      /* next bound stream */
+};
+
+static struct stream *bound;   /* list of streams that are polled */
+
+int init_stream(struct mtk_services *d);
+
+
+/***********************
+ ** Service functions **
+ ***********************/
+
+static STREAM *create(void *buf0, void *buf1, void *buf2)
+{
+	STREAM *s;
+
+	if (!buf0 || !buf1 || !buf2) return NULL;
+	if (!(s = zalloc(sizeof(STREAM)))) return NULL;
+
+	s->buf[0]    = buf0;
+	s->buf[1]    = buf1;
+	s->buf[2]    = buf2;
+	s->published = NO_BUF;
+	s->acquired  = NO_BUF;
+	s->claimed   = NO_BUF;
+	return s;
+}
+
+
+static void bind(STREAM *s, int (*notify)(void *arg), void *arg);
+
+static void destroy(STREAM *s)
+{
+	if (!s) return;
+	bind(s, NULL, NULL);
+	free(s);
+}
+
+
+static void *acquire(STREAM *s)
+{
+	u32 pub, i;
+
+	if (s->acquired == NO_BUF) {
+
+		/* order the last publish before reading the claimed buffer */
+		__sync_synchronize();
+		pub = s->published & 3;
+		for (i = 0; i == pub || i == s->claimed; i++);
+		s->acquired = i;
+	}
+	return s->buf[s->acquired];
+}
+
+
+static void publish(STREAM *s)
+{
+	if (s->acquired == NO_BUF) return;
+
+	s->produced++;
+
+	/* make the frame visible before the buffer gets published */
+	__sync_synchronize();
+	s->published = (s->produced << 2) | s->acquired;
+	s->acquired  = NO_BUF;
+}
+
+
+static void *latest(STREAM *s)
+{
+	u32 pub, seq;
+
+	/* claim published buffer, retry if the producer published meanwhile */
+	do {
+		pub = s->published;
+		if ((pub & 3) == NO_BUF) return NULL;
+		s->claimed = pub & 3;
+
+		/* order the claim before checking the published buffer again */
+		__sync_synchronize();
+	} while (s->published != pub);
+
+	seq = pub >> 2;
+	if (seq != s->shown_seq) {
+		s->dropped  += (seq - s->shown_seq - 1) & (~0U >> 2);
+		s->displayed++;
+		s->shown_seq = seq;
+	}
+	return s->buf[pub & 3];
+}
+
+
+static void bind(STREAM *s, int (*notify)(void *arg), void *arg)
+{
+	STREAM **l;
+
+	if (!s) return;
+
+	/* remove stream from list of bound streams */
+	for (l = &bound; *l && *l != s; l = &(*l)->next);
+	if (*l) *l = s->next;
+
+	s->notify = notify;
+	s->arg    = arg;
+	if (!notify) return;
+
+	s->next = bound;
+	bound   = s;
+}
+
+
+static int poll(void)
+{
+	STREAM *s;
+	int pending = 0;
+
+	for (s = bound; s; s = s->next)
+		if ((s->published >> 2) != s->shown_seq && !s->notify(s->arg))
+			pending = 1;
+	return pending;
+}
+
+
+static int pending(void)
+{
+	STREAM *s;
+
+	for (s = bound; s; s = s->next)
+		if ((s->published >> 2) != s->shown_seq) return 1;
+	return 0;
+}
+
+
+static void get_stats(STREAM *s, u32 *produced, u32 *displayed, u32 *dropped)
+{
+	if (produced)  *produced  = s ? s->produced  : 0;
+	if (displayed) *displayed = s ? s->displayed : 0;
+	if (dropped)   *dropped   = s ? s->dropped   : 0;
+}
+
+
+/**************************************
+ ** Service structure of this module **
+ **************************************/
+
+static struct stream_services services = {
+	create,
+	destroy,
+	acquire,
+	publish,
+	latest,
+	bind,
+	poll,
+	pending,
+	get_stats,
+};
+
+
+/************************
+ ** Module entry point **
+ ************************/
+
+int init_stream(struct mtk_services *d)
+{
+	d->register_module("Stream 1.0", &services);
+	return 1;
+}
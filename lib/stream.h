@@ -0,0 +1,73 @@
+/*
+ * \brief   Interface of the MTK frame stream module
+ */
+
+/*
+ * Copyright (C) 2010 Sebastien Bourdeauducq
+ *
+ * This file is part of the MTK package, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+#ifndef _MTK_STREAM_H_
+#define _MTK_STREAM_H_
+
+/*
+ * A stream passes frames from a producer to the user interface via a
+ * ring of three buffers. The producer may run in another thread. It
+ * fills the buffer returned by 'acquire' and hands it over by 'publish'.
+ * Both functions do not lock and do not call other MTK functions.
+ * All other functions must be called by the thread that runs MTK.
+ */
+
+#define STREAM struct stream
+struct stream;
+
+struct stream_services {
+	STREAM *(*create)    (void *buf0, void *buf1, void *buf2);
+	void    (*destroy)   (STREAM *s);
+
+	/**
+	 * Request buffer to fill with the next frame (producer side)
+	 */
+	void   *(*acquire)   (STREAM *s);
+
+	/**
+	 * Publish the acquired buffer (producer side)
+	 */
+	void    (*publish)   (STREAM *s);
+
+	/**
+	 * Switch to the latest published frame
+	 *
+	 * \return  buffer of the latest frame or NULL if no frame
+	 *          was published yet
+	 */
+	void   *(*latest)    (STREAM *s);
+
+	/**
+	 * Register function that is called by 'poll' for new frames
+	 *
+	 * The notify function returns 1 if it took the new frame via
+	 * 'latest' or 0 if it should be notified again at the next poll.
+	 * Passing NULL unbinds the stream.
+	 */
+	void    (*bind)      (STREAM *s, int (*notify)(void *arg), void *arg);
+
+	/**
+	 * Notify bound streams that received new frames
+	 *
+	 * \return  1 if there are frames that were not taken yet
+	 */
+	int     (*poll)      (void);
+
+	/**
+	 * Check if bound streams received frames that were not taken yet
+	 */
+	int     (*pending)   (void);
+
+	void    (*get_stats) (STREAM *s, u32 *produced, u32 *displayed, u32 *dropped);
+};
+
+
+#endif /* _MTK_STREAM_H_ */
@@ -0,0 +1,713 @@
+/*
+ * \brief   MTK Table widget module
+ *
+ * The Table widget displays rows of text cells without creating
+ * child widgets. The cell text is either kept in a column store
+ * or requested from a callback when the cell gets drawn. Columns
+ * have fixed widths and all rows have the height of the font.
+ * Hence, only the visible cells are visited when drawing and hit
+ * tests do not depend on the number of rows.
+ */
+
+/*
+ * Copyright (C) 2010 Sebastien Bourdeauducq
+ *
+ * This file is part of the MTK package, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+struct table;
+#define WIDGET struct table
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "mtkstd.h"
+#include "gfx.h"
+#include "widget_data.h"
+#include "widget_help.h"
+#include "table.h"
+#include "fontman.h"
+#include "script.h"
+#include "widman.h"
+#include "userstate.h"
+#include "mtkeycodes.h"
+#include "mtklib.h"
+#include "redraw.h"
+
+static struct widman_services    *widman;
+static struct gfx_services       *gfx;
+static struct fontman_services   *font;
+static struct script_services    *script;
+static struct userstate_services *userstate;
+static struct redraw_services    *redraw;
+
+#define TABLE_COL_W     80    /* default column width             */
+#define TABLE_CELL_MAX  256   /* max length of cell text          */
+#define TABLE_PAD       2     /* distance of text to column border */
+
+#define COLUMN_TEXT 0         /* column store holds strings       */
+#define COLUMN_INT  1         /* column store holds integers      */
+
+struct table_column {
+	s32   x;              /* position relative to first column */
+	s32   width;
+	char *title;          /* header text or NULL               */
+	int   type;           /* type of column store              */
+	void *store;          /* cell values or NULL               */
+	s32   store_size;     /* number of rows held by store      */
+};
+
+struct table_data {
+	struct table_column *cols;
+	s32       num_cols;
+	s32       num_rows;
+	s32       font_id;
+	s32       ch;                      /* row height               */
+	s32       hh;                      /* header height or 0       */
+	s32       sel;                     /* selected row             */
+	s32       sel_col;                 /* column of last click     */
+	table_source_func source;          /* cell text callback       */
+	void     *source_arg;
+	char      cellbuf[TABLE_CELL_MAX]; /* text of current cell     */
+};
+
+int init_table(struct mtk_services *d);
+
+#define BLACK_SOLID GFX_RGBA(0, 0, 0, 255)
+#define BLACK_MIXED GFX_RGBA(0, 0, 0, 127)
+
+
+/********************************
+ ** Functions for internal use **
+ ********************************/
+
+/**
+ * Calculate column positions and header height
+ */
+static void update_columns(TABLE *t)
+{
+	s32 i, x = 0;
+
+	t->td->hh = 0;
+	for (i = 0; i < t->td->num_cols; i++) {
+		t->td->cols[i].x = x;
+		x += t->td->cols[i].width;
+		if (t->td->cols[i].title) t->td->hh = t->td->ch + 2;
+	}
+}
+
+
+static s32 total_width(TABLE *t)
+{
+	struct table_column *last;
+
+	if (!t->td->num_cols) return 0;
+	last = &t->td->cols[t->td->num_cols - 1];
+	return last->x + last->width;
+}
+
+
+/**
+ * Find column at the specified position relative to the first column
+ */
+static s32 find_column(TABLE *t, s32 x)
+{
+	s32 lo = 0, hi = t->td->num_cols - 1, mid;
+
+	while (lo < hi) {
+		mid = (lo + hi + 1) >> 1;
+		if (t->td->cols[mid].x <= x) lo = mid;
+		else hi = mid - 1;
+	}
+	return lo;
+}
+
+
+static void free_store(TABLE *t, struct table_column *c)
+{
+	s32 i;
+
+	if (c->store && (c->type == COLUMN_TEXT))
+		for (i = 0; i < c->store_size; i++)
+			if (((char **)c->store)[i]) free(((char **)c->store)[i]);
+	if (c->store) free(c->store);
+	c->store      = NULL;
+	c->store_size = 0;
+}
+
+
+/**
+ * Make sure that the store of a column can hold the specified row
+ */
+static int reserve_store(TABLE *t, struct table_column *c, s32 row)
+{
+	s32 new_size = c->store_size ? c->store_size : 16;
+	s32 elem = (c->type == COLUMN_TEXT) ? sizeof(char *) : sizeof(s32);
+	void *new;
+
+	if (row < c->store_size) return 0;
+	while (new_size <= row) new_size *= 2;
+	new_size = MIN(new_size, t->td->num_rows);
+
+	if (!(new = realloc(c->store, new_size*elem))) {
+		ERROR(printf("Table(reserve_store): out of memory\n"));
+		return -1;
+	}
+	memset((char *)new + c->store_size*elem, 0, (new_size - c->store_size)*elem);
+	c->store      = new;
+	c->store_size = new_size;
+	return 0;
+}
+
+
+/**
+ * Request text of a cell
+ *
+ * The returned string is valid until the next call.
+ */
+static char *cell_text(TABLE *t, s32 row, s32 col)
+{
+	struct table_column *c = &t->td->cols[col];
+	char *s;
+
+	if (t->td->source) {
+		t->td->cellbuf[0] = 0;
+		t->td->source(row, col, t->td->cellbuf, TABLE_CELL_MAX, t->td->source_arg);
+		t->td->cellbuf[TABLE_CELL_MAX - 1] = 0;
+		return t->td->cellbuf;
+	}
+
+	if (row >= c->store_size) return "";
+	if (c->type == COLUMN_INT) {
+		snprintf(t->td->cellbuf, TABLE_CELL_MAX, "%d", (int)((s32 *)c->store)[row]);
+		return t->td->cellbuf;
+	}
+	s = ((char **)c->store)[row];
+	return s ? s : "";
+}
+
+
+/**
+ * Queue redraw of one row
+ */
+static void redraw_row(TABLE *t, s32 row)
+{
+	s32 y1 = 2 + 1 + t->td->hh + row*t->td->ch;
+	s32 y2 = y1 + t->td->ch - 1;
+
+	if (row < 0) return;
+	y1 = MAX(y1, 0);
+	y2 = MIN(y2, t->wd->h - 1);
+	if (y1 <= y2) redraw->draw_widgetarea(t, 0, y1, t->wd->w - 1, y2);
+}
+
+
+static void select_row(TABLE *t, s32 sel)
+{
+	s32 old = t->td->sel;
+
+	if (sel >= t->td->num_rows) sel = t->td->num_rows - 1;
+	if (sel < 0) sel = t->td->num_rows ? 0 : -1;
+	if (sel == old) return;
+
+	t->td->sel = sel;
+	redraw_row(t, old);
+	redraw_row(t, sel);
+}
+
+
+/****************************
+ ** General widget methods **
+ ****************************/
+
+static inline void draw_sunken_frame(GFX_CONTAINER *d, s32 x, s32 y, s32 w, s32 h)
+{
+	/* outer frame */
+	gfx->draw_hline(d, x + 1,     y,         w - 2, BLACK_MIXED);
+	gfx->draw_vline(d, x,         y,         h,     BLACK_MIXED);
+	gfx->draw_hline(d, x + 1,     y + h - 1, w - 2, BLACK_MIXED);
+	gfx->draw_vline(d, x + w - 1, y,         h,     BLACK_MIXED);
+}
+
+static inline void draw_kfocus_frame(GFX_CONTAINER *d, s32 x, s32 y, s32 w, s32 h)
+{
+	gfx->draw_hline(d, x + 1,     y,         w - 2, BLACK_SOLID);
+	gfx->draw_vline(d, x,         y,         h,     BLACK_SOLID);
+	gfx->draw_hline(d, x + 1,     y + h - 1, w - 2, BLACK_SOLID);
+	gfx->draw_vline(d, x + w - 1, y,         h,     BLACK_SOLID);
+}
+
+
+/**
+ * Draw the cells of one row that lie within the columns first to last
+ */
+static void draw_row(TABLE *t, struct gfx_ds *ds, int x, int y, s32 row,
+                     s32 first, s32 last, u32 color)
+{
+	struct table_column *c;
+	s32 i;
+
+	for (i = first; i <= last; i++) {
+		c = &t->td->cols[i];
+		gfx->push_clipping(ds, x + c->x, y, c->width - TABLE_PAD, t->td->ch);
+		gfx->draw_string(ds, x + c->x + TABLE_PAD, y, color, 0, t->td->font_id,
+		                 row < 0 ? (c->title ? c->title : "") : cell_text(t, row, i));
+		gfx->pop_clipping(ds);
+	}
+}
+
+
+static int tab_draw(TABLE *t, struct gfx_ds *ds, int x, int y)
+{
+	int tx, ty, w, h, cx, cy, cw, ch;
+	s32 i, first_row, last_row, first_col, last_col;
+
+	x += t->wd->x;
+	y += t->wd->y;
+	w = t->wd->w;
+	h = t->wd->h;
+
+	gfx->push_clipping(ds, x, y, w, h);
+
+	x += 2;
+	y += 2;
+	w -= 2*2;
+	h -= 2*2;
+
+	if (t->wd->flags & WID_FLAGS_KFOCUS)
+		draw_kfocus_frame(ds, x - 1, y - 1, w + 2, h + 2);
+
+	gfx->draw_box(ds, x, y, w, h, GFX_RGB(0, 27, 51));
+
+	draw_sunken_frame(ds, x, y, w, h);
+
+	tx = x + 1;
+	ty = y + 1 + t->td->hh;
+
+	gfx->push_clipping(ds, x + 1, y + 1, w - 2, h - 2);
+	cx = gfx->get_clip_x(ds); cw = gfx->get_clip_w(ds);
+	cy = gfx->get_clip_y(ds); ch = gfx->get_clip_h(ds);
+
+	if (t->td->num_cols && t->td->ch > 0 && cw > 0 && ch > 0) {
+
+		/* determine cells within the clipping area */
+		first_col = find_column(t, cx - tx);
+		last_col  = find_column(t, cx + cw - 1 - tx);
+		first_row = MAX(0, (cy - ty)/t->td->ch);
+		last_row  = MIN(t->td->num_rows - 1, (cy + ch - 1 - ty)/t->td->ch);
+
+		if (t->td->hh) {
+			gfx->draw_box(ds, x + 1, y + 1, w - 2, t->td->hh - 1, GFX_RGB(0, 43, 82));
+			draw_row(t, ds, tx, y + 1, -1, first_col, last_col, GFX_RGB(230, 230, 230));
+		}
+
+		gfx->push_clipping(ds, x + 1, ty, w - 2, h - 2 - t->td->hh);
+		if (t->td->sel >= first_row && t->td->sel <= last_row)
+			gfx->draw_box(ds, tx, ty + t->td->sel*t->td->ch, w - 2, t->td->ch, GFX_RGB(0, 59, 112));
+		for (i = first_row; i <= last_row; i++)
+			draw_row(t, ds, tx, ty + i*t->td->ch, i, first_col, last_col, GFX_RGB(200, 200, 200));
+		gfx->pop_clipping(ds);
+	}
+
+	gfx->pop_clipping(ds);
+	gfx->pop_clipping(ds);
+
+	return 1;
+}
+
+
+static void (*orig_handle_event) (TABLE *t, EVENT *ev, WIDGET *from);
+static void tab_handle_event(TABLE *t, EVENT *ev, WIDGET *from)
+{
+	int xpos = userstate->get_mx() - t->gen->get_abs_x(t) - 2 - 1;
+	int ypos = userstate->get_my() - t->gen->get_abs_y(t) - 2 - 1 - t->td->hh;
+	int ev_done = 0;
+	int s = t->td->sel;
+
+	switch (ev->type) {
+	case EVENT_PRESS:
+	case EVENT_KEY_REPEAT:
+		switch (ev->code) {
+			case MTK_BTN_LEFT:
+				if (ypos < 0 || !t->td->ch) return;
+				s = ypos/t->td->ch;
+				if (s >= t->td->num_rows) s = t->td->num_rows - 1;
+				if (t->td->num_cols) t->td->sel_col = find_column(t, xpos);
+				ev_done = (t->td->sel == s) ? 2 : 1;
+				break;
+
+			case MTK_KEY_ENTER:
+				ev_done = 2;
+				break;
+
+			case MTK_KEY_UP:
+				if (s > 0) s--;
+				ev_done = 1;
+				break;
+			case MTK_KEY_DOWN:
+				if (s < t->td->num_rows - 1) s++;
+				ev_done = 1;
+				break;
+
+			case MTK_KEY_HOME:
+				s = 0;
+				ev_done = 1;
+				break;
+			case MTK_KEY_END:
+				s = t->td->num_rows - 1;
+				ev_done = 1;
+				break;
+
+			case MTK_BTN_GEAR_UP:
+			case MTK_BTN_GEAR_DOWN:
+			case MTK_KEY_TAB:
+				orig_handle_event(t, ev, from);
+				return;
+		}
+
+		select_row(t, s);
+
+		if (ev_done == 2) {
+			t->gen->send_action(t, MTK_BIND_SELCOMMIT, "selcommit");
+		}
+		if (ev_done == 1) {
+			t->gen->send_action(t, MTK_BIND_SELCHANGE, "selchange");
+		}
+	}
+}
+
+
+/**
+ * Determine min/max size of a table widget
+ *
+ * The min size covers all cells such that a surrounding Frame
+ * can scroll through the table.
+ */
+static void tab_calc_minmax(TABLE *t)
+{
+	t->td->ch = font->calc_str_height(t->td->font_id, "W");
+	update_columns(t);
+
+	t->wd->min_w = MAX(40,  total_width(t) + 2 + 2*2);
+	t->wd->min_h = MAX(100, t->td->hh + t->td->num_rows*t->td->ch + 2 + 2*2);
+	t->wd->max_w = MAX(99999, t->wd->min_w);
+	t->wd->max_h = MAX(99999, t->wd->min_h);
+}
+
+
+/**
+ * Free table widget data
+ */
+static void tab_free_data(TABLE *t)
+{
+	s32 i;
+
+	for (i = 0; i < t->td->num_cols; i++) {
+		free_store(t, &t->td->cols[i]);
+		if (t->td->cols[i].title) free(t->td->cols[i].title);
+	}
+	if (t->td->cols) free(t->td->cols);
+}
+
+
+/**
+ * Return widget type identifier
+ */
+static char *tab_get_type(TABLE *t)
+{
+	return "Table";
+}
+
+
+/*****************************
+ ** Table specific methods **
+ *****************************/
+
+static void tab_set_rows(TABLE *t, int num_rows)
+{
+	s32 i, j;
+	struct table_column *c;
+
+	if (num_rows < 0) num_rows = 0;
+
+	/* drop cells of removed rows */
+	for (i = 0; i < t->td->num_cols; i++) {
+		c = &t->td->cols[i];
+		if (c->store_size <= num_rows) continue;
+		if (c->type == COLUMN_TEXT)
+			for (j = num_rows; j < c->store_size; j++)
+				if (((char **)c->store)[j]) free(((char **)c->store)[j]);
+		c->store_size = num_rows;
+	}
+
+	t->td->num_rows = num_rows;
+	if (t->td->sel >= num_rows) t->td->sel = num_rows - 1;
+	if (t->td->sel < 0 && num_rows) t->td->sel = 0;
+	t->wd->update |= WID_UPDATE_MINMAX;
+}
+
+
+static int tab_get_rows(TABLE *t)
+{
+	return t->td->num_rows;
+}
+
+
+static void tab_set_columns(TABLE *t, int num_cols)
+{
+	struct table_column *new;
+	s32 i;
+
+	if (num_cols < 0) num_cols = 0;
+
+	for (i = num_cols; i < t->td->num_cols; i++) {
+		free_store(t, &t->td->cols[i]);
+		if (t->td->cols[i].title) free(t->td->cols[i].title);
+	}
+
+	new = realloc(t->td->cols, MAX(num_cols, 1)*sizeof(struct table_column));
+	if (!new) {
+		ERROR(printf("Table(set_columns): out of memory\n"));
+		return;
+	}
+	t->td->cols = new;
+
+	for (i = t->td->num_cols; i < num_cols; i++) {
+		memset(&new[i], 0, sizeof(struct table_column));
+		new[i].width = TABLE_COL_W;
+	}
+	t->td->num_cols = num_cols;
+	if (t->td->sel_col >= num_cols) t->td->sel_col = MAX(num_cols - 1, 0);
+	t->wd->update |= WID_UPDATE_MINMAX;
+}
+
+
+static int tab_get_columns(TABLE *t)
+{
+	return t->td->num_cols;
+}
+
+
+/**
+ * Set font of table
+ */
+static void tab_set_font(TABLE *t, char *fontname)
+{
+	s32 font_id = font->lookup(fontname);
+	if (font_id >= 0) t->td->font_id = font_id;
+	t->wd->update |= WID_UPDATE_MINMAX;
+}
+
+
+static char *tab_get_font(TABLE *t)
+{
+	char *ident = font->get_ident(t->td->font_id);
+	return ident ? ident : "default";
+}
+
+
+static void tab_set_selection(TABLE *t, int selection)
+{
+	select_row(t, selection);
+}
+
+
+static int tab_get_selection(TABLE *t)
+{
+	return t->td->sel;
+}
+
+
+static int tab_get_sel_column(TABLE *t)
+{
+	return t->td->sel_col;
+}
+
+
+/**
+ * Configure column
+ *
+ * \param width  column width in pixels or -1
+ * \param title  header text or "<none>"
+ * \param type   store type "text" or "int", or "<none>"
+ */
+static void tab_column_config(TABLE *t, int index, int width, char *title, char *type)
+{
+	struct table_column *c;
+	int new_type;
+
+	if (index < 0) return;
+	if (index >= t->td->num_cols) tab_set_columns(t, index + 1);
+	if (index >= t->td->num_cols) return;
+	c = &t->td->cols[index];
+
+	if (width >= 0) c->width = width;
+
+	if (title && strcmp(title, "<none>")) {
+		if (c->title) free(c->title);
+		c->title = strdup(title);
+	}
+
+	if (type && strcmp(type, "<none>")) {
+		new_type = strcmp(type, "int") ? COLUMN_TEXT : COLUMN_INT;
+		if (new_type != c->type) {
+			free_store(t, c);
+			c->type = new_type;
+		}
+	}
+
+	t->wd->update |= WID_UPDATE_MINMAX;
+	t->gen->update(t);
+}
+
+
+/**
+ * Assign text to a cell of the column store
+ */
+static void tab_set_cell(TABLE *t, int row, int column, char *text)
+{
+	struct table_column *c;
+	char *new;
+
+	if (!text || row < 0 || row >= t->td->num_rows
+	 || column < 0 || column >= t->td->num_cols) return;
+
+	c = &t->td->cols[column];
+	if (reserve_store(t, c, row)) return;
+
+	if (c->type == COLUMN_INT) {
+		((s32 *)c->store)[row] = atoi(text);
+	} else {
+		if (!(new = strdup(text))) return;
+		if (((char **)c->store)[row]) free(((char **)c->store)[row]);
+		((char **)c->store)[row] = new;
+	}
+	redraw_row(t, row);
+}
+
+
+static char *tab_get_cell(TABLE *t, int row, int column)
+{
+	if (row < 0 || row >= t->td->num_rows
+	 || column < 0 || column >= t->td->num_cols) return "";
+	return cell_text(t, row, column);
+}
+
+
+/**
+ * Define callback that provides the cell text
+ *
+ * If a callback is defined, the column stores are not used.
+ */
+static void tab_set_source(TABLE *t, table_source_func func, void *arg)
+{
+	t->td->source     = func;
+	t->td->source_arg = arg;
+	t->gen->force_redraw(t);
+}
+
+
+/**
+ * Redraw table, e.g., after the data of a source changed
+ */
+static void tab_refresh(TABLE *t)
+{
+	t->gen->force_redraw(t);
+}
+
+
+static struct widget_methods gen_methods;
+static struct table_methods tab_methods = {
+	tab_set_rows,
+	tab_get_rows,
+	tab_set_columns,
+	tab_get_columns,
+	tab_set_font,
+	tab_get_font,
+	tab_set_selection,
+	tab_get_selection,
+	tab_column_config,
+	tab_set_cell,
+	tab_get_cell,
+	tab_set_source,
+	tab_refresh,
+};
+
+
+/***********************
+ ** Service functions **
+ ***********************/
+
+static TABLE *create(void)
+{
+	TABLE *new = ALLOC_WIDGET(struct table);
+	SET_WIDGET_DEFAULTS(new, struct table, &tab_methods);
+
+	/* set table specific attributes */
+	new->td->sel = -1;
+	tab_set_columns(new, 1);
+	new->wd->flags |= WID_FLAGS_EDITABLE | WID_FLAGS_TAKEFOCUS;
+
+	return new;
+}
+
+
+/**************************************
+ ** Service structure of this module **
+ **************************************/
+
+static struct table_services services = {
+	create
+};
+
+
+/************************
+ ** Module entry point **
+ ************************/
+
+static void build_script_lang(void)
+{
+	void *widtype;
+
+	widtype = script->reg_widget_type("Table", (void *(*)(void))create);
+
+	script->reg_widget_attrib(widtype, "int rows", tab_get_rows, tab_set_rows, gen_methods.update);
+	script->reg_widget_attrib(widtype, "int columns", tab_get_columns, tab_set_columns, gen_methods.update);
+	script->reg_widget_attrib(widtype, "string font", tab_get_font, tab_set_font, gen_methods.update);
+	script->reg_widget_attrib(widtype, "int selection", tab_get_selection, tab_set_selection, gen_methods.update);
+	script->reg_widget_attrib(widtype, "int selcolumn", tab_get_sel_column, NULL, NULL);
+	script->reg_widget_method(widtype, "void columnconfig(int index,int width=-1,string title=\"<none>\",string type=\"<none>\")", tab_column_config);
+	script->reg_widget_method(widtype, "void setcell(int row,int column,string text)", tab_set_cell);
+	script->reg_widget_method(widtype, "string getcell(int row,int column)", tab_get_cell);
+	script->reg_widget_method(widtype, "void refresh()", tab_refresh);
+
+	widman->build_script_lang(widtype, &gen_methods);
+}
+
+
+int init_table(struct mtk_services *d)
+{
+	widman    = d->get_module("WidgetManager 1.0");
+	gfx       = d->get_module("Gfx 1.0");
+	font      = d->get_module("FontManager 1.0");
+	script    = d->get_module("Script 1.0");
+	userstate = d->get_module("UserState 1.0");
+	redraw    = d->get_module("RedrawManager 1.0");
+
+	/* define general widget functions */
+	widman->default_widget_methods(&gen_methods);
+
+	orig_handle_event = gen_methods.handle_event;
+
+	gen_methods.draw         = tab_draw;
+	gen_methods.handle_event = tab_handle_event;
+	gen_methods.get_type     = tab_get_type;
+	gen_methods.calc_minmax  = tab_calc_minmax;
+	gen_methods.free_data    = tab_free_data;
+
+	build_script_lang();
+
+	d->register_module("Table 1.0", &services);
+	return 1;
+}
@@ -0,0 +1,57 @@
+/*
+ * \brief   Interface of MTK Table widget module
+ */
+
+/*
+ * Copyright (C) 2010 Sebastien Bourdeauducq
+ *
+ * This file is part of the MTK package, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+#ifndef _MTK_TABLE_H_
+#define _MTK_TABLE_H_
+
+#include "widget.h"
+
+struct table_methods;
+struct table_data;
+
+#define TABLE struct table
+
+struct table {
+	struct widget_methods *gen;
+	struct table_methods  *tab;
+	struct widget_data    *wd;
+	struct table_data     *td;
+};
+
+/**
+ * Callback that provides the text of a table cell
+ *
+ * The text must be written zero-terminated to dst.
+ */
+typedef void (*table_source_func)(int row, int column, char *dst, int dst_size, void *arg);
+
+struct table_methods {
+	void      (*set_rows)       (TABLE *, int num_rows);
+	int       (*get_rows)       (TABLE *);
+	void      (*set_columns)    (TABLE *, int num_cols);
+	int       (*get_columns)    (TABLE *);
+	void      (*set_font)       (TABLE *, char *new_fontname);
+	char     *(*get_font)       (TABLE *);
+	void      (*set_selection)  (TABLE *, int selection);
+	int       (*get_selection)  (TABLE *);
+	void      (*column_config)  (TABLE *, int index, int width, char *title, char *type);
+	void      (*set_cell)       (TABLE *, int row, int column, char *text);
+	char     *(*get_cell)       (TABLE *, int row, int column);
+	void      (*set_source)     (TABLE *, table_source_func func, void *arg);
+	void      (*refresh)        (TABLE *);
+};
+
+struct table_services {
+	TABLE *(*create) (void);
+};
+
+
+#endif /* _MTK_TABLE_H_ */
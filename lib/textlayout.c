@@ -0,0 +1,421 @@
+/*
+ * \brief   MTK text layout module
+ *
+ * This module caches the line starts, the line widths and
+ * the x positions of the characters of a text. Modifications
+ * of the text only cause the affected lines to be laid out
+ * again. Position and index queries are answered by binary
+ * search instead of walking the whole text.
+ */
+
+/*
+ * Copyright (C) 2010 Sebastien Bourdeauducq
+ *
+ * This file is part of the MTK package, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "mtkstd.h"
+#include "fontman.h"
+#include "textlayout.h"
+#include "utf8.h"
+
+#define LINE_TAB_INIT_SIZE 16   /* initial capacity of line table */
+
+static struct fontman_services *fontman;
+
+struct tl_line {
+	s32  start;      /* byte offset of first character            */
+	s32  len;        /* number of bytes without the line break     */
+	s32  width;      /* pixel width of the line                    */
+	s32 *xpos;       /* x position of each byte or NULL, see below */
+};
+
+/*
+ * The xpos array of a line is created on the first query. It holds
+ * len + 1 entries. For the first byte of a character, the entry is
+ * the x position of the character. The following bytes of a UTF-8
+ * sequence hold the negative distance to the first byte.
+ */
+
+struct textlayout {
+	char           *str;         /* laid out text                 */
+	s32             gap_pos;     /* index of gap within the text  */
+	s32             gap_len;     /* number of bytes of the gap    */
+	u8             *scratch;     /* copy of a line across the gap */
+	s32             scratch_size;
+	s32             font_id;
+	s32             line_h;      /* pixel height of one line      */
+	s32             width;       /* max line width or -1          */
+	s32             num_lines;
+	s32             max_lines;   /* capacity of line table        */
+	struct tl_line *lines;
+};
+
+int init_textlayout(struct mtk_services *d);
+
+
+/********************************
+ ** Functions for internal use **
+ ********************************/
+
+/**
+ * Return character at index
+ */
+static inline char text_at(TEXTLAYOUT *tl, s32 idx)
+{
+	return tl->str[idx < tl->gap_pos ? idx : idx + tl->gap_len];
+}
+
+
+/**
+ * Return contiguous copy of a part of the text
+ *
+ * UTF-8 decoding must stop at the end of the part. So the byte that
+ * follows the part must be a line break or the string termination.
+ * A part that touches the gap is copied into a zero-terminated buffer.
+ */
+static const u8 *text_ptr(TEXTLAYOUT *tl, s32 start, s32 len)
+{
+	s32 i;
+
+	if (start + len < tl->gap_pos || !tl->gap_len)
+		return (u8 *)tl->str + start;
+	if (start >= tl->gap_pos)
+		return (u8 *)tl->str + start + tl->gap_len;
+
+	if (len + 1 > tl->scratch_size) {
+		u8 *new = malloc(len + 1);
+		if (!new) return (u8 *)"";
+		if (tl->scratch) free(tl->scratch);
+		tl->scratch      = new;
+		tl->scratch_size = len + 1;
+	}
+	for (i = 0; i < len; i++) tl->scratch[i] = text_at(tl, start + i);
+	tl->scratch[len] = 0;
+	return tl->scratch;
+}
+
+
+/**
+ * Calculate pixel width of a part of the text
+ */
+static s32 measure(TEXTLAYOUT *tl, s32 start, s32 len)
+{
+	const u8 *s = text_ptr(tl, start, len), *end = s + len;
+	s32 w = 0;
+
+	while (s < end) w += fontman->calc_char_width(tl->font_id, utf8_decode(&s));
+	return w;
+}
+
+
+/**
+ * Return xpos array of a line, create it if needed
+ */
+static s32 *get_xpos(TEXTLAYOUT *tl, struct tl_line *l)
+{
+	const u8 *base, *s, *next;
+	s32 i, x = 0;
+
+	if (l->xpos) return l->xpos;
+	if (!(l->xpos = malloc((l->len + 1)*sizeof(s32)))) return NULL;
+
+	base = text_ptr(tl, l->start, l->len);
+	for (s = base; s < base + l->len; s = next) {
+		next = s;
+		l->xpos[s - base] = x;
+		x += fontman->calc_char_width(tl->font_id, utf8_decode(&next));
+		for (i = 1; s + i < next && s + i < base + l->len; i++)
+			l->xpos[s - base + i] = -i;
+	}
+	l->xpos[l->len] = x;
+	return l->xpos;
+}
+
+
+/**
+ * Find line that contains the specified index
+ */
+static s32 find_line(TEXTLAYOUT *tl, s32 idx)
+{
+	s32 lo = 0, hi = tl->num_lines - 1, mid;
+
+	while (lo < hi) {
+		mid = (lo + hi + 1) >> 1;
+		if (tl->lines[mid].start <= idx) lo = mid;
+		else hi = mid - 1;
+	}
+	return lo;
+}
+
+
+/**
+ * Make sure that the line table can hold the specified number of lines
+ */
+static int reserve_lines(TEXTLAYOUT *tl, s32 num)
+{
+	struct tl_line *new;
+	s32 new_max = tl->max_lines;
+
+	if (num <= tl->max_lines) return 0;
+	while (new_max < num) new_max *= 2;
+
+	new = realloc(tl->lines, new_max*sizeof(struct tl_line));
+	if (!new) return -1;
+	tl->lines     = new;
+	tl->max_lines = new_max;
+	return 0;
+}
+
+
+/**
+ * Lay out the lines first to last again
+ *
+ * \param delta  number of bytes that were inserted (positive) or
+ *               removed (negative) within these lines
+ */
+static void relayout(TEXTLAYOUT *tl, s32 first, s32 last, s32 delta)
+{
+	s32 begin = tl->lines[first].start;
+	s32 end   = tl->lines[last].start + tl->lines[last].len + delta;
+	s32 i, num_new = 1, num_old = last - first + 1;
+	struct tl_line *l;
+
+	for (i = begin; i < end; i++)
+		if (text_at(tl, i) == '\n') num_new++;
+
+	if (reserve_lines(tl, tl->num_lines - num_old + num_new)) {
+		ERROR(printf("TextLayout(relayout): out of memory\n"));
+		return;
+	}
+
+	/* drop old lines, the max width must be determined again if it is affected */
+	for (i = first; i <= last; i++) {
+		if (tl->lines[i].width >= tl->width) tl->width = -1;
+		if (tl->lines[i].xpos) free(tl->lines[i].xpos);
+	}
+
+	memmove(tl->lines + first + num_new, tl->lines + last + 1,
+	        (tl->num_lines - last - 1)*sizeof(struct tl_line));
+	tl->num_lines += num_new - num_old;
+
+	for (i = first + num_new; i < tl->num_lines; i++)
+		tl->lines[i].start += delta;
+
+	/* scan new lines */
+	for (l = tl->lines + first; l < tl->lines + first + num_new; l++) {
+		l->start = begin;
+		while ((begin < end) && (text_at(tl, begin) != '\n')) begin++;
+		l->len   = begin - l->start;
+		l->width = measure(tl, l->start, l->len);
+		l->xpos  = NULL;
+		begin++;
+
+		if ((tl->width >= 0) && (l->width > tl->width)) tl->width = l->width;
+	}
+}
+
+
+/***********************
+ ** Service functions **
+ ***********************/
+
+static TEXTLAYOUT *tl_create(void)
+{
+	TEXTLAYOUT *tl = zalloc(sizeof(TEXTLAYOUT));
+	if (!tl) return NULL;
+
+	tl->max_lines = LINE_TAB_INIT_SIZE;
+	tl->lines     = zalloc(tl->max_lines*sizeof(struct tl_line));
+	if (!tl->lines) {
+		free(tl);
+		return NULL;
+	}
+	tl->str       = "";
+	tl->num_lines = 1;
+	return tl;
+}
+
+
+static void tl_destroy(TEXTLAYOUT *tl)
+{
+	s32 i;
+
+	if (!tl) return;
+	for (i = 0; i < tl->num_lines; i++)
+		if (tl->lines[i].xpos) free(tl->lines[i].xpos);
+	if (tl->scratch) free(tl->scratch);
+	free(tl->lines);
+	free(tl);
+}
+
+
+static void tl_set_text(TEXTLAYOUT *tl, s32 font_id, char *str)
+{
+	struct font *f = fontman->get_by_id(font_id);
+
+	if (!tl) return;
+	tl->str     = str ? str : "";
+	tl->gap_pos = tl->gap_len = 0;
+	tl->font_id = font_id;
+	tl->line_h  = f ? f->img_h : 0;
+
+	/* lay out whole text as replacement of the previous text */
+	relayout(tl, 0, tl->num_lines - 1, strlen(tl->str)
+	         - (tl->lines[tl->num_lines - 1].start + tl->lines[tl->num_lines - 1].len));
+	tl->width = -1;
+}
+
+
+static void tl_insert(TEXTLAYOUT *tl, char *str, s32 idx, s32 len)
+{
+	s32 line;
+
+	if (!tl || !str || len <= 0) return;
+	tl->str = str;
+	line = find_line(tl, idx);
+	relayout(tl, line, line, len);
+}
+
+
+static void tl_remove(TEXTLAYOUT *tl, char *str, s32 idx, s32 len)
+{
+	if (!tl || !str || len <= 0) return;
+	tl->str = str;
+	relayout(tl, find_line(tl, idx), find_line(tl, idx + len), -len);
+}
+
+
+static void tl_set_gap(TEXTLAYOUT *tl, s32 pos, s32 len)
+{
+	if (!tl) return;
+	tl->gap_pos = pos;
+	tl->gap_len = len;
+}
+
+
+static void tl_get_pos(TEXTLAYOUT *tl, s32 idx, s32 *xpos, s32 *ypos)
+{
+	s32 line, offset, *x;
+
+	*xpos = *ypos = 0;
+	if (!tl || idx < 0) return;
+
+	line   = find_line(tl, idx);
+	offset = MIN(idx - tl->lines[line].start, tl->lines[line].len);
+	if (!(x = get_xpos(tl, &tl->lines[line]))) return;
+
+	if (x[offset] < 0) offset += x[offset];
+	*xpos = x[offset];
+	*ypos = line*tl->line_h;
+}
+
+
+static s32 tl_get_index(TEXTLAYOUT *tl, s32 xpos, s32 ypos)
+{
+	struct tl_line *l;
+	s32 line, lo, hi, mid, next, *x;
+
+	if (!tl || !tl->line_h) return 0;
+
+	line = ypos/tl->line_h;
+	if (line < 0) line = 0;
+	if (line >= tl->num_lines) line = tl->num_lines - 1;
+	l = &tl->lines[line];
+
+	if (!(x = get_xpos(tl, l))) return l->start;
+
+	/*
+	 * Find the first character whose center is not left of xpos.
+	 * The center positions grow monotonically with the index.
+	 */
+	lo = 0; hi = l->len;
+	while (lo < hi) {
+		mid = (lo + hi) >> 1;
+		if (x[mid] < 0) mid += x[mid];
+		for (next = mid + 1; next < l->len && x[next] < 0; next++);
+
+		if (x[mid] >= xpos - ((x[next] - x[mid])>>1)) hi = mid;
+		else lo = next;
+	}
+	return l->start + lo;
+}
+
+
+static s32 tl_get_width(TEXTLAYOUT *tl)
+{
+	s32 i;
+
+	if (!tl) return 0;
+	if (tl->width < 0) {
+		tl->width = 0;
+		for (i = 0; i < tl->num_lines; i++)
+			tl->width = MAX(tl->width, tl->lines[i].width);
+	}
+	return tl->width;
+}
+
+
+static s32 tl_get_height(TEXTLAYOUT *tl)
+{
+	return tl ? tl->num_lines*tl->line_h : 0;
+}
+
+
+static s32 tl_num_lines(TEXTLAYOUT *tl)
+{
+	return tl ? tl->num_lines : 0;
+}
+
+
+static s32 tl_get_line(TEXTLAYOUT *tl, s32 idx)
+{
+	return tl ? find_line(tl, idx) : 0;
+}
+
+
+static void tl_get_line_range(TEXTLAYOUT *tl, s32 line, s32 *start, s32 *len)
+{
+	*start = *len = 0;
+	if (!tl || line < 0 || line >= tl->num_lines) return;
+	*start = tl->lines[line].start;
+	*len   = tl->lines[line].len;
+}
+
+
+/**************************************
+ ** Service structure of this module **
+ **************************************/
+
+static struct textlayout_services services = {
+	tl_create,
+	tl_destroy,
+	tl_set_text,
+	tl_insert,
+	tl_remove,
+	tl_set_gap,
+	tl_get_pos,
+	tl_get_index,
+	tl_get_width,
+	tl_get_height,
+	tl_num_lines,
+	tl_get_line,
+	tl_get_line_range,
+};
+
+
+/************************
+ ** Module entry point **
+ ************************/
+
+int init_textlayout(struct mtk_services *d)
+{
+	fontman = d->get_module("FontManager 1.0");
+
+	d->register_module("TextLayout 1.0", &services);
+	return 1;
+}
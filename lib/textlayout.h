@@ -0,0 +1,87 @@
+/*
+ * \brief   Interface of the text layout module of MTK
+ */
+
+/*
+ * Copyright (C) 2010 Sebastien Bourdeauducq
+ *
+ * This file is part of the MTK package, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+#ifndef _MTK_TEXTLAYOUT_H_
+#define _MTK_TEXTLAYOUT_H_
+
+/*
+ * A text layout caches the line structure and the character positions
+ * of a (possibly multi-line) UTF-8 string that is drawn with one font.
+ * The string is owned by the caller, who reports each modification via
+ * 'insert' or 'remove' after changing the string. Character indices are
+ * byte offsets within the string.
+ *
+ * The string may contain a gap of unused bytes as used by gap buffers.
+ * Character indices do not count the gap.
+ */
+
+#define TEXTLAYOUT struct textlayout
+struct textlayout;
+
+struct textlayout_services {
+	TEXTLAYOUT *(*create)    (void);
+	void        (*destroy)   (TEXTLAYOUT *tl);
+
+	/**
+	 * Lay out new text, e.g., after the font or the whole text changed
+	 */
+	void        (*set_text)  (TEXTLAYOUT *tl, s32 font_id, char *str);
+
+	/**
+	 * Update layout after len bytes were inserted at idx
+	 *
+	 * \param str  modified string, which may be a reallocated buffer
+	 */
+	void        (*insert)    (TEXTLAYOUT *tl, char *str, s32 idx, s32 len);
+
+	/**
+	 * Update layout after len bytes were removed at idx
+	 */
+	void        (*remove)    (TEXTLAYOUT *tl, char *str, s32 idx, s32 len);
+
+	/**
+	 * Declare gap of len unused bytes at character index pos
+	 *
+	 * Must be called before 'insert' or 'remove' whenever the gap moved.
+	 * 'set_text' resets the gap.
+	 */
+	void        (*set_gap)   (TEXTLAYOUT *tl, s32 pos, s32 len);
+
+	/**
+	 * Calculate pixel position of the character at the specified index
+	 */
+	void        (*get_pos)   (TEXTLAYOUT *tl, s32 idx, s32 *xpos, s32 *ypos);
+
+	/**
+	 * Calculate character index that corresponds to a pixel position
+	 */
+	s32         (*get_index) (TEXTLAYOUT *tl, s32 xpos, s32 ypos);
+
+	/**
+	 * Request pixel size of the whole text
+	 */
+	s32         (*get_width) (TEXTLAYOUT *tl);
+	s32         (*get_height)(TEXTLAYOUT *tl);
+
+	/**
+	 * Request number of lines and the line that contains an index
+	 */
+	s32         (*num_lines) (TEXTLAYOUT *tl);
+	s32         (*get_line)  (TEXTLAYOUT *tl, s32 idx);
+
+	/**
+	 * Request index of first character and length of a line
+	 */
+	void        (*get_line_range) (TEXTLAYOUT *tl, s32 line, s32 *start, s32 *len);
+};
+
+
+#endif /* _MTK_TEXTLAYOUT_H_ */
@@ -10,98 +10,214 @@
  * under the terms of the GNU General Public License version 2.
  */
 
+#include <stdlib.h>
+#include <stdio.h>
 #include "mtkstd.h"
 #include "timer.h"
 #include "tick.h"
 
-#define MAX_TICKS 32
+/*
+ * Ticks are kept in a growable slot array. A binary heap of slot
+ * indices, ordered by deadline, determines the next due tick. A
+ * tick handle consists of the slot index plus one and a serial
+ * number of the slot, which invalidates handles of freed ticks.
+ */
+
+#define TICKS_INIT_SIZE 32
+#define SLOT_BITS       20
+#define SLOT_MASK       ((1 << SLOT_BITS) - 1)
+#define SERIAL_MASK     0x7ff
 
-struct tick;
 struct tick {
-	u32         deadline;            /* next deadline          */
-	u32         usec;                /* duration between ticks */
-	int       (*callback) (void *);  /* tick callback          */
-	void        *arg;                /* callback argument      */
-	struct tick *next;               /* next tick in ticklist  */
+	u32         deadline;            /* next deadline               */
+	u32         usec;                /* duration between ticks      */
+	int       (*callback) (void *);  /* tick callback or NULL       */
+	void        *arg;                /* callback argument           */
+	s32          heap_idx;           /* position in heap or -1      */
+	s32          next_free;          /* next slot in free list      */
+	s32          serial;             /* incremented on each release */
 };
 
-static struct tick ticks[MAX_TICKS];
-static struct tick *head = NULL;     /* head of tick list */
+static struct tick *ticks;           /* tick slots                   */
+static s32  *heap;                   /* slot indices ordered by time */
+static s32   num_slots, max_slots;
+static s32   heap_len;
+static s32   free_slot = -1;         /* head of free slot list       */
+static s32   running   = -1;         /* slot of executed callback    */
+static int   running_cancelled;      /* running tick was cancelled   */
 
 static struct timer_services *timer;
 
 int init_tick(struct mtk_services *d);
 
 
-/***********************
- ** Service functions **
- ***********************/
+/********************************
+ ** Functions for internal use **
+ ********************************/
 
 /**
- * Schedule new tick event
+ * Compare deadlines, the comparison is safe across timer wrap-arounds
  */
-static void queue_tick(struct tick *t)
+static inline int earlier(s32 a, s32 b)
 {
-	struct tick *curr;
-	
-	/* if ticklist is empty add first element */
-	if (!head) {
-		t->next = 0;
-		head    = t;
-		return;
+	return (s32)(ticks[a].deadline - ticks[b].deadline) < 0;
+}
+
+
+static inline void heap_set(s32 pos, s32 slot)
+{
+	heap[pos] = slot;
+	ticks[slot].heap_idx = pos;
+}
+
+
+static void sift_up(s32 pos)
+{
+	s32 slot = heap[pos];
+
+	while (pos > 0 && earlier(slot, heap[(pos - 1)/2])) {
+		heap_set(pos, heap[(pos - 1)/2]);
+		pos = (pos - 1)/2;
 	}
+	heap_set(pos, slot);
+}
+
+
+static void sift_down(s32 pos)
+{
+	s32 slot = heap[pos], child;
+
+	while ((child = 2*pos + 1) < heap_len) {
+		if (child + 1 < heap_len && earlier(heap[child + 1], heap[child])) child++;
+		if (!earlier(heap[child], slot)) break;
+		heap_set(pos, heap[child]);
+		pos = child;
+	}
+	heap_set(pos, slot);
+}
+
+
+static void queue_tick(s32 slot)
+{
+	heap_set(heap_len++, slot);
+	sift_up(heap_len - 1);
+}
+
+
+static void dequeue_tick(s32 slot)
+{
+	s32 pos = ticks[slot].heap_idx, last;
+
+	ticks[slot].heap_idx = -1;
+	if (--heap_len == pos) return;
+
+	/* fill the gap with the last element and restore the heap order */
+	last = heap[heap_len];
+	heap_set(pos, last);
+	sift_up(pos);
+	sift_down(ticks[last].heap_idx);
+}
+
+
+/**
+ * Allocate tick slot, grow slot array and heap if needed
+ *
+ * \return  slot index or -1 if out of memory
+ */
+static s32 alloc_slot(void)
+{
+	s32 slot;
 
-	/* if deadline is smaller than any other deadline, put it on the head */
-	if (t->deadline < head->deadline) {
-		t->next = head;
-		head    = t;
-		return;
+	if (free_slot >= 0) {
+		slot = free_slot;
+		free_slot = ticks[slot].next_free;
+		return slot;
 	}
 
-	/* find list element with a higher deadline */
-	curr = head;
-	while (curr->next && (curr->next->deadline < t->deadline)) curr = curr->next;
+	if (num_slots == max_slots) {
+		s32 new_max = max_slots ? max_slots*2 : TICKS_INIT_SIZE;
+		struct tick *new_ticks;
+		s32 *new_heap;
 
-	/* if end of list is reached, append new element */
-	if (!curr->next) {
-		curr->next = t;
-		return;
+		if (new_max > SLOT_MASK) return -1;
+		if (!(new_ticks = realloc(ticks, new_max*sizeof(struct tick)))) return -1;
+		ticks = new_ticks;
+		if (!(new_heap = realloc(heap, new_max*sizeof(s32)))) return -1;
+		heap = new_heap;
+		max_slots = new_max;
 	}
+	ticks[num_slots].serial = 0;
+	return num_slots++;
+}
 
-	/* insert element in middle of list */
-	t->next    = curr->next;
-	curr->next = t;
+
+static void release_slot(s32 slot)
+{
+	ticks[slot].callback  = NULL;
+	ticks[slot].serial    = (ticks[slot].serial + 1) & SERIAL_MASK;
+	ticks[slot].next_free = free_slot;
+	free_slot = slot;
 }
 
 
+/***********************
+ ** Service functions **
+ ***********************/
+
 /**
  * Register new timer tick callback routine
  *
  * \param msec      duration between ticks
- * \param callback  routine that is called for every tick
+ * \param callback  routine that is called for every tick, the tick
+ *                  stays registered as long as it returns 1
  * \param arg       private argument for callback
- * \return          1 on success
+ * \return          tick handle or 0 on failure
  *
  * The return code of this function should be evaluated!
  */
-static int tick_add(s32 msec, int (*callback)(void *), void *arg)
+static s32 tick_add(s32 msec, int (*callback)(void *), void *arg)
 {
-	int i;
+	s32 slot = alloc_slot();
+	struct tick *t;
 
-	/* find empty tick slot */
-	for (i=0; i<MAX_TICKS; i++)
-		if (ticks[i].callback == NULL) break;
+	if (slot < 0) {
+		ERROR(printf("Tick(add): out of memory\n"));
+		return 0;
+	}
 
-	/* no empty tick slot - return 0 */
-	if (i == MAX_TICKS) return 0;
+	t = &ticks[slot];
+	t->usec     = msec * 1000;
+	t->deadline = timer->get_time() + t->usec;
+	t->callback = callback;
+	t->arg      = arg;
+	queue_tick(slot);
+
+	return (t->serial << SLOT_BITS) | (slot + 1);
+}
 
-	/* put new tick at the beginning of the ticklist */
-	ticks[i].usec     = msec * 1000;
-	ticks[i].deadline = timer->get_time() + ticks[i].usec;
-	ticks[i].callback = callback;
-	ticks[i].arg      = arg;
-	queue_tick(&ticks[i]);
 
+/**
+ * Unregister tick
+ *
+ * A tick may also cancel itself from within its callback.
+ *
+ * \return  1 if the tick was registered
+ */
+static int tick_cancel(s32 handle)
+{
+	s32 slot = (handle & SLOT_MASK) - 1;
+
+	if (slot < 0 || slot >= num_slots || !ticks[slot].callback
+	 || ticks[slot].serial != ((handle >> SLOT_BITS) & SERIAL_MASK))
+		return 0;
+
+	if (slot == running) {
+		running_cancelled = 1;
+		return 1;
+	}
+
+	dequeue_tick(slot);
+	release_slot(slot);
 	return 1;
 }
 
@@ -112,27 +228,47 @@ static int tick_add(s32 msec, int (*callback)(void *), void *arg)
 static void tick_handle(void)
 {
 	u32 now = timer->get_time();
-	struct tick *curr = head;
-	
-	while ((curr = head) && ((s32)now > (s32)head->deadline)) {
-		void *arg = head->arg;
+	s32 slot;
+
+	while (heap_len && (s32)(now - ticks[heap[0]].deadline) > 0) {
+		int reschedule;
 
-		/* remove tick from head of the list */
-		head = curr->next;
-		curr->next = NULL;
+		slot = heap[0];
+		dequeue_tick(slot);
 
-		if (curr->callback(arg)) {
+		running = slot;
+		running_cancelled = 0;
+		reschedule = ticks[slot].callback(ticks[slot].arg);
+		running = -1;
+
+		if (reschedule && !running_cancelled) {
 			/* tick is still valid - schedule next event */
-			curr->deadline = now + curr->usec;
-			queue_tick(curr);
+			ticks[slot].deadline = now + ticks[slot].usec;
+			queue_tick(slot);
 		} else {
-			/* mark tick slot as free */
-			curr->callback = NULL;
+			release_slot(slot);
 		}
 	}
 }
 
 
+/**
+ * Request time until the next tick is due
+ *
+ * \return  microseconds or -1 if no tick is registered
+ */
+static s32 tick_next_deadline(void)
+{
+	s32 remaining;
+
+	if (!heap_len) return -1;
+
+	/* a tick is due when the time passed its deadline */
+	remaining = (s32)(ticks[heap[0]].deadline - timer->get_time()) + 1;
+	return MAX(remaining, 0);
+}
+
+
 /**************************************
  ** Service structure of this module **
  **************************************/
@@ -140,6 +276,8 @@ static void tick_handle(void)
 static struct tick_services services = {
 	tick_add,
 	tick_handle,
+	tick_cancel,
+	tick_next_deadline,
 };
 
 
@@ -14,8 +14,10 @@
 #define _MTK_TICK_H_
 
 struct tick_services {
-	int   (*add)    (s32 msec, int (*callback)(void *), void *arg);
-	void  (*handle) (void);
+	s32   (*add)           (s32 msec, int (*callback)(void *), void *arg);
+	void  (*handle)        (void);
+	int   (*cancel)        (s32 handle);
+	s32   (*next_deadline) (void);
 };
 
 #endif /* _MTK_TICK_H_ */
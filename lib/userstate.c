@@ -25,6 +25,7 @@
 #include "userstate.h"
 #include "redraw.h"
 #include "tick.h"
+#include "timer.h"
 #include "messenger.h"
 #include "widget_data.h"
 #include "mtkeycodes.h"
@@ -33,6 +34,7 @@
 static struct scrdrv_services *scrdrv;
 static struct redraw_services *redraw;
 static struct tick_services   *tick;
+static struct timer_services  *timer;
 
 static s32     omx,omy,omb;                 /* original mouse postion     */
 static s32     curr_mx, curr_my;            /* current mouse position     */
@@ -52,6 +54,9 @@ static s32     curr_keystate;               /* current key state          */
 static int    curr_keycode;                /* code of curr. pressed key  */
 static s32     key_repeat_delay = 250;      /* delay until key repeat     */
 static s32     key_repeat_rate = 30;        /* key repeat rate            */
+static WIDGET *motion_receiver;             /* receiver of pending motion */
+static EVENT   motion_pending;              /* rate-limited motion event  */
+static s32     motion_tick;                 /* handle of flush tick       */
 
 #define USERSTATE_KEY_IDLE   0x0            /* no key pressed             */
 #define USERSTATE_KEY_PRESS  0x1            /* key pressed                */
@@ -288,6 +293,85 @@ static int tick_handle_delay(void *arg)
 }
 
 
+/**
+ * Deliver pending rate-limited motion event
+ */
+static void flush_motion(void)
+{
+	WIDGET *w = motion_receiver;
+
+	if (motion_tick) tick->cancel(motion_tick);
+	motion_tick = 0;
+
+	if (!w) return;
+	motion_receiver = NULL;
+
+	w->wd->motion_time = timer->get_time();
+	w->gen->handle_event(w, &motion_pending, NULL);
+	w->gen->dec_ref(w);
+}
+
+
+/**
+ * Tick callback that delivers a pending motion event when it is due
+ */
+static int tick_flush_motion(void *arg)
+{
+	WIDGET *w = motion_receiver;
+
+	if (w && w->wd->motion_rate > 0
+	 && (timer->get_time() - w->wd->motion_time) < 1000000/w->wd->motion_rate)
+		return 1;
+
+	flush_motion();
+	return 0;
+}
+
+
+/**
+ * Deliver motion event to a widget
+ *
+ * If the widget limits the rate of its motion events, motion events
+ * that arrive too early are merged into one pending event. It gets
+ * delivered when the interval expired or before any press or release
+ * event, whatever comes first.
+ */
+static void deliver_motion(WIDGET *w, EVENT *ev)
+{
+	u32 interval, elapsed;
+
+	if (w != motion_receiver || w->wd->motion_rate <= 0) flush_motion();
+
+	if (w->wd->motion_rate <= 0) {
+		w->gen->handle_event(w, ev, NULL);
+		return;
+	}
+
+	interval = 1000000/w->wd->motion_rate;
+	elapsed  = timer->get_time() - w->wd->motion_time;
+
+	/* merge event with pending motion */
+	if (motion_receiver) {
+		motion_pending.abs_x  = ev->abs_x;
+		motion_pending.abs_y  = ev->abs_y;
+		motion_pending.rel_x += ev->rel_x;
+		motion_pending.rel_y += ev->rel_y;
+	} else {
+		motion_pending  = *ev;
+		motion_receiver = w;
+		w->gen->inc_ref(w);
+	}
+
+	if (elapsed >= interval) {
+		flush_motion();
+		return;
+	}
+
+	if (!motion_tick)
+		motion_tick = tick->add((interval - elapsed)/1000 + 1, tick_flush_motion, NULL);
+}
+
+
 /**
  * Update mouse focus
  */
@@ -304,6 +388,9 @@ static void update_mfocus(void)
 
 	if (new_mfocus == curr_mfocus) return;
 
+	/* deliver pending motion before the leave event */
+	flush_motion();
+
 	if (curr_mfocus) {
 		curr_mfocus->gen->set_mfocus(curr_mfocus, 0);
 		if (curr_mfocus->wd->flags & WID_FLAGS_HIGHLIGHT)
@@ -323,6 +410,12 @@ static void update_mfocus(void)
 	curr_mfocus = new_mfocus;
 }
 
+static inline int motion_event(int type)
+{
+	return (type == EVENT_MOTION) || (type == EVENT_ABSMOTION);
+}
+
+
 static int repeatable_key(int code)
 {
 	switch(code) {
@@ -397,11 +490,21 @@ static void handle(EVENT *e, int count)
 				break;
 		}
 
+		/*
+		 * Consecutive motion events only move the mouse position.
+		 * The mouse focus gets updated for the last one.
+		 */
+		if (motion_event(e[i].type) && (i + 1 < count) && motion_event(e[i + 1].type))
+			continue;
+
 		update_mfocus();
 
 		if ((e[i].type == EVENT_PRESS) || (e[i].type == EVENT_RELEASE)) {
 			WIDGET *win_kfocus = NULL;
 
+			/* keep order of motion and press/release events */
+			flush_motion();
+
 			/* make clicked window the active one */
 			if (curr_mfocus && key_sets_focus(e[i].code)) {
 				WINDOW *w = (WINDOW *)curr_mfocus->gen->get_window(curr_mfocus);
@@ -462,7 +565,7 @@ static void handle(EVENT *e, int count)
 					event.abs_y = curr_my - curr_mfocus->gen->get_abs_y(curr_mfocus);
 					event.rel_x = curr_mx - old_mx;
 					event.rel_y = curr_my - old_my;
-					curr_mfocus->gen->handle_event(curr_mfocus, &event, NULL);
+					deliver_motion(curr_mfocus, &event);
 				}
 			}
 			break;
@@ -535,7 +638,7 @@ static void handle(EVENT *e, int count)
 				event.abs_y = curr_my - min_y;
 				event.rel_x = curr_mx - old_mx;
 				event.rel_y = curr_my - old_my;
-				curr_selected->gen->handle_event(curr_selected, &event, NULL);
+				deliver_motion(curr_selected, &event);
 			}
 			if (curr_tick_callback) {
 				curr_tick_callback(curr_selected, curr_mx - omx, curr_my - omy);
@@ -637,6 +740,15 @@ static void release_widget(WIDGET *w)
 		cw->gen->dec_ref(cw);
 	}
 
+	/* drop pending motion event of the widget or its children */
+	if (motion_receiver && w->gen->related_to(w, motion_receiver)) {
+		cw = motion_receiver;
+		motion_receiver = NULL;
+		cw->gen->dec_ref(cw);
+		tick->cancel(motion_tick);
+		motion_tick = 0;
+	}
+
 	/* check if widget has the current mouse focus as child */
 	if (curr_receiver && w->gen->related_to(w, curr_receiver)) {
 		cw = curr_receiver;
@@ -646,6 +758,18 @@ static void release_widget(WIDGET *w)
 }
 
 
+/**
+ * Deliver pending motion event of a widget immediately
+ *
+ * This function must be called whenever the motion rate of a widget
+ * changes because pending events were scheduled for the old rate.
+ */
+static void flush_widget_motion(WIDGET *w)
+{
+	if (w && w == motion_receiver) flush_motion();
+}
+
+
 /**************************************
  ** Service structure of this module **
  **************************************/
@@ -670,6 +794,7 @@ static struct userstate_services services = {
 	set_max_my,
 	release_app,
 	release_widget,
+	flush_widget_motion,
 };
 
 
@@ -682,6 +807,7 @@ int init_userstate(struct mtk_services *d)
 	scrdrv  = d->get_module("ScreenDriver 1.0");
 	redraw  = d->get_module("RedrawManager 1.0");
 	tick    = d->get_module("Tick 1.0");
+	timer   = d->get_module("Timer 1.0");
 
 	d->register_module("UserState 1.0",&services);
 	return 1;
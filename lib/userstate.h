@@ -46,6 +46,7 @@ struct userstate_services {
 	void    (*set_max_my)        (int max_my);
 	void    (*release_app)       (int app_id);
 	void    (*release_widget)    (WIDGET *);
+	void    (*flush_motion)      (WIDGET *);
 };
 
 
@@ -0,0 +1,70 @@
+/*
+ * \brief   UTF-8 decoding
+ */
+
+/*
+ * Copyright (C) 2010 Sebastien Bourdeauducq
+ *
+ * This file is part of the MTK package, which is distributed
+ * under the terms of the GNU General Public License version 2.
+ */
+
+#ifndef _MTK_UTF8_H_
+#define _MTK_UTF8_H_
+
+/**
+ * Decode character of UTF-8 string and advance string pointer
+ *
+ * Bytes that do not start a valid UTF-8 sequence are returned as
+ * is. This way, ISO-8859-1 strings are still displayed correctly.
+ *
+ * \return  Unicode value of the character
+ */
+static inline u32 utf8_decode(const u8 **str)
+{
+	const u8 *s = *str;
+	u32 ucs = s[0];
+	int len, i;
+
+	if      (ucs < 0x80)           { *str = s + 1; return ucs; }
+	else if ((ucs & 0xe0) == 0xc0) { len = 2; ucs &= 0x1f; }
+	else if ((ucs & 0xf0) == 0xe0) { len = 3; ucs &= 0x0f; }
+	else if ((ucs & 0xf8) == 0xf0) { len = 4; ucs &= 0x07; }
+	else                           { *str = s + 1; return ucs; }
+
+	for (i = 1; i < len; i++) {
+
+		/* invalid continuation byte (also catches the terminating zero) */
+		if ((s[i] & 0xc0) != 0x80) {
+			*str = s + 1;
+			return s[0];
+		}
+		ucs = (ucs << 6) | (s[i] & 0x3f);
+	}
+	*str = s + len;
+	return ucs;
+}
+
+
+/**
+ * Determine number of bytes of the character at the start of a string
+ */
+static inline int utf8_len(const u8 *str)
+{
+	const u8 *s = str;
+
+	utf8_decode(&s);
+	return s - str;
+}
+
+
+/**
+ * Check if byte is a continuation byte of a UTF-8 sequence
+ */
+static inline int utf8_continues(u8 c)
+{
+	return (c & 0xc0) == 0x80;
+}
+
+
+#endif /* _MTK_UTF8_H_ */
@@ -59,14 +59,11 @@ int init_variable(struct mtk_services *d);
  ** General widget methods **
  ****************************/
 
-static int var_draw(VARIABLE *v, struct gfx_ds *ds, int x, int y, WIDGET *origin)
+static int var_draw(VARIABLE *v, struct gfx_ds *ds, int x, int y)
 {
 	int tx = x + v->wd->x + 2;
 	int ty = y + v->wd->y + 2;
 
-	if (origin == v) return 1;
-	if (origin) return 0;
-
 	if (v->vd->text) {
 		gfx->draw_string(ds, tx, ty, BLACK_SOLID, 0, v->vd->font_id, v->vd->text);
 	} else {
@@ -34,6 +34,7 @@
 
 struct widget_methods;
 struct gfx_ds;
+union mtklib_event_union;
 
 struct widget {
 	struct widget_methods *gen;   /* generic widget functions       */
@@ -77,6 +78,7 @@ struct widget_methods {
 	int    (*get_max_h)    (WIDGETARG *);
 	int    (*get_abs_x)    (WIDGETARG *);
 	int    (*get_abs_y)    (WIDGETARG *);
+	WIDGET *(*get_abs_clip) (WIDGETARG *, int *x1, int *y1, int *x2, int *y2);
 	int     (*get_state)    (WIDGETARG *);
 	void    (*set_state)    (WIDGETARG *, int new_state);
 	int     (*get_evforward)(WIDGETARG *);
@@ -96,21 +98,13 @@ struct widget_methods {
 	/**
 	 * Draw widget - to implement for every widget
 	 *
-	 * If a widget is specified as origin argument, the draw function does not
-	 * perform any actual drawing operations but only returns if the specified
-	 * origin widget is visible through the widget. This way, we can determine
-	 * if a transparent window in the foreground must be updated when a window
-	 * in the background changes.
-	 *
 	 * \param dst     destination gfx container into which to draw
 	 * \param x       x position of left top corner
 	 * \param y       y position of left top corner
-	 * \param origin  widget for which we want to know if it is visible
-	 *                or not, or NULL if drawing should be performed.
 	 * \returns       0 if no drawing operation was performed,
 	 *                1 if a drawing operation was performed
 	 */
-	int (*draw) (WIDGETARG *, struct gfx_ds *dst, int x, int y, WIDGETARG *origin);
+	int (*draw) (WIDGETARG *, struct gfx_ds *dst, int x, int y);
 
 
 	/**
@@ -129,8 +123,7 @@ struct widget_methods {
 	 * \param cw       current widget that propagates the request
 	 * \param ow       widget to redraw
 	 * \param x,y,w,h  area to be redrawn - relative to widget cw
-	 * \returns        1 if drawing operation was performed or if specified
-	 *                 os widget is visible, otherwise 0.
+	 * \returns        1 if drawing operation was performed, otherwise 0.
 	 */
 	int (*drawarea) (WIDGETARG *cw, WIDGETARG *ow, int x, int y, int w, int h);
 
@@ -140,21 +133,17 @@ struct widget_methods {
 	 *
 	 * This function is a drawing primitive that can be used from within
 	 * widget's draw function to implement transparent user interface elements.
-	 * For more information about the origin parameter please revisit the
-	 * description of the draw function.
 	 *
 	 * \param cw        current widget that propagates the request
 	 * \param child     reference to the caller of the function
 	 *                  This information is used by the screen to find the
 	 *                  refering window.
 	 * \param x,y,w,h   area to be redrawn - relative to widget cw.
-	 * \param origin    widget for which we want to know if it is visible
-	 *                  or not, or NULL if drawing should be performed.
 	 * \returns         1 if any graphics operations were performed,
 	 *                  0 if no graphics operations were performed.
 	 */
 	int (*drawbehind) (WIDGETARG *cw, WIDGETARG *child,
-	                   int x, int y, int w, int h, WIDGETARG *origin);
+	                   int x, int y, int w, int h);
 
 
 	/**
@@ -164,8 +153,7 @@ struct widget_methods {
 	 * background. A widget can decide whether a background is drawn or not.
 	 * Since the background drawing is propagated to the parents, stacked
 	 * backgrounds can be easily handled without overdrawing an area multiple
-	 * times. For more information about the origin parameter, please revisit
-	 * the description of the draw function.
+	 * times.
 	 *
 	 * The position is specified as absolute coordinates.
 	 *
@@ -173,13 +161,11 @@ struct widget_methods {
 	 * \param x,y     absolute screen position of left top corner of area
 	 * \param w,h     dimensions of area to draw
 	 * \param opaque  do not use transparency / do not call drawbehind
-	 * \param origin    widget for which we want to know if it is visible
-	 *                  or not, or NULL if drawing should be performed.
 	 * \returns       0 if no drawing operation was performed,
 	 *                1 if a drawing operation was performed
 	 */
 	int (*draw_bg) (WIDGETARG *, struct gfx_ds *dst, int x, int y, int w, int h,
-	                WIDGETARG *origin, int opaque);
+	                int opaque);
 
 
 	/**
@@ -316,6 +302,39 @@ struct widget_methods {
 	char   *(*get_bind_msg) (WIDGETARG *, char *bind_ident);
 
 
+	/**
+	 * Bind callback function to an event type (MTK_BIND_*)
+	 *
+	 * Passing NULL as callback removes the binding.
+	 */
+	void (*bind_callback) (WIDGETARG *, int type,
+	                       void (*callback)(union mtklib_event_union *, void *),
+	                       void *arg, int filter);
+
+
+	/**
+	 * Check if event type is bound by a callback or a message
+	 */
+	int (*is_bound) (WIDGETARG *, int type);
+
+
+	/**
+	 * Deliver input event to the bindings of the widget
+	 *
+	 * \return  1 if the event was delivered to a binding
+	 */
+	int (*send_input) (WIDGETARG *, EVENT *ev);
+
+
+	/**
+	 * Deliver action event to the bindings of the widget
+	 *
+	 * \param action  command string passed with the event
+	 * \return        1 if the event was delivered to a binding
+	 */
+	int (*send_action) (WIDGETARG *, int type, char *action);
+
+
 	/**
 	 * Determine if widget is a root widget
 	 *
@@ -365,6 +384,16 @@ struct widget_methods {
 	 * a new child to avoid cyclic parent relationships.
 	 */
 	int (*related_to) (WIDGETARG *, WIDGETARG *);
+
+
+	/**
+	 * Notify widget about a changed position or size of a child
+	 *
+	 * This function is called by the child before the change takes
+	 * effect. Layout widgets that keep derived data about the geometry
+	 * of their children can use it to invalidate that data.
+	 */
+	void (*child_changed) (WIDGETARG *, WIDGETARG *child);
 };
 
 #endif /* _MTK_WIDGET_H_ */
@@ -26,6 +26,7 @@
 #define WID_FLAGS_SELECTABLE 0x0080   /* widget is selectable via keyboard   */
 #define WID_FLAGS_TAKEFOCUS  0x0100   /* widget can receive keyboard focus   */
 #define WID_FLAGS_GRABFOCUS  0x0200   /* prevent keyboard focus to switch    */
+#define WID_FLAGS_TILING     0x0400   /* children never overlap each other   */
 
 /**
  * Widget update flags
@@ -44,6 +45,14 @@ struct binding {
 };
 
 
+union mtklib_event_union;
+struct native_binding {
+	void (*callback)(union mtklib_event_union *, void *);  /* or NULL */
+	void  *arg;         /* argument of the callback             */
+	int    filter;      /* key/button code to match or 0 for all */
+};
+
+
 struct new_binding;
 struct new_binding {
 	int    app_id;       /* application to receive the event */
@@ -59,6 +68,16 @@ struct widget_data {
 	int    x, y, w, h;         /* current relative position and size  */
 	int    min_w, min_h;       /* minimal size                        */
 	int    max_w, max_h;       /* maximal size                        */
+	int    lay_min_w, lay_min_h;   /* min/max size as known by the parent */
+	int    lay_max_w, lay_max_h;
+	WIDGET  *lay_parent;        /* parent that did the last layout     */
+	s32     motion_rate;        /* max. motion events per second or 0  */
+	u32     motion_time;        /* time of last delivered motion event */
+	int    abs_x, abs_y;       /* cached absolute position            */
+	int    clip_x1, clip_y1;   /* cached visible area in absolute     */
+	int    clip_x2, clip_y2;   /* coordinates                         */
+	WIDGET  *abs_top;           /* cached top-level parent (window)    */
+	u32     abs_gen;            /* geometry generation of cached values */
 	int    flags;              /* state flags                         */
 	int    update;             /* update flags                        */
 	void    *context;           /* associated data                     */
@@ -69,6 +88,7 @@ struct widget_data {
 	int    ref_cnt;            /* reference counter                   */
 	s32     app_id;             /* application that owns the widget    */
 	struct binding *bindings;   /* event bindings                      */
+	struct native_binding *natives;  /* indexed by MTK_BIND_* or NULL  */
 	struct new_binding *new_bindings;
 };
 
@@ -19,10 +19,10 @@
 /**
  * Allocate widget structure of specified type
  */
-#define ALLOC_WIDGET(widtype)                          \
-	(widtype *)zalloc(sizeof(widtype)                   \
-	                + sizeof(struct widget_data)         \
-	                + sizeof(widtype ## _data));
+#define ALLOC_WIDGET(widtype)                                      \
+	(widtype *)widman->alloc_widget(#widtype, sizeof(widtype)       \
+	                                + sizeof(struct widget_data)     \
+	                                + sizeof(widtype ## _data));
 
 
 /**
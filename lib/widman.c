@@ -31,12 +31,30 @@
 #include "window.h"
 #include "mtkeycodes.h"
 #include "userstate.h"
+#include "slab.h"
+#include "mtklib.h"
 
 static struct redraw_services    *redraw;
 static struct script_services    *script;
 static struct appman_services    *appman;
 static struct userstate_services *userstate;
 static struct messenger_services *msg;
+static struct slab_services      *slab;
+
+static SLAB *binding_pool;
+static SLAB *natives_pool;   /* tables of native bindings */
+
+/* identifiers of the event types MTK_BIND_* as used by bind */
+static char *bind_names[MTK_BIND_NUM_TYPES] = {
+	"press", "release", "motion", "enter", "leave", "keyrepeat",
+	"click", "clack", "commit", "change", "slide", "slid",
+	"resize", "resized", "move", "moved", "close", "top",
+	"selchange", "selcommit",
+};
+
+static s32 layout_passes;    /* number of do_layout calls of parents */
+static s32 layout_avoided;   /* propagations stopped at unchanged min/max */
+static u32 layout_gen = 1;   /* incremented on any geometry change        */
 
 int init_widman(struct mtk_services *d);
 
@@ -52,16 +70,42 @@ static void wid_free_data(WIDGET *w)
 {}
 
 
+/**
+ * Determine bind type of an input event type
+ *
+ * The bind types MTK_BIND_PRESS to MTK_BIND_KEYREPEAT follow the
+ * order of the event types EVENT_PRESS to EVENT_KEY_REPEAT.
+ */
+static inline int input_bind_type(int ev_type)
+{
+	if ((ev_type < EVENT_PRESS) || (ev_type > EVENT_KEY_REPEAT)) return -1;
+	return ev_type - EVENT_PRESS + MTK_BIND_PRESS;
+}
+
+
+/**
+ * Determine event type (MTK_BIND_*) of a binding identifier
+ *
+ * \return  event type or -1 if the identifier is unknown
+ */
+static int get_bind_type(char *bind_ident)
+{
+	int i;
+
+	for (i = 0; i < MTK_BIND_NUM_TYPES; i++)
+		if (mtk_streq(bind_ident, bind_names[i], 255)) return i;
+	return -1;
+}
+
+
 /**
  * Free single binding data struct
  */
 static inline void free_binding(struct binding *b)
 {
-	if (b->bind_ident)
-		free(b->bind_ident);
-	if (b->msg)
-		free(b->msg);
-	free(b);
+	slab->free(b->bind_ident);
+	slab->free(b->msg);
+	slab->free(b);
 }
 
 
@@ -109,6 +153,16 @@ static void wid_set_app_id(WIDGET *w, s32 new_app_id)
 }
 
 
+/**
+ * Account for a change of the position or size of a widget
+ */
+static void geometry_changed(WIDGET *w)
+{
+	layout_gen++;
+	if (w->wd->parent) w->wd->parent->gen->child_changed(w->wd->parent, w);
+}
+
+
 /**
  * Get/set widget position relative to its parent
  */
@@ -118,6 +172,7 @@ static int wid_get_x(WIDGET *w)
 }
 static void wid_set_x(WIDGET *w,int new)
 {
+	if (w->wd->x != new) geometry_changed(w);
 	w->wd->x = new;
 }
 static int wid_get_y(WIDGET *w)
@@ -126,6 +181,7 @@ static int wid_get_y(WIDGET *w)
 }
 static void wid_set_y(WIDGET *w,int new)
 {
+	if (w->wd->y != new) geometry_changed(w);
 	w->wd->y = new;
 }
 
@@ -141,8 +197,10 @@ static void wid_set_w(WIDGET *w,int new)
 {
 	if (new < w->wd->min_w) new = w->wd->min_w;
 	if (new > w->wd->max_w) new = w->wd->max_w;
-	if (w->wd->w != new)
+	if (w->wd->w != new) {
 		w->wd->update |= WID_UPDATE_SIZE;
+		geometry_changed(w);
+	}
 	w->wd->w = new;
 }
 static int wid_get_h(WIDGET *w)
@@ -153,8 +211,10 @@ static void wid_set_h(WIDGET *w,int new)
 {
 	if (new < w->wd->min_h) new = w->wd->min_h;
 	if (new > w->wd->max_h) new = w->wd->max_h;
-	if (w->wd->h != new)
+	if (w->wd->h != new) {
 		w->wd->update |= WID_UPDATE_SIZE;
+		geometry_changed(w);
+	}
 	w->wd->h = new;
 }
 
@@ -188,26 +248,82 @@ static void wid_calc_minmax(WIDGET *w)
 }
 
 
+static inline int is_parent(WIDGET *w)
+{
+	return w && (w != (WIDGET *)'#');
+}
+
+
+/**
+ * Update cached absolute position and visible area of a widget
+ *
+ * The cached values stay valid as long as no widget changes its
+ * geometry. The visible area is the widget area clipped to the
+ * areas of all parents up to the top-level widget, whose parent
+ * is the screen.
+ */
+static void update_abs(WIDGET *w)
+{
+	struct widget_data *wd = w->wd;
+	WIDGET *p = wd->parent;
+
+	if (wd->abs_gen == layout_gen) return;
+
+	wd->abs_x = wd->x;
+	wd->abs_y = wd->y;
+	if (is_parent(p)) {
+		update_abs(p);
+		wd->abs_x += p->wd->abs_x;
+		wd->abs_y += p->wd->abs_y;
+	}
+
+	wd->clip_x1 = wd->abs_x;
+	wd->clip_y1 = wd->abs_y;
+	wd->clip_x2 = wd->abs_x + wd->w - 1;
+	wd->clip_y2 = wd->abs_y + wd->h - 1;
+	wd->abs_top = w;
+
+	if (is_parent(p) && is_parent(p->wd->parent)) {
+		wd->clip_x1 = MAX(wd->clip_x1, p->wd->clip_x1);
+		wd->clip_y1 = MAX(wd->clip_y1, p->wd->clip_y1);
+		wd->clip_x2 = MIN(wd->clip_x2, p->wd->clip_x2);
+		wd->clip_y2 = MIN(wd->clip_y2, p->wd->clip_y2);
+		wd->abs_top = p->wd->abs_top;
+	}
+	wd->abs_gen = layout_gen;
+}
+
+
 /**
  * Determine absolute position of the widget on the screen
  */
 static int wid_get_abs_x(WIDGET *w)
 {
-	int x=0;
-	while ((w!=NULL) && (w!=(WIDGET *)'#')) {
-		x+=w->wd->x;
-		w=w->wd->parent;
-	}
-	return x;
+	if (!is_parent(w)) return 0;
+	update_abs(w);
+	return w->wd->abs_x;
 }
 static int wid_get_abs_y(WIDGET *w)
 {
-	int y=0;
-	while ((w!=NULL) && (w!=(WIDGET *)'#')) {
-		y+=w->wd->y;
-		w=w->wd->parent;
-	}
-	return y;
+	if (!is_parent(w)) return 0;
+	update_abs(w);
+	return w->wd->abs_y;
+}
+
+
+/**
+ * Determine visible area of the widget in absolute screen coordinates
+ *
+ * \return  top-level widget that contains the widget
+ */
+static WIDGET *wid_get_abs_clip(WIDGET *w, int *x1, int *y1, int *x2, int *y2)
+{
+	update_abs(w);
+	*x1 = w->wd->clip_x1;
+	*y1 = w->wd->clip_y1;
+	*x2 = w->wd->clip_x2;
+	*y2 = w->wd->clip_y2;
+	return w->wd->abs_top;
 }
 
 
@@ -295,6 +411,20 @@ static void wid_set_evforward(WIDGET *w,int new)
 }
 
 
+/**
+ * Get/set maximum rate of motion events per second (0 means unlimited)
+ */
+static int wid_get_motion_rate(WIDGET *w)
+{
+	return w->wd->motion_rate;
+}
+static void wid_set_motion_rate(WIDGET *w, int new)
+{
+	userstate->flush_motion(w);
+	w->wd->motion_rate = MAX(new, 0);
+}
+
+
 /**
  * Get/set current parent of widget
  */
@@ -310,6 +440,7 @@ static void wid_set_parent(WIDGET *w, void *new_parent)
 	userstate->release_widget(w);
 
 	w->wd->parent = new_parent;
+	layout_gen++;
 }
 
 
@@ -379,7 +510,7 @@ static void wid_set_selectable(WIDGET *w,int new_sel)
 /**
  * Draw a widget (dummy - must be overwritten by something more useful
  */
-static int wid_draw(WIDGET *w, struct gfx_ds *ds, int x, int y, WIDGET *origin)
+static int wid_draw(WIDGET *w, struct gfx_ds *ds, int x, int y)
 {
 	w = w; x = x; y = y;    /* just to avoid warnings */
 	return 0;
@@ -412,7 +543,7 @@ static int wid_drawarea(WIDGET *cw, WIDGET *origin, int x, int y, int w, int h)
  * Cause the redraw of the window behind a specified widget area
  */
 static int wid_drawbehind(WIDGET *cw, WIDGET *child,
-                          int x, int y, int w, int h, WIDGET *origin) {
+                          int x, int y, int w, int h) {
 	WIDGET *parent = cw->gen->get_parent(cw);
 	if (!parent) return 0;
 
@@ -426,7 +557,7 @@ static int wid_drawbehind(WIDGET *cw, WIDGET *child,
 	x += cw->wd->x;
 	y += cw->wd->y;
 
-	return parent->gen->drawbehind(parent, cw, x, y, w, h, origin);
+	return parent->gen->drawbehind(parent, cw, x, y, w, h);
 }
 
 
@@ -434,13 +565,13 @@ static int wid_drawbehind(WIDGET *cw, WIDGET *child,
  * Draw background of widget
  */
 static int wid_draw_bg(WIDGET *cw, struct gfx_ds *ds, int x, int y,
-                       int w, int h, WIDGET *origin, int opaque ) {
+                       int w, int h, int opaque) {
 
 	/* sanity check */
 	if (w <= 0 || h <= 0 || !cw->wd->parent) return 0;
 
 	/* propagate background drawing request to the parent */
-	return cw->wd->parent->gen->draw_bg(cw->wd->parent, ds, x, y, w, h, origin, opaque);
+	return cw->wd->parent->gen->draw_bg(cw->wd->parent, ds, x, y, w, h, opaque);
 }
 
 
@@ -480,10 +611,8 @@ static WIDGET *wid_get_window(WIDGET *cw)
  */
 static void wid_update(WIDGET *w)
 {
-	int old_min_w = w->wd->min_w;
-	int old_max_w = w->wd->max_w;
-	int old_min_h = w->wd->min_h;
-	int old_max_h = w->wd->max_h;
+	struct widget_data *wd = w->wd;
+	WIDGET *parent;
 
 	/*
 	 * If wid_update is called from within the destroy or free_data
@@ -494,19 +623,36 @@ static void wid_update(WIDGET *w)
 
 	w->gen->calc_minmax(w);
 
-	if (w->wd->min_w != old_min_w || w->wd->max_w != old_max_w
-	 || w->wd->min_h != old_min_h || w->wd->max_h != old_max_h)
-		w->wd->update |= WID_UPDATE_MINMAX;
+	/*
+	 * The WID_UPDATE_MINMAX flag only tells that the min/max
+	 * properties may have changed. The layout of the parent depends
+	 * on the resulting values only. We remember the values that the
+	 * parent saw at its last layout. If they did not change, the
+	 * propagation stops here and only the widget itself gets
+	 * repositioned and redrawn.
+	 */
+	parent = w->gen->get_parent(w);
+	if (wd->min_w != wd->lay_min_w || wd->max_w != wd->lay_max_w
+	 || wd->min_h != wd->lay_min_h || wd->max_h != wd->lay_max_h
+	 || parent != wd->lay_parent) {
+		wd->update |= WID_UPDATE_MINMAX;
+		wd->lay_min_w  = wd->min_w;
+		wd->lay_max_w  = wd->max_w;
+		wd->lay_min_h  = wd->min_h;
+		wd->lay_max_h  = wd->max_h;
+		wd->lay_parent = parent;
+		if (parent) {
+			layout_passes++;
+			parent->gen->do_layout(parent, w);
+		}
+	} else if (parent && (wd->update & WID_UPDATE_MINMAX))
+		layout_avoided++;
 
-	if (w->wd->update & WID_UPDATE_MINMAX) {
-		WIDGET *parent = w->gen->get_parent((WIDGET *)w);
-		if (parent) parent->gen->do_layout(parent, w);
-	}
-	if (w->wd->update) {
+	if (wd->update) {
 		w->gen->updatepos(w);
 		w->gen->force_redraw(w);
 	}
-	w->wd->update = 0;
+	wd->update = 0;
 }
 
 
@@ -542,10 +688,11 @@ static void wid_dec_ref(WIDGET *w)
 
 	/* free bindings */
 	FREE_CONNECTED_LIST(struct binding, w->wd->bindings, free_binding);
+	slab->free(w->wd->natives);
 	FREE_CONNECTED_LIST(struct new_binding, w->wd->new_bindings, free_new_binding);
 
 	/* free widget struct */
-	free(w);
+	slab->free(w);
 }
 
 
@@ -563,7 +710,6 @@ static void wid_force_redraw(WIDGET *cw)
  */
 static void wid_handle_event(WIDGET *cw,EVENT *e, WIDGET *from)
 {
-	struct binding *cb;
 	s16 propagate = 1;
 
 	/* tell the parent to switch the keyboard focus */
@@ -582,12 +728,8 @@ static void wid_handle_event(WIDGET *cw,EVENT *e, WIDGET *from)
 	}
 
 	/* check bindings */
-	for (cb = cw->wd->bindings; cb; cb = cb->next) {
-		if (cb->ev_type == e->type) {
-			msg->send_input_event(cw->wd->app_id,e,cb->msg);
-			propagate = 0;
-		}
-	}
+	if (cw->gen->send_input(cw, e))
+		propagate = 0;
 
 	/* propagate event to parent widget by default */
 	if ((cw->wd->flags & WID_FLAGS_EVFORWARD) && (propagate) &&
@@ -651,6 +793,30 @@ static int wid_do_layout(WIDGET *cw,WIDGET *child)
 //}
 
 
+/**
+ * Enable widget to receive the keyboard focus if key events are bound
+ */
+static void enable_kfocus(WIDGET *cw, int type)
+{
+	if (type != MTK_BIND_PRESS
+	 && type != MTK_BIND_RELEASE
+	 && type != MTK_BIND_KEYREPEAT) return;
+
+	/* only consider selectable or editable widgets to take the focus */
+	if ((cw->wd->flags & (WID_FLAGS_SELECTABLE | WID_FLAGS_EDITABLE))
+	 && !(cw->wd->flags & WID_FLAGS_TAKEFOCUS)) {
+		cw->wd->flags |= WID_FLAGS_TAKEFOCUS;
+
+		/*
+		 * If we enable the widget to take the focus its properties
+		 * may change. For example, a button needs a padding to draw
+		 * the focus frame.
+		 */
+		cw->gen->update(cw);
+	}
+}
+
+
 /**
  * Add event binding for a widget
  */
@@ -659,15 +825,15 @@ static void wid_bind(WIDGET *cw,char *bind_ident,char *message)
 	struct binding *new;
 
 	INFO(printf("Widman(bind): create new binding for %s\n",bind_ident);)
-	new = (struct binding *)zalloc(sizeof(struct binding));
+	new = (struct binding *)slab->alloc(binding_pool);
 	if (!new) {
 		ERROR(printf("WidgetManager(bind): out of memory!\n");)
 		return;
 	}
 
-	new->msg  = strdup(message);
+	new->msg  = slab->strdup(message);
 	new->next = cw->wd->bindings;
-	new->bind_ident  = strdup(bind_ident);
+	new->bind_ident  = slab->strdup(bind_ident);
 	cw->wd->bindings = new;
 
 	if (mtk_streq(bind_ident, "press",     6)) {new->ev_type = EVENT_PRESS;       }
@@ -680,24 +846,7 @@ static void wid_bind(WIDGET *cw,char *bind_ident,char *message)
 	if (new->ev_type == 0)
 		new->ev_type = EVENT_ACTION;
 
-	/* enable widget to receive the keyboard focus */
-	if (new->ev_type == EVENT_PRESS
-	 || new->ev_type == EVENT_RELEASE
-	 || new->ev_type == EVENT_KEY_REPEAT) {
-
-		/* only consider selectable or editable widgets to take the focus */
-		if ((cw->wd->flags & (WID_FLAGS_SELECTABLE | WID_FLAGS_EDITABLE))
-		 && !(cw->wd->flags & WID_FLAGS_TAKEFOCUS)) {
-			cw->wd->flags |= WID_FLAGS_TAKEFOCUS;
-
-			/*
-			 * If we enable the widget to take the focus its properties
-			 * may change. For example, a button needs a padding to draw
-			 * the focus frame.
-			 */
-			cw->gen->update(cw);
-		}
-	}
+	enable_kfocus(cw, input_bind_type(new->ev_type));
 }
 
 
@@ -707,6 +856,11 @@ static void wid_bind(WIDGET *cw,char *bind_ident,char *message)
 static void wid_unbind(WIDGET *cw, char *bind_ident)
 {
 	struct binding *b = cw->wd->bindings;
+	int type = get_bind_type(bind_ident);
+
+	/* remove callback bound to the event type */
+	if ((type >= 0) && cw->wd->natives)
+		cw->wd->natives[type].callback = NULL;
 
 	/* search for binding to remove */
 	for (; b && b->next && mtk_streq(b->next->bind_ident, bind_ident, 16); b = b->next);
@@ -732,6 +886,105 @@ static char *wid_get_bind_msg(WIDGET *cw, char *bind_ident)
 }
 
 
+/**
+ * Bind callback function to an event type
+ */
+static void wid_bind_callback(WIDGET *cw, int type,
+                              void (*callback)(union mtklib_event_union *, void *),
+                              void *arg, int filter)
+{
+	struct native_binding *nb;
+
+	if ((type < 0) || (type >= MTK_BIND_NUM_TYPES)) return;
+
+	/* the binding table is allocated on the first use */
+	if (!cw->wd->natives) {
+		if (!callback) return;
+		cw->wd->natives = slab->alloc(natives_pool);
+		if (!cw->wd->natives) {
+			ERROR(printf("WidgetManager(bind_callback): out of memory!\n");)
+			return;
+		}
+	}
+
+	nb = &cw->wd->natives[type];
+	nb->callback = callback;
+	nb->arg      = arg;
+	nb->filter   = filter;
+
+	if (callback) enable_kfocus(cw, type);
+}
+
+
+/**
+ * Check if event type is bound by a callback or a message
+ */
+static int wid_is_bound(WIDGET *cw, int type)
+{
+	if ((type < 0) || (type >= MTK_BIND_NUM_TYPES)) return 0;
+
+	if (cw->wd->natives && cw->wd->natives[type].callback) return 1;
+
+	return cw->wd->bindings && wid_get_bind_msg(cw, bind_names[type]);
+}
+
+
+/**
+ * Deliver input event to the bindings of a widget
+ */
+static int wid_send_input(WIDGET *cw, EVENT *e)
+{
+	struct native_binding *nb;
+	struct binding *cb;
+	int type = input_bind_type(e->type), sent = 0;
+
+	if (type < 0) return 0;
+
+	if (cw->wd->natives) {
+		nb = &cw->wd->natives[type];
+		if (nb->callback && (!nb->filter || (nb->filter == e->code))) {
+			msg->call_input_event(e, nb->callback, nb->arg);
+			sent = 1;
+		}
+	}
+
+	for (cb = cw->wd->bindings; cb; cb = cb->next) {
+		if (cb->ev_type == e->type) {
+			msg->send_input_event(cw->wd->app_id, e, cb->msg);
+			sent = 1;
+		}
+	}
+	return sent;
+}
+
+
+/**
+ * Deliver action event to the bindings of a widget
+ */
+static int wid_send_action(WIDGET *cw, int type, char *action)
+{
+	struct native_binding *nb;
+	char *m;
+	int sent = 0;
+
+	if ((type < 0) || (type >= MTK_BIND_NUM_TYPES)) return 0;
+
+	if (cw->wd->natives) {
+		nb = &cw->wd->natives[type];
+		if (nb->callback) {
+			msg->call_action_event(action, nb->callback, nb->arg);
+			sent = 1;
+		}
+	}
+
+	if (cw->wd->bindings && (m = wid_get_bind_msg(cw, bind_names[type]))) {
+		msg->send_action_event(cw->wd->app_id, action, m);
+		sent = 1;
+	}
+	return sent;
+}
+
+
 /**
  * Determine if widget is a root widget
  */
@@ -775,6 +1028,13 @@ static int wid_related_to(WIDGET *w1, WIDGET *w2)
 }
 
 
+/**
+ * Notify widget about a changed geometry of a child
+ */
+static void wid_child_changed(WIDGET *w, WIDGET *child)
+{ }
+
+
 /***********************
  ** Service functions **
  ***********************/
@@ -789,6 +1049,9 @@ static void default_widget_data(struct widget_data *d)
 	d->min_h   = 0;
 	d->max_w   = 10000;
 	d->max_h   = 10000;
+	d->lay_min_w  = d->lay_min_h = -1;
+	d->lay_max_w  = d->lay_max_h = -1;
+	d->lay_parent = NULL;
 	d->update  = 0;
 	d->next    = NULL;
 	d->prev    = NULL;
@@ -799,6 +1062,9 @@ static void default_widget_data(struct widget_data *d)
 	d->ref_cnt = 1;
 	d->app_id  = -1;
 	d->bindings= 0;
+	d->motion_rate = 0;
+	d->motion_time = 0;
+	d->abs_gen     = 0;
 }
 
 
@@ -825,6 +1091,7 @@ static void default_widget_methods(struct widget_methods *m)
 	m->get_max_h      = wid_get_max_h;
 	m->get_abs_x      = wid_get_abs_x;
 	m->get_abs_y      = wid_get_abs_y;
+	m->get_abs_clip   = wid_get_abs_clip;
 	m->get_state      = wid_get_state;
 	m->set_state      = wid_set_state;
 	m->get_evforward  = wid_get_evforward;
@@ -860,6 +1127,10 @@ static void default_widget_methods(struct widget_methods *m)
 	m->bind           = wid_bind;
 	m->unbind         = wid_unbind;
 	m->get_bind_msg   = wid_get_bind_msg;
+	m->bind_callback  = wid_bind_callback;
+	m->is_bound       = wid_is_bound;
+	m->send_input     = wid_send_input;
+	m->send_action    = wid_send_action;
 	m->drawarea       = wid_drawarea;
 	m->drawbehind     = wid_drawbehind;
 	m->draw_bg        = wid_draw_bg;
@@ -868,6 +1139,7 @@ static void default_widget_methods(struct widget_methods *m)
 	m->remove_child   = wid_remove_child;
 	m->release        = wid_release;
 	m->related_to     = wid_related_to;
+	m->child_changed  = wid_child_changed;
 }
 
 
@@ -876,12 +1148,60 @@ static void build_script_lang(void *widtype,struct widget_methods *m)
 	script->reg_widget_attrib(widtype, "string type",       m->get_type,      NULL,             NULL);
 	script->reg_widget_attrib(widtype, "boolean state",     m->get_state,     m->set_state,     m->update);
 	script->reg_widget_attrib(widtype, "boolean grabfocus", m->get_grabfocus, m->set_grabfocus, m->update);
+	script->reg_widget_attrib(widtype, "int motionrate",    wid_get_motion_rate, wid_set_motion_rate, NULL);
 	script->reg_widget_method(widtype, "void bind(string type,string msg)", m->bind);
 	script->reg_widget_method(widtype, "void unbind(string type)", m->unbind);
 	script->reg_widget_method(widtype, "void focus()", m->focus);
 }
 
 
+/**
+ * Request number of performed and avoided parent layout passes
+ */
+static void get_layout_stats(s32 *passes, s32 *avoided)
+{
+	if (passes)  *passes  = layout_passes;
+	if (avoided) *avoided = layout_avoided;
+}
+
+
+/**
+ * Request geometry generation
+ *
+ * The returned value changes whenever a widget changes its
+ * position, size or parent. It can be used to validate cached
+ * geometric information.
+ */
+static u32 get_layout_gen(void)
+{
+	return layout_gen;
+}
+
+
+/**
+ * Invalidate cached geometric information
+ *
+ * Must be called by modules that change the position, size or
+ * parent of a widget without using its set functions.
+ */
+static void invalidate_geometry(void)
+{
+	layout_gen++;
+}
+
+
+/**
+ * Allocate widget structure from the pool of its type
+ */
+static void *alloc_widget(char *type_name, int size)
+{
+	/* strip the 'struct' keyword of the stringified type */
+	if (!strncmp(type_name, "struct ", 7)) type_name += 7;
+
+	return slab->alloc(slab->get_pool(type_name, size));
+}
+
+
 /**************************************
  ** Service structure of this module **
  **************************************/
@@ -890,6 +1210,11 @@ static struct widman_services services = {
 	default_widget_data,
 	default_widget_methods,
 	build_script_lang,
+	get_layout_stats,
+	get_layout_gen,
+	invalidate_geometry,
+	alloc_widget,
+	get_bind_type,
 };
 
 
@@ -904,6 +1229,11 @@ int init_widman(struct mtk_services *d)
 	script    = d->get_module("Script 1.0");
 	appman    = d->get_module("ApplicationManager 1.0");
 	userstate = d->get_module("UserState 1.0");
+	slab      = d->get_module("Slab 1.0");
+
+	binding_pool = slab->get_pool("binding", sizeof(struct binding));
+	natives_pool = slab->get_pool("native bindings",
+	                              MTK_BIND_NUM_TYPES*sizeof(struct native_binding));
 
 	d->register_module("WidgetManager 1.0",&services);
 	return 1;
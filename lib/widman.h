@@ -19,6 +19,24 @@ struct widman_services {
 	void (*default_widget_data)    (struct widget_data *);
 	void (*default_widget_methods) (struct widget_methods *);
 	void (*build_script_lang)      (void *widtype,struct widget_methods *);
+	void (*get_layout_stats)       (s32 *passes, s32 *avoided);
+	u32  (*get_layout_gen)         (void);
+	void (*invalidate_geometry)    (void);
+
+	/**
+	 * Allocate zeroed widget structure from the pool of its type
+	 *
+	 * Widget structures are freed when their reference counter
+	 * reaches zero.
+	 */
+	void *(*alloc_widget)          (char *type_name, int size);
+
+	/**
+	 * Determine event type (MTK_BIND_*) of a binding identifier
+	 *
+	 * \return  event type or -1 if the identifier is unknown
+	 */
+	int   (*get_bind_type)         (char *bind_ident);
 };
 
 
@@ -15,6 +15,8 @@ struct window;
 #define WIDGET struct window
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "mtkstd.h"
 #include "window.h"
 #include "script.h"
@@ -28,7 +30,7 @@ struct window;
 #include "winlayout.h"
 #include "appman.h"
 #include "userstate.h"
-#include "messenger.h"
+#include "mtklib.h"
 #include "mtkeycodes.h"
 
 static struct widman_services    *widman;
@@ -37,7 +39,6 @@ static struct userstate_services *userstate;
 static struct script_services    *script;
 static struct winlayout_services *winlayout;
 static struct appman_services    *appman;
-static struct messenger_services *msg;
 
 #define WIN_UPDATE_NEW_CONTENT  0x01
 #define WIN_UPDATE_SET_STAYTOP  0x02
@@ -59,10 +60,11 @@ struct window_data {
 	u32 update;
 	u32 bgcol;
 	int ux, uy, uw, uh;          /* user defined size */
+	u16 *shadow_mask;            /* drop shadow for the size below */
+	int mask_w, mask_h;
 };
 
-static GFX_CONTAINER *shadow;
-static int shadow_w = 17, shadow_h = 17;
+static int shadow_w, shadow_h;
 static int shadow_top, shadow_bottom;
 static int shadow_left, shadow_right;
 
@@ -71,6 +73,12 @@ extern int config_transparency;  /* support transparent windows */
 
 extern unsigned int config_bg_win_color;
 
+/**
+ * Radial drop-shadow image, generated at build time (see mktables.c)
+ */
+extern const u32 shadow_img[];
+extern const int shadow_img_w, shadow_img_h;
+
 extern SCREEN *curr_scr;
 
 int init_window(struct mtk_services *d);
@@ -142,52 +150,6 @@ static inline void remove_kfocus(WINDOW *w)
 }
 
 
-/*************************
- ** Drop shadow support **
- *************************/
-
-/**
- * Calculate square root
- *
- * The valid argument range is 0..65535.
- */
-static int sqroot(u32 v)
-{
-	u32 c = 0x8000;
-	u32 res = 0;
-	while (c) {
-		if (v >= ((res | c)*(res | c))) res |= c;
-		c = c >> 1;
-	}
-	return res;
-}
-
-
-/**
- * Generate radial shadow image
- */
-static void gen_shadow(u32 *dst, int w, int h, int mx, int my)
-{
-	int x, y, r, ry;
-	u32 *d;
-	int scale = (255*255)/(w*h);
-
-	mx += mx;
-	my += my;
-
-	ry = mx*mx + my*my;
-	for (y = 0; y < h; y++) {
-		d = dst;
-		for (x = 0, r = ry; x < w; x++) {
-			d[x] = GFX_RGBA(0, 0, 0, ((255 - MIN(sqroot(r*scale), 255))*2)/3);
-			r += 4*(2*x - mx) + 4;
-		}
-		ry  += 4*(2*y - my) + 4;
-		dst += w;
-	}
-}
-
-
 /*********************************
  ** Userstate handler functions **
  *********************************/
@@ -207,18 +169,13 @@ static void win_move_motion_callback(WIDGET *cw, int dx, int dy)
 	nwx1 = owx1 + dx;
 	nwy1 = owy1 + dy;
 	curr_screen->scr->place(curr_screen, curr_window, nwx1, nwy1, NOARG, NOARG);
-	if (dx || dy) {
-		char *m = curr_window->gen->get_bind_msg((WIDGET *)curr_window, "move");
-		s32  id = curr_window->gen->get_app_id((WIDGET *)curr_window);
-		if (m) msg->send_action_event(id, "move", m);
-	}
+	if (dx || dy)
+		curr_window->gen->send_action((WIDGET *)curr_window, MTK_BIND_MOVE, "move");
 }
 
 
 static void win_close_leave_callback(WIDGET *cw, int dx, int dy) {
 	WINDOW *w;
-	char   *m;
-	s32     id;
 
 	/* cw is the close button */
 	if (!cw || !cw->gen->get_state(cw)) return;
@@ -228,9 +185,7 @@ static void win_close_leave_callback(WIDGET *cw, int dx, int dy) {
 	if (!w) return;
 
 	/* send close event to client */
-	m  = w->gen->get_bind_msg((WIDGET *)w, "close");
-	id = w->gen->get_app_id((WIDGET *)w);
-	if (m) msg->send_action_event(id, "close", m);
+	w->gen->send_action((WIDGET *)w, MTK_BIND_CLOSE, "close");
 
 	/* restore state of close button */
 	cw->gen->set_state(cw, 0);
@@ -243,11 +198,8 @@ static void win_move_leave_callback(WIDGET *cw, int dx, int dy)
 {
 	if (!curr_window) return;
 
-	if (dx || dy) {
-		char *m  = curr_window->gen->get_bind_msg((WIDGET *)curr_window, "moved");
-		s32  id = curr_window->gen->get_app_id((WIDGET *)curr_window);
-		if (m) msg->send_action_event(id, "moved", m);
-	}
+	if (dx || dy)
+		curr_window->gen->send_action((WIDGET *)curr_window, MTK_BIND_MOVED, "moved");
 
 	if (cw) {
 		cw->gen->set_state(cw, 0);
@@ -310,13 +262,9 @@ static void win_resize_leave_callback(WIDGET *cw, int dx, int dy)
 	if (!curr_window) return;
 
 	if (dx || dy) {
-		char *m = curr_window->gen->get_bind_msg((WIDGET *)curr_window, "resized");
-		s32  id = curr_window->gen->get_app_id((WIDGET *)curr_window);
-		if (m) msg->send_action_event(id, "resized", m);
-		if ((owx1 != nwx1) || (owy1 != nwy1)) {
-			m = curr_window->gen->get_bind_msg((WIDGET *)curr_window, "moved");
-			if (m) msg->send_action_event(id, "moved", m);
-		}
+		curr_window->gen->send_action((WIDGET *)curr_window, MTK_BIND_RESIZED, "resized");
+		if ((owx1 != nwx1) || (owy1 != nwy1))
+			curr_window->gen->send_action((WIDGET *)curr_window, MTK_BIND_MOVED, "moved");
 	}
 
 	if ((dx>-2) && (dx<2) && (dy>-2) && (dy<2)) {
@@ -395,10 +343,9 @@ static void win_set_app_id(WINDOW *w, s32 app_id)
  * Draw window background
  */
 static int win_draw_bg(WINDOW *cw, struct gfx_ds *ds, int x, int y, int w, int h,
-                       WIDGET *origin, int opaque) {
+                       int opaque) {
 	int ret = 0;
 
-	if (origin == cw) return 1;
 	if ((w <= 0) || (h <= 0)) return 0;
 
 	if (config_transparency) {
@@ -407,66 +354,192 @@ static int win_draw_bg(WINDOW *cw, struct gfx_ds *ds, int x, int y, int w, int h
 
 		if (!opaque) {
 			int abs_x = cw->gen->get_abs_x(cw), abs_y = cw->gen->get_abs_y(cw);
-			ret |= cw->gen->drawbehind(cw, cw, x - abs_x, y - abs_y, w, h, origin);
+			ret |= cw->gen->drawbehind(cw, cw, x - abs_x, y - abs_y, w, h);
 		}
 
 		/*
 		 * If the drawbehind function performed any graphics operations,
 		 * we need to paint the foreground, too.
 		 */
-		if ((ret || opaque) && !origin)
+		if (ret || opaque)
 			gfx->draw_box(ds, x, y, w, h, bgcol);
 
 		gfx->pop_clipping(ds);
 	} else {
-		if (!origin) {
-			gfx->draw_box(ds, x, y, w, h, config_bg_win_color);
-			ret |= 1;
-		}
+		gfx->draw_box(ds, x, y, w, h, config_bg_win_color);
+		ret |= 1;
 	}
 	return ret;
 }
 
 
-static void draw_shadow(struct gfx_ds *ds, int x, int y, int w, int h)
+/**
+ * Calculate alpha values of one line of the drop shadow
+ *
+ * The slices of the shadow image are placed like they were drawn
+ * by 'draw_slice'. The corners are used as they are, the middle
+ * line and column are stretched along the window borders.
+ */
+static void shadow_line(u8 *dst, int line, int w, int h)
 {
 	int sw2 = shadow_w >> 1, sh2 = shadow_h >> 1;
+	int i, j, x;
+
+	/* x, y, w, h, sx, sy, sw, sh of each slice within the shadow */
+	const int slice[10][8] = {
+		{ 0, 0, sw2, shadow_top, 0, 0, sw2, shadow_top },
+		{ 0, shadow_top, shadow_left, sh2 - shadow_top, 0, 0, shadow_left, sh2 - shadow_top },
+		{ sw2, 0, w - sw2*2, shadow_top, sw2, 0, 1, shadow_top },
+		{ w - sw2, 0, sw2, shadow_top, sw2 + 1, 0, sw2, shadow_top },
+		{ w - shadow_right, shadow_top, shadow_right, sh2 - shadow_top,
+		  shadow_w - shadow_right - 1, 0, shadow_right, sh2 - shadow_top },
+		{ 0, sh2, shadow_left, h - sh2*2, 0, sh2, shadow_left, 1 },
+		{ w - shadow_right, sh2, shadow_right, h - sh2*2, shadow_w - shadow_right - 1, sh2, shadow_right, 1 },
+		{ 0, h - sh2, sw2, sh2, 0, sh2 + 1, sw2, sh2 },
+		{ sw2, h - sh2, w - sw2*2, sh2, sw2 + 1, sh2 + 1, 1, sh2 },
+		{ w - sw2, h - sh2, sw2, sh2, sw2 + 1, sh2 + 1, sw2, sh2 },
+	};
+
+	memset(dst, 0, w);
+	for (i = 0; i < 10; i++) {
+		const int *s = slice[i];
+		int sy;
+
+		if (line < s[1] || line >= s[1] + s[3] || s[2] <= 0) continue;
+		sy = s[5] + (line - s[1])*s[7]/s[3];
+
+		for (j = 0; j < s[2]; j++) {
+			int a = gfx_alpha(shadow_img[sy*shadow_w + s[4] + j*s[6]/s[2]]);
+			x = s[0] + j;
+			if (x < 0 || x >= w) continue;
+
+			/* slices of very small windows overlap */
+			dst[x] = dst[x] + a - dst[x]*a/255;
+		}
+	}
+}
+
+
+/**
+ * Run-length encode line of alpha values
+ *
+ * \param dst  destination buffer or NULL to only count the values
+ * \return     number of u16 values of the encoded runs
+ */
+static int encode_runs(u16 *dst, const u8 *alpha, int w)
+{
+	int i, len, n = 0;
+
+	for (i = 0; i < w; i += len) {
+		for (len = 1; i + len < w && alpha[i + len] == alpha[i]; len++);
+		if (dst) {
+			dst[n]     = len;
+			dst[n + 1] = alpha[i];
+		}
+		n += 2;
+	}
+	return n;
+}
+
+
+/**
+ * Build run-length encoded drop shadow for the given window size
+ *
+ * The lines along the left and right border are all equal, so the
+ * mask size does not depend on the window height.
+ *
+ * \param dst  destination buffer or NULL to only count the values
+ * \return     number of u16 values of the mask
+ */
+static int encode_shadow(u16 *dst, u8 *line, u8 *prev, int w, int h)
+{
+	int sh2 = shadow_h >> 1;
+	int y, next, n = 0, runs, prev_hdr = -1;
+
+	for (y = 0; y < h; y = next) {
+		next = (y >= sh2 && y < h - sh2) ? h - sh2 : y + 1;
+		shadow_line(line, y, w, h);
+
+		/* extend previous row if the line is equal */
+		if (prev_hdr >= 0 && !memcmp(line, prev, w)) {
+			if (dst) dst[prev_hdr] += next - y;
+			continue;
+		}
+		memcpy(prev, line, w);
+
+		runs = encode_runs(dst ? dst + n + 2 : NULL, line, w);
+		if (dst) {
+			dst[n]     = next - y;
+			dst[n + 1] = runs/2;
+		}
+		prev_hdr = n;
+		n += 2 + runs;
+	}
+	if (dst) dst[n] = 0;
+	return n + 1;
+}
+
+
+/**
+ * Return drop shadow mask of the window, rebuild it if the size changed
+ */
+static u16 *get_shadow_mask(WINDOW *w)
+{
+	int mw = w->wd->w, mh = w->wd->h;
+	u8 *line;
+
+	if (w->wind->shadow_mask && w->wind->mask_w == mw && w->wind->mask_h == mh)
+		return w->wind->shadow_mask;
+
+	free(w->wind->shadow_mask);
+	w->wind->shadow_mask = NULL;
+	if (mw <= 0 || mh <= 0) return NULL;
+
+	if (!(line = malloc(mw*2))) return NULL;
+	w->wind->shadow_mask = malloc(encode_shadow(NULL, line, line + mw, mw, mh)*sizeof(u16));
+	if (w->wind->shadow_mask) {
+		encode_shadow(w->wind->shadow_mask, line, line + mw, mw, mh);
+		w->wind->mask_w = mw;
+		w->wind->mask_h = mh;
+	}
+	free(line);
+	return w->wind->shadow_mask;
+}
+
 
-	/* top left */
-	gfx->draw_slice(ds, x, y, sw2, shadow_top, 0, 0, sw2, shadow_top, shadow, 255);
-	gfx->draw_slice(ds, x, y + shadow_top, shadow_left, sh2 - shadow_top,
-	                    0, 0, shadow_left, sh2 - shadow_top, shadow, 255);
-
-	/* top */
-	gfx->draw_slice(ds, x + sw2, y, w - sw2*2, shadow_top,
-	                    sw2, 0, 1, shadow_top, shadow, 255);
-	/* top right */
-	gfx->draw_slice(ds, x + w - sw2, y, sw2, shadow_top,
-	                    sw2 + 1, 0, sw2, shadow_top, shadow, 255);
-	gfx->draw_slice(ds, x + w - shadow_right, y + shadow_top, shadow_right, sh2 - shadow_top,
-	                    shadow_w - shadow_right - 1, 0, shadow_right, sh2 - shadow_top, shadow, 255);
-
-	/* left */
-	gfx->draw_slice(ds, x, y + sh2, shadow_left, h - sh2*2,
-	                    0, sh2, shadow_left, 1, shadow, 255);
-	/* right */
-	gfx->draw_slice(ds, x + w - shadow_right, y + sh2, shadow_right, h - sh2*2,
-	                    shadow_w - shadow_right - 1, sh2, shadow_right, 1, shadow, 255);
-	/* bottom left */
-	gfx->draw_slice(ds, x, y + h - sh2, sw2, sh2,
-	                    0, sh2 + 1, sw2, sh2, shadow, 255);
-	/* bottom */
-	gfx->draw_slice(ds, x + sw2, y + h - sh2, w - sw2*2, sh2,
-	                    sw2 + 1, sh2 + 1, 1, sh2, shadow, 255);
-	/* bottom right */
-	gfx->draw_slice(ds, x + w - sw2, y + h - sh2, sw2, sh2,
-	                    sw2 + 1, sh2 + 1, sw2, sh2, shadow, 255);
+static void draw_shadow(WINDOW *w, struct gfx_ds *ds, int x, int y)
+{
+	u16 *mask = get_shadow_mask(w);
+
+	if (mask) gfx->draw_mask(ds, x, y, mask, GFX_RGBA(0, 0, 0, 255));
 }
 
 
 extern int transparency_depth;  /* from screen.c */
 
-static int win_draw(WINDOW *w, struct gfx_ds *ds, int x, int y, WIDGET *origin)
+/**
+ * Draw background of the shadow area within the current clipping area
+ *
+ * Windows are drawn piecewise, so most pieces touch only a small part
+ * of the shadow.
+ */
+static int drawbehind_clipped(WINDOW *w, struct gfx_ds *ds, int x, int y,
+                              int bx, int by, int bw, int bh)
+{
+	int ox  = w->wd->x + x, oy = w->wd->y + y;
+	int cx1 = gfx->get_clip_x(ds);
+	int cy1 = gfx->get_clip_y(ds);
+	int x1  = MAX(ox + bx, cx1);
+	int y1  = MAX(oy + by, cy1);
+	int x2  = MIN(ox + bx + bw - 1, cx1 + gfx->get_clip_w(ds) - 1);
+	int y2  = MIN(oy + by + bh - 1, cy1 + gfx->get_clip_h(ds) - 1);
+
+	if (x1 > x2 || y1 > y2) return 0;
+	return w->gen->drawbehind(w, w, x1 - ox, y1 - oy, x2 - x1 + 1, y2 - y1 + 1);
+}
+
+
+static int win_draw(WINDOW *w, struct gfx_ds *ds, int x, int y)
 {
 	int x1, y1, x2, y2;
 	int cx1 = gfx->get_clip_x(ds);
@@ -476,17 +549,13 @@ static int win_draw(WINDOW *w, struct gfx_ds *ds, int x, int y, WIDGET *origin)
 	int ret = 0;
 	WIDGET *cw;
 
-	/* we hit the origin, acknowledge visibility request */
-	if (origin == w) return 1;
-
 	/* draw window content */
 	cw = w->wind->content;
 
 	/* for windows with no or non-concealing content we need to draw a background */
 	if (!cw || (cw && !(cw->wd->flags & WID_FLAGS_CONCEALING))) {
 		ret |= w->gen->draw_bg(w, ds, win_get_workx(w), win_get_worky(w),
-		                              win_get_workw(w), win_get_workh(w),
-		                              origin, 0);
+		                              win_get_workw(w), win_get_workh(w), 0);
 	}
 
 	if (config_dropshadows) {
@@ -503,13 +572,13 @@ static int win_draw(WINDOW *w, struct gfx_ds *ds, int x, int y, WIDGET *origin)
 
 			/* draw shadow background */
 			transparency_depth--;
-			sret |= w->gen->drawbehind(w, w, 0, 0, w->wd->w, shadow_top, origin);
-			sret |= w->gen->drawbehind(w, w, 0, shadow_top, shadow_left, w->wd->h - shadow_top - shadow_bottom, origin);
-			sret |= w->gen->drawbehind(w, w, w->wd->w - shadow_right, shadow_top, shadow_left, w->wd->h - shadow_top - shadow_bottom, origin);
-			sret |= w->gen->drawbehind(w, w, 0, w->wd->h - shadow_bottom, w->wd->w, shadow_bottom, origin);
+			sret |= drawbehind_clipped(w, ds, x, y, 0, 0, w->wd->w, shadow_top);
+			sret |= drawbehind_clipped(w, ds, x, y, 0, shadow_top, shadow_left, w->wd->h - shadow_top - shadow_bottom);
+			sret |= drawbehind_clipped(w, ds, x, y, w->wd->w - shadow_right, shadow_top, shadow_right, w->wd->h - shadow_top - shadow_bottom);
+			sret |= drawbehind_clipped(w, ds, x, y, 0, w->wd->h - shadow_bottom, w->wd->w, shadow_bottom);
 			transparency_depth++;
 
-			if (sret) draw_shadow(ds, w->wd->x + x, w->wd->y + y, w->wd->w, w->wd->h);
+			if (sret) draw_shadow(w, ds, w->wd->x + x, w->wd->y + y);
 			ret |= sret;
 		}
 	}
@@ -519,20 +588,26 @@ static int win_draw(WINDOW *w, struct gfx_ds *ds, int x, int y, WIDGET *origin)
 		y1 = cw->gen->get_y(cw) + w->wd->y + y;
 		x2 = x1 + cw->gen->get_w(cw) - 1;
 		y2 = y1 + cw->gen->get_h(cw) - 1;
-		gfx->push_clipping(ds, x1, y1, x2 - x1 + 1, y2 - y1 + 1);
-		ret |= cw->gen->draw(cw, ds, w->wd->x + x, w->wd->y + y, origin);
-		gfx->pop_clipping(ds);
+		if ((x1 <= cx2) && (y1 <= cy2) && (x2 >= cx1) && (y2 >= cy1)) {
+			gfx->push_clipping(ds, x1, y1, x2 - x1 + 1, y2 - y1 + 1);
+			ret |= cw->gen->draw(cw, ds, w->wd->x + x, w->wd->y + y);
+			gfx->pop_clipping(ds);
+		}
 	}
 
-	/* draw window elements */
+	/* draw window elements that intersect the clipping area */
 	cw = w->wind->elem;
 	while (cw) {
 		x1 = cw->gen->get_x(cw) + w->wd->x + x;
 		y1 = cw->gen->get_y(cw) + w->wd->y + y;
 		x2 = x1 + cw->gen->get_w(cw) - 1;
 		y2 = y1 + cw->gen->get_h(cw) - 1;
+		if ((x1 > cx2) || (y1 > cy2) || (x2 < cx1) || (y2 < cy1)) {
+			cw = cw->gen->get_next(cw);
+			continue;
+		}
 		gfx->push_clipping(ds, x1, y1, x2 - x1 + 1, y2 - y1 + 1);
-		ret |= cw->gen->draw(cw, ds, w->wd->x + x, w->wd->y + y, origin);
+		ret |= cw->gen->draw(cw, ds, w->wd->x + x, w->wd->y + y);
 		gfx->pop_clipping(ds);
 		cw = cw->gen->get_next(cw);
 	}
@@ -590,6 +665,7 @@ static void win_update(WINDOW *w)
 			if (w->wind->uy != NOARG) w->wd->y = w->wind->uy;
 			if (w->wind->uw != NOARG) w->wd->w = w->wind->uw;
 			if (w->wind->uh != NOARG) w->wd->h = w->wind->uh;
+			widman->invalidate_geometry();
 		}
 	}
 
@@ -642,8 +718,6 @@ static WIDGET *win_find(WINDOW *w, int x, int y)
 
 static void win_handle_event(WIDGET *w, EVENT *ev, WIDGET *from)
 {
-	struct binding *cb;
-
 	/*
 	 * If we get an event for changing the keyboard focus,
 	 * the keyboard focus went already through all children
@@ -657,9 +731,7 @@ static void win_handle_event(WIDGET *w, EVENT *ev, WIDGET *from)
 	}
 
 	/* check bindings */
-	for (cb = w->wd->bindings; cb; cb = cb->next)
-		if (cb->ev_type == ev->type)
-			msg->send_input_event(w->wd->app_id, ev, cb->msg);
+	w->gen->send_input((WIDGET *)w, ev);
 
 	if ((ev->type != EVENT_PRESS) || (ev->code != MTK_BTN_LEFT)) return;
 
@@ -684,6 +756,7 @@ static void win_free_data(WINDOW *w)
 	remove_kfocus(w);
 	destroy_win_elements(w->wind->elem);
 	destroy_win_elements(w->wind->content);
+	free(w->wind->shadow_mask);
 }
 
 
@@ -775,13 +848,11 @@ static void win_close(WINDOW *w)
 static void win_top(WINDOW *w)
 {
 	SCREEN *scr;
-	char *message;
 
 	scr = (SCREEN *)w->gen->get_parent(w);
 	if (scr) scr->scr->top(scr, w);;
 
-	message = w->gen->get_bind_msg(w, "top");
-	if (message) msg->send_action_event(w->wd->app_id, "top", message);
+	w->gen->send_action((WIDGET *)w, MTK_BIND_TOP, "top");
 
 	userstate->set_active_window(w, 0);
 }
@@ -978,7 +1049,7 @@ static void win_handle_close(WINDOW *w, WIDGET *cw) {
 	if (!cw) return;
 
 	/* handle close only when binding is set */
-	if (!w->gen->get_bind_msg((WIDGET *)w, "close")) return;
+	if (!w->gen->is_bound((WIDGET *)w, MTK_BIND_CLOSE)) return;
 
 	cw->gen->set_state(cw, 1);
 	cw->gen->update(cw);
@@ -1124,6 +1195,7 @@ static WINDOW *create(void)
 	new->wd->h = 128;
 	new->wd->max_w = 3000;
 	new->wd->max_h = 3000;
+	new->wd->flags |= WID_FLAGS_TILING;
 
 	/* set window specific attributes */
 	new->wind->flags    =  WIN_FLAGS_BACKGROUND;
@@ -1192,7 +1264,6 @@ int init_window(struct mtk_services *d)
 	script    = d->get_module("Script 1.0");
 	winlayout = d->get_module("WinLayout 1.0");
 	appman    = d->get_module("ApplicationManager 1.0");
-	msg       = d->get_module("Messenger 1.0");
 
 	/* define general widget functions */
 	widman->default_widget_methods(&gen_methods);
@@ -1216,8 +1287,8 @@ int init_window(struct mtk_services *d)
 	build_script_lang();
 
 	/* init drop shadow */
-	shadow = gfx->alloc_img(shadow_w, shadow_h, GFX_IMG_TYPE_RGBA32);
-	gen_shadow(gfx->map(shadow), shadow_w, shadow_h, shadow_w >> 1, shadow_h >> 1);
+	shadow_w = shadow_img_w;
+	shadow_h = shadow_img_h;
 
 //	if (config_dropshadows) {
 		shadow_left   = services.shadow_left;
@@ -0,0 +1,233 @@
+/*
+ * \brief   Convert truetype fonts to Unicode trivial font format
+ *
+ * In contrast to tff files, utff files are not limited to 256
+ * characters. Only the glyphs of the requested Unicode ranges
+ * are stored. Each glyph image is run-length encoded and gets
+ * decompressed by MTK when it is drawn.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+typedef unsigned char  u8;
+typedef unsigned int   u32;
+
+#define UTFF_MAGIC 0x46465455
+
+struct glyph {
+	u32 ucs;
+	int w, top, rows, left, pitch;
+	u8 *bitmap;
+};
+
+/* Unicode ranges used if no range is specified at the command line */
+static const char *default_ranges[] = {
+	"0x20-0x7e",     /* Basic Latin         */
+	"0xa0-0x24f",    /* Latin-1, Latin Ext. */
+	"0x370-0x3ff",   /* Greek and Coptic    */
+	"0x400-0x4ff",   /* Cyrillic            */
+};
+
+static struct glyph *glyphs;
+static int num_glyphs;
+
+
+static int max(int a, int b) { return a > b ? a : b; }
+
+
+/**
+ * Write 32bit value in intel byte order
+ */
+static void put_u32(FILE *f, u32 v)
+{
+	fputc(v & 0xff, f);
+	fputc((v >> 8) & 0xff, f);
+	fputc((v >> 16) & 0xff, f);
+	fputc((v >> 24) & 0xff, f);
+}
+
+
+/**
+ * Render all characters of a range "<first>-<last>" that exist in the font
+ */
+static int add_range(FT_Face face, const char *range)
+{
+	FT_GlyphSlot slot = face->glyph;
+	char *end;
+	u32 ucs, first, last;
+
+	first = strtoul(range, &end, 0);
+	last  = (*end == '-') ? strtoul(end + 1, NULL, 0) : first;
+
+	for (ucs = first; ucs <= last; ucs++) {
+		struct glyph *g;
+		int i;
+
+		/* skip characters that are missing or already present */
+		if (!FT_Get_Char_Index(face, ucs)) continue;
+		for (i = 0; i < num_glyphs && glyphs[i].ucs != ucs; i++);
+		if (i < num_glyphs) continue;
+
+		if (FT_Load_Char(face, ucs, FT_LOAD_RENDER | FT_LOAD_TARGET_LIGHT))
+			continue;
+
+		glyphs = realloc(glyphs, (num_glyphs + 1)*sizeof(struct glyph));
+		if (!glyphs) {
+			printf("Error: out of memory\n");
+			return -1;
+		}
+		g = &glyphs[num_glyphs++];
+
+		g->ucs    = ucs;
+		g->w      = max(slot->bitmap.width, slot->advance.x >> 6);
+		g->top    = slot->bitmap_top;
+		g->rows   = slot->bitmap.rows;
+		g->left   = slot->bitmap_left;
+		g->pitch  = slot->bitmap.width;
+		g->bitmap = malloc(g->rows*g->pitch + 1);
+		for (i = 0; i < g->rows; i++)
+			memcpy(g->bitmap + i*g->pitch, slot->bitmap.buffer + i*slot->bitmap.pitch, g->pitch);
+	}
+	return 0;
+}
+
+
+static int cmp_glyph(const void *a, const void *b)
+{
+	u32 ua = ((struct glyph *)a)->ucs, ub = ((struct glyph *)b)->ucs;
+	return ua < ub ? -1 : ua > ub;
+}
+
+
+/**
+ * Render glyph into an image of w*img_h pixels
+ *
+ * The glyph is positioned like done by ttf2tff.
+ */
+static void draw_glyph(struct glyph *g, u8 *dst, int img_h, int base)
+{
+	int x = 0, y, w = g->pitch, sx = 0, j;
+
+	if (w < g->w) x += (g->w - w) >> 1;
+	if (g->left < 0) {
+		sx -= g->left;
+		w  += g->left;
+	}
+	y = base - g->top;
+	for (j = 0; j < g->rows; j++)
+		if (y + j >= 0 && y + j < img_h && w > 0)
+			memcpy(dst + (y + j)*g->w + x, g->bitmap + j*g->pitch + sx, w);
+}
+
+
+/**
+ * Main program
+ */
+int main(int argc, char **argv)
+{
+	static FT_Library library;
+	static FT_Face    face;
+	int    img_h = 0, img_l = 0, max_w = 0;
+	int    res, i, j, n;
+	u32    offset;
+	u8   **rle;
+	int   *rle_len;
+	FILE  *f;
+
+	if (argc < 4) {
+		printf("\nConvert truetype fonts to Unicode trivial font format\n");
+		printf("\nusage:\n\n  ttf2utff <source-ttf> <points> <destination-utff> [<first>-<last> ...]\n\n");
+		return 0;
+	}
+
+	if ((res = FT_Init_FreeType(&library))) {
+		printf("Error: FT_Init_FreeType returned %d\n", res);
+		return -1;
+	}
+
+	if ((res = FT_New_Face(library, argv[1], 0, &face))) {
+		printf("Error: FT_New_Face returned %d - invalid font file?\n", res);
+		return -1;
+	}
+
+	if ((res = FT_Set_Char_Size(face, 0, atof(argv[2])*64, 0, 0))) {
+		printf("Error: FT_Set_Char_Size returned %d\n", res);
+		return -1;
+	}
+
+	if (argc > 4) {
+		for (i = 4; i < argc; i++)
+			if (add_range(face, argv[i])) return -1;
+	} else {
+		for (i = 0; i < sizeof(default_ranges)/sizeof(default_ranges[0]); i++)
+			if (add_range(face, default_ranges[i])) return -1;
+	}
+
+	if (!num_glyphs) {
+		printf("Error: font contains none of the requested characters\n");
+		return -1;
+	}
+	qsort(glyphs, num_glyphs, sizeof(struct glyph), cmp_glyph);
+
+	/* calculate common glyph height */
+	for (i = 0; i < num_glyphs; i++) {
+		img_h = max(img_h, glyphs[i].rows);
+		img_l = max(img_l, glyphs[i].rows - glyphs[i].top);
+		max_w = max(max_w, glyphs[i].w);
+	}
+	printf("%d glyphs, height %d (lowline at -%d), max width %d\n",
+	       num_glyphs, img_h + img_l, img_l, max_w);
+
+	/* run-length encode glyph images */
+	rle     = malloc(num_glyphs*sizeof(u8 *));
+	rle_len = malloc(num_glyphs*sizeof(int));
+	for (i = 0; i < num_glyphs; i++) {
+		int size = glyphs[i].w*(img_h + img_l);
+		u8 *img  = calloc(1, size + 1);
+
+		draw_glyph(&glyphs[i], img, img_h + img_l, img_h);
+
+		rle[i] = malloc(2*size + 2);
+		for (j = 0, n = 0; j < size; n += 2) {
+			int run = 1;
+			while (j + run < size && run < 255 && img[j + run] == img[j]) run++;
+			rle[i][n]     = run;
+			rle[i][n + 1] = img[j];
+			j += run;
+		}
+		rle_len[i] = n;
+		free(img);
+	}
+
+	/* write utff file */
+	if (!(f = fopen(argv[3], "wb"))) {
+		printf("Error: Could not open file %s for writing\n", argv[3]);
+		return -1;
+	}
+
+	put_u32(f, UTFF_MAGIC);
+	put_u32(f, num_glyphs);
+	put_u32(f, img_h + img_l);
+	put_u32(f, max_w);
+
+	offset = 16 + 12*num_glyphs;
+	for (i = 0; i < num_glyphs; i++) {
+		put_u32(f, glyphs[i].ucs);
+		put_u32(f, glyphs[i].w);
+		put_u32(f, offset);
+		offset += rle_len[i];
+	}
+	for (i = 0; i < num_glyphs; i++)
+		fwrite(rle[i], 1, rle_len[i], f);
+
+	if (ferror(f) | fclose(f)) {
+		printf("Error: Write error\n");
+		return -1;
+	}
+	printf("wrote %d bytes\n", (int)offset);
+	return 0;
+}